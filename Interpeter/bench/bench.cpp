@@ -0,0 +1,363 @@
+// Workload benchmarks: generates representative scripts, runs each one
+// several times with --stats=json and reports median/p95 per phase,
+// optionally against a saved JSON baseline.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Timings = std::map<std::string, std::map<std::string, double>>;
+
+struct Workload {
+	std::string name;
+	std::string source;
+};
+
+static std::string workload_loop(const std::string& body, const std::string& decl, int n) {
+	return "int main() {\n" + decl + "\tfor (int i = 0; i < " + std::to_string(n) + "; i++) {\n" + body + "\t}\n\treturn 0;\n}\n";
+}
+
+// Fills int a[], b[] and double x[], y[] of size n, then runs body `repeat`
+// times; used to pit each array builtin against the loop it replaces.
+static std::string array_workload(const std::string& body, int n, int repeat) {
+	auto size = std::to_string(n);
+	return "int main() {\n\tint a[" + size + "], b[" + size + "];\n\tdouble x[" + size + "], y[" + size + "];\n"
+		"\tfor (int i = 0; i < " + size + "; i++) {\n\t\ta[i] = i - 700;\n\t\tb[i] = 3 - i;\n\t\tx[i] = i * 0.5;\n\t\ty[i] = 1.0 - i;\n\t}\n"
+		"\tint s = 0;\n\tdouble d = 0.0;\n\tfor (int r = 0; r < " + std::to_string(repeat) + "; r++) {\n" + body + "\t}\n\treturn 0;\n}\n";
+}
+
+static std::vector<Workload> workloads() {
+	std::vector<Workload> list;
+
+	list.push_back({"int_loop", workload_loop("\t\ts = s + i * 3 - 1;\n", "\tint s = 0;\n", 30000)});
+
+	list.push_back({"double_arith", workload_loop("\t\tx = x * 1.0001 + 0.5 / y;\n\t\ty += 0.25;\n", "\tdouble x = 1.5;\n\tdouble y = 1.0;\n", 20000)});
+
+	list.push_back({"recursion",
+		"int depth(int n) {\n\treturn n == 0 ? 0 : 1 + depth(n - 1);\n}\n\n"
+		"int fib(int n) {\n\treturn n < 2 ? n : fib(n - 1) + fib(n - 2);\n}\n\n"
+		"int main() {\n\tint s = 0;\n\tfor (int i = 0; i < 20; i++) {\n\t\ts += depth(500);\n\t}\n\ts += fib(18);\n\treturn 0;\n}\n"});
+
+	list.push_back({"string_concat", workload_loop("\t\ts += \"abc\";\n\t\tt = t + \"x\";\n", "\tstring s = \"\";\n\tstring t = \"\";\n", 10000)});
+
+	// 100 MB built from 1000-byte pieces
+	std::string piece = "\tstring s = \"\";\n\tstring piece = \"\";\n\tfor (int j = 0; j < 100; j++) {\n\t\tpiece += \"0123456789\";\n\t}\n";
+	list.push_back({"string_append", workload_loop("\t\ts += piece;\n", piece, 100000)});
+	list.push_back({"string_rebuild", workload_loop("\t\ts = s + piece;\n", piece, 100000)});
+	auto join = workload_loop("\t\tpush(parts, piece);\n", piece + "\tstring parts[];\n", 100000);
+	join.insert(join.rfind("\treturn 0;"), "\ts = join(parts, \"\");\n");
+	list.push_back({"string_join", join});
+
+	// 20 MB of words built by doubling; the searches scan all of it
+	std::string text = "\tstring s = \"the quick brown fox \";\n\tfor (int j = 0; j < 20; j++) {\n\t\ts += s;\n\t}\n\tstring t = s;\n\tint c = 0;\n";
+	list.push_back({"string_find", workload_loop("\t\tc += find(s, \"lazy dog\");\n", text, 20)});
+	list.push_back({"string_count", workload_loop("\t\tc += count(s, \"fox\");\n", text, 20)});
+	list.push_back({"string_replace", workload_loop("\t\tt = replace(s, \"quick\", \"slow\");\n", text, 5)});
+	list.push_back({"string_split", workload_loop("\t\tc += len(split(s, \" \"));\n", text, 2)});
+	list.push_back({"string_equal", workload_loop("\t\tif (s == t && ends_with(s, \"fox \")) c += 1;\n", text, 20)});
+
+	// a 7 MB log of 131072 lines, written by the script itself; string
+	// literals have no escapes, so the newline is a literal one
+	auto log = "\"" + (std::filesystem::temp_directory_path() / "bench-lines.log").string() + "\"";
+	auto logged = [&log](const std::string& body) {
+		return "int main() {\n\tstring s = \"2024-05-01 12:00:00 INFO [worker-7] request id=4411 took 12ms\n\";\n"
+			"\tfor (int j = 0; j < 17; j++) {\n\t\ts += s;\n\t}\n\twrite_file(" + log + ", s);\n\tint c = 0;\n" + body + "\treturn 0;\n}\n";
+	};
+	list.push_back({"file_lines", logged("\tfor (string line : lines(" + log + ")) {\n\t\tc += 1;\n\t}\n")});
+	list.push_back({"file_read", logged("\tfor (int r = 0; r < 20; r++) {\n\t\tc += len(read_file(" + log + "));\n\t}\n")});
+
+	// the pattern literal is compiled once for the whole loop
+	list.push_back({"regex_filter", workload_loop("\t\tif (regex_search(line, \"took \\d{4,}ms\")) c += 1;\n",
+		"\tstring line = \"2024-05-01 12:00:00 WARN [worker-7] request id=4411 took 1234ms\";\n\tint c = 0;\n", 20000)});
+
+	list.push_back({"branching", workload_loop(
+		"\t\tif (i < 100) {\n\t\t\ta += 1;\n\t\t} else if (i < 5000) {\n\t\t\tb += 2;\n\t\t} else if (i > 20000 && a > 0) {\n\t\t\ta -= 1;\n\t\t} else {\n\t\t\tb = i > 15000 ? b - 1 : b + 1;\n\t\t}\n",
+		"\tint a = 0;\n\tint b = 0;\n", 30000)});
+
+	// a state machine over 16 states, dispatched by an if chain and by a switch
+	std::string chain, cases;
+	for (int k = 0; k < 16; k++) {
+		auto state = std::to_string(k), add = std::to_string(k + 1);
+		chain += std::string(k ? "\t\telse if" : "\t\tif") + " (op == " + state + ") {\n\t\t\tacc += " + add + ";\n\t\t}\n";
+		cases += "\t\t\tcase " + state + ": acc += " + add + "; break;\n";
+	}
+	std::string next = "\t\tif (op >= 9) {\n\t\t\top = op - 16;\n\t\t}\n\t\top = op + 7;\n";
+	list.push_back({"dispatch_if", workload_loop(next + chain, "\tint acc = 0;\n\tint op = 0;\n", 20000)});
+	list.push_back({"dispatch_switch", workload_loop(next + "\t\tswitch (op) {\n" + cases + "\t\t}\n", "\tint acc = 0;\n\tint op = 0;\n", 20000)});
+
+	list.push_back({"calls",
+		"namespace M {\n\tint inc(int x) {\n\t\treturn x + 1;\n\t}\n\n\tdouble half(double x) {\n\t\treturn x / 2.0;\n\t}\n}\n\n" +
+		workload_loop("\t\ts = M::inc(s);\n\t\td = M::half(d) + 1.0;\n", "\tint s = 0;\n\tdouble d = 0.0;\n", 10000)});
+	// the same calls into C; the difference to "calls" is the overhead per
+	// invocation saved over a script function
+	list.push_back({"native_calls",
+		"extern \"C\" int abs(int x);\nextern \"C\" \"libm.so.6\" double fabs(double x);\n\n" +
+		workload_loop("\t\ts = abs(s) + 1;\n\t\td = fabs(d) / 2.0 + 1.0;\n", "\tint s = 0;\n\tdouble d = 0.0;\n", 10000)});
+
+	list.push_back({"sum_loop", array_workload("\t\tfor (int i = 0; i < 2000; i++) {\n\t\t\ts += a[i];\n\t\t\td += x[i];\n\t\t}\n", 2000, 10)});
+	list.push_back({"sum_builtin", array_workload("\t\ts += sum(a);\n\t\td += sum(x);\n", 2000, 10)});
+
+	list.push_back({"dot_loop", array_workload("\t\tfor (int i = 0; i < 2000; i++) {\n\t\t\ts += a[i] * b[i];\n\t\t\td += x[i] * y[i];\n\t\t}\n", 2000, 10)});
+	list.push_back({"dot_builtin", array_workload("\t\ts += dot(a, b);\n\t\td += dot(x, y);\n", 2000, 10)});
+
+	list.push_back({"minmax_loop", array_workload("\t\tfor (int i = 0; i < 2000; i++) {\n\t\t\tif (a[i] > s) s = a[i];\n\t\t\tif (x[i] < d) d = x[i];\n\t\t}\n", 2000, 10)});
+	list.push_back({"minmax_builtin", array_workload("\t\ts = max(a);\n\t\td = min(x);\n", 2000, 10)});
+
+	list.push_back({"scale_loop", array_workload("\t\tfor (int i = 0; i < 2000; i++) {\n\t\t\ta[i] *= -1;\n\t\t\tx[i] *= 0.5;\n\t\t}\n", 2000, 10)});
+	list.push_back({"scale_builtin", array_workload("\t\tscale(a, -1);\n\t\tscale(x, 0.5);\n", 2000, 10)});
+
+	list.push_back({"axpy_loop", array_workload("\t\tfor (int i = 0; i < 2000; i++) {\n\t\t\tb[i] += 2 * a[i];\n\t\t\ty[i] += 0.5 * x[i];\n\t\t}\n", 2000, 10)});
+	list.push_back({"axpy_builtin", array_workload("\t\taxpy(2, a, b);\n\t\taxpy(0.5, x, y);\n", 2000, 10)});
+
+	// a pseudo-random fill, since the language has no modulo; filling is slow,
+	// so one fill is sorted many times over
+	auto shuffled = [](const std::string& type, const std::string& sort, int n, int repeat) {
+		return "int main() {\n\t" + type + " a[], b[];\n\tint seed = 7;\n\tfor (int i = 0; i < " + std::to_string(n) + "; i++) {\n"
+			"\t\tseed = seed * 1103515245 + 12345;\n\t\tpush(a, seed / 65536);\n\t}\n"
+			"\tfor (int r = 0; r < " + std::to_string(repeat) + "; r++) {\n\t\tb = a;\n\t\t" + sort + "(b);\n\t}\n\treturn 0;\n}\n";
+	};
+	list.push_back({"sort_int", shuffled("int", "sort", 70000, 100)});
+	list.push_back({"sort_double", shuffled("double", "sort", 70000, 100)});
+	list.push_back({"stable_sort", shuffled("double", "stable_sort", 70000, 100)});
+
+	list.push_back({"parallel_loop", "int main() {\n\tint s = 0;\n\tdouble d = 0.0;\n\tint a[40000];\n"
+		"\tparallel for (int i = 0; i < 40000; i++) {\n\t\tint x = i * 3 - 1;\n\t\ta[i] = x / 7;\n\t\ts += x;\n\t\td += x * 0.5;\n\t}\n\treturn 0;\n}\n"});
+
+	// 10^5 small tasks, spawned eight at a time since futures cannot be
+	// kept in an array
+	std::string spawns, awaits;
+	for (int k = 0; k < 8; k++) {
+		spawns += "\t\tfuture<int> h" + std::to_string(k) + " = spawn work(i + " + std::to_string(k) + ");\n";
+		awaits += std::string(k ? " + " : "") + "await h" + std::to_string(k);
+	}
+	list.push_back({"spawn_tasks", "int work(int x) {\n\treturn x * 3 - 1;\n}\n\nint main() {\n\tint s = 0;\n"
+		"\tfor (int i = 0; i < 100000; i += 8) {\n" + spawns + "\t\ts += " + awaits + ";\n\t}\n\treturn 0;\n}\n"});
+
+	list.push_back({"map_count", workload_loop("\t\tcounts[i / 3] += 1;\n\t\tif (contains(counts, i / 2)) found++;\n", "\tmap<int, int> counts;\n\tint found = 0;\n", 20000)});
+
+	std::string large;
+	for (int i = 0; i < 4000; i++) {
+		auto n = std::to_string(i);
+		large += "int f" + n + "(int a) {\n\tint b = a * 2 + " + n + ";\n\tif (b > 10) {\n\t\tb = b - 1;\n\t} else {\n\t\tb = b + 1;\n\t}\n\treturn b;\n}\n\n";
+	}
+	large += "int main() {\n\tint s = f0(1) + f3999(2);\n\treturn 0;\n}\n";
+	list.push_back({"large_source", large});
+
+	return list;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+static std::map<std::string, double> parse_phases(const std::string& json) {
+	std::map<std::string, double> phases;
+	for (std::size_t pos = 0; (pos = json.find("\"name\": \"", pos)) != std::string::npos;) {
+		pos += 9;
+		auto end = json.find('"', pos);
+		auto name = json.substr(pos, end - pos);
+		auto wall = json.find("\"wall_ms\": ", end);
+		if (wall == std::string::npos) break;
+		phases[name] = std::strtod(json.c_str() + wall + 11, nullptr);
+		pos = wall;
+	}
+	return phases;
+}
+
+static bool run(const std::string& interpreter, const std::string& script, int threads, std::map<std::string, double>& phases) {
+	std::string statsPath = script + ".stats", threadsFlag = "--threads=" + std::to_string(threads);
+	std::fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0) {
+		std::freopen("/dev/null", "w", stdout);
+		std::freopen(statsPath.c_str(), "w", stderr);
+		if (threads) execl(interpreter.c_str(), interpreter.c_str(), "--stats=json", threadsFlag.c_str(), script.c_str(), static_cast<char*>(nullptr));
+		else execl(interpreter.c_str(), interpreter.c_str(), "--stats=json", script.c_str(), static_cast<char*>(nullptr));
+		_exit(127);
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		return false;
+	}
+
+	std::ifstream in(statsPath);
+	std::stringstream json;
+	json << in.rdbuf();
+	phases = parse_phases(json.str());
+	double total = 0;
+	for (auto& [name, ms] : phases) total += ms;
+	phases["total"] = total;
+	return true;
+}
+
+static double percentile(std::vector<double> values, double p) {
+	std::sort(values.begin(), values.end());
+	auto index = static_cast<std::size_t>(p * (values.size() - 1) + 0.5);
+	return values[std::min(index, values.size() - 1)];
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+static Timings load_baseline(const std::string& path) {
+	Timings baseline;
+	std::ifstream in(path);
+	if (!in) return baseline;
+	std::stringstream buf;
+	buf << in.rdbuf();
+	auto json = buf.str();
+
+	// {"workload": {"phase": ms, ...}, ...}
+	std::size_t pos = json.find('{');
+	while ((pos = json.find('"', pos + 1)) != std::string::npos) {
+		auto end = json.find('"', pos + 1);
+		auto workload = json.substr(pos + 1, end - pos - 1);
+		auto close = json.find('}', end);
+		for (pos = json.find('"', end + 1); pos < close; pos = json.find('"', pos + 1)) {
+			end = json.find('"', pos + 1);
+			auto phase = json.substr(pos + 1, end - pos - 1);
+			auto colon = json.find(':', end);
+			baseline[workload][phase] = std::strtod(json.c_str() + colon + 1, nullptr);
+			pos = json.find_first_of(",}", colon);
+			if (json[pos] == '}') break;
+		}
+		pos = close;
+	}
+	return baseline;
+}
+
+static void save_baseline(const std::string& path, const Timings& medians) {
+	std::ofstream out(path);
+	out << "{\n";
+	for (auto it = medians.begin(); it != medians.end(); ++it) {
+		out << "  \"" << it->first << "\": {";
+		for (auto phase = it->second.begin(); phase != it->second.end(); ++phase) {
+			char value[32];
+			std::snprintf(value, sizeof(value), "%.3f", phase->second);
+			out << (phase == it->second.begin() ? "" : ", ") << "\"" << phase->first << "\": " << value;
+		}
+		out << "}" << (std::next(it) == medians.end() ? "\n" : ",\n");
+	}
+	out << "}\n";
+}
+
+static void usage(const char* name) {
+	std::cerr << "usage: " << name << " interpreter [--runs=N] [--only=workload,...] [--threads=N] [--baseline=file] [--save=file] [--threshold=percent] [--keep=dir]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		usage(argv[0]);
+		return 2;
+	}
+	std::string interpreter = argv[1], baselinePath, savePath, only, keep;
+	int runs = 5, maxThreads = 0;
+	double threshold = 10;
+	for (int i = 2; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.starts_with("--runs=")) runs = std::max(1, std::atoi(arg.c_str() + 7));
+		else if (arg.starts_with("--only=")) only = arg.substr(7);
+		else if (arg.starts_with("--baseline=")) baselinePath = arg.substr(11);
+		else if (arg.starts_with("--save=")) savePath = arg.substr(7);
+		else if (arg.starts_with("--threshold=")) threshold = std::atof(arg.c_str() + 12);
+		else if (arg.starts_with("--keep=")) keep = arg.substr(7);
+		else if (arg.starts_with("--threads=")) maxThreads = std::max(1, std::atoi(arg.c_str() + 10));
+		else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	std::string dir = keep;
+	if (dir.empty()) {
+		char tmp[] = "/tmp/interpreter-bench-XXXXXX";
+		if (!mkdtemp(tmp)) {
+			std::perror("mkdtemp");
+			return 2;
+		}
+		dir = tmp;
+	} else {
+		std::filesystem::create_directories(dir);
+	}
+
+	auto baseline = baselinePath.empty() ? Timings{} : load_baseline(baselinePath);
+	Timings medians;
+	int regressions = 0;
+
+	std::printf("%-14s %-10s %12s %12s %12s\n", "workload", "phase", "median ms", "p95 ms", "baseline");
+	// --threads=N runs each workload at 1, 2, 4, ... N threads as name@threads
+	std::vector<int> threadCounts = {0};
+	if (maxThreads) {
+		threadCounts.clear();
+		for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+		threadCounts.push_back(maxThreads);
+	}
+	std::vector<Workload> selected;
+	for (auto& workload : workloads()) {
+		if (!only.empty() && ("," + only + ",").find("," + workload.name + ",") == std::string::npos) continue;
+		for (int threads : threadCounts) {
+			selected.push_back({threads ? workload.name + "@" + std::to_string(threads) : workload.name, workload.source});
+		}
+	}
+
+	for (std::size_t w = 0; w < selected.size(); w++) {
+		auto& workload = selected[w];
+		int threads = threadCounts[w % threadCounts.size()];
+		auto script = dir + "/" + workload.name + ".cpp";
+		std::ofstream(script) << workload.source;
+
+		std::map<std::string, std::vector<double>> samples;
+		bool ok = true;
+		for (int i = 0; i < runs && ok; i++) {
+			std::map<std::string, double> phases;
+			ok = run(interpreter, script, threads, phases);
+			for (auto& [phase, ms] : phases) samples[phase].push_back(ms);
+		}
+		if (!ok) {
+			std::printf("%-14s FAILED (see %s.stats)\n", workload.name.c_str(), script.c_str());
+			regressions++;
+			continue;
+		}
+
+		for (auto& [phase, values] : samples) {
+			double median = percentile(values, 0.5), p95 = percentile(values, 0.95);
+			medians[workload.name][phase] = median;
+
+			std::string reference = "-";
+			const char* flag = "";
+			if (baseline.contains(workload.name) && baseline[workload.name].contains(phase)) {
+				double base = baseline[workload.name][phase];
+				char buf[32];
+				std::snprintf(buf, sizeof(buf), "%.3f", base);
+				reference = buf;
+				// sub-millisecond phases are too noisy to flag
+				if (median > base * (1 + threshold / 100) && median - base > 0.5) {
+					flag = "  REGRESSION";
+					regressions++;
+				}
+			}
+			std::printf("%-14s %-10s %12.3f %12.3f %12s%s\n", workload.name.c_str(), phase.c_str(), median, p95, reference.c_str(), flag);
+		}
+	}
+
+	if (!savePath.empty()) {
+		save_baseline(savePath, medians);
+		std::printf("baseline saved to %s\n", savePath.c_str());
+	}
+	if (keep.empty()) {
+		std::filesystem::remove_all(dir);
+	}
+	if (regressions) {
+		std::printf("%d regression(s)\n", regressions);
+		return 1;
+	}
+	return 0;
+}
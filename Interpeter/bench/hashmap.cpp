@@ -0,0 +1,51 @@
+// Microbenchmark for the table behind map<K,V>: inserts and looks up 10^7
+// keys in HashMap and in std::unordered_map, with int and string keys.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hashmap.hpp"
+
+template <typename Map, typename K>
+static void run(const char* name, const std::vector<K>& keys) {
+	auto start = std::chrono::steady_clock::now();
+	Map map;
+	for (auto& key : keys) map[key] += 1;
+	auto inserted = std::chrono::steady_clock::now();
+	long long found = 0;
+	for (auto& key : keys) found += map.find(key) != nullptr;
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<double, std::milli> insert = inserted - start, lookup = end - inserted;
+	std::printf("%-28s %10zu keys %10.1f ms insert %10.1f ms lookup %12.1f Mops/s\n", name, map.size(), insert.count(), lookup.count(),
+		2 * keys.size() / (insert + lookup).count() / 1000);
+	if (found != static_cast<long long>(keys.size())) std::abort();
+}
+
+// std::unordered_map with the same find() as HashMap
+template <typename K, typename V>
+struct StdMap : std::unordered_map<K, V> {
+	V* find(const K& key) {
+		auto it = std::unordered_map<K, V>::find(key);
+		return it == this->end() ? nullptr : &it->second;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	std::mt19937 rng(42);
+	std::vector<int> ints(n);
+	for (auto& key : ints) key = rng() % (n / 4);
+	std::vector<std::string> strings(n / 4);
+	for (auto& key : strings) key = "key" + std::to_string(rng() % (n / 16));
+
+	run<HashMap<int, int>>("HashMap<int, int>", ints);
+	run<StdMap<int, int>>("unordered_map<int, int>", ints);
+	run<HashMap<std::string, int>>("HashMap<string, int>", strings);
+	run<StdMap<std::string, int>>("unordered_map<string, int>", strings);
+	return 0;
+}
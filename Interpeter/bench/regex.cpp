@@ -0,0 +1,67 @@
+// Microbenchmark for the engine behind regex_match and regex_search: runs
+// log-filtering patterns over generated log lines with regex::Regex and
+// with std::regex, and checks that both count the same matching lines.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "regex.hpp"
+
+struct Case {
+	const char* name;
+	const char* pattern;
+	bool search, groups;
+};
+
+template <typename F>
+static void run(const char* engine, const Case& c, const std::vector<std::string>& lines, std::size_t bytes, std::size_t& count, F&& matches) {
+	auto start = std::chrono::steady_clock::now();
+	count = 0;
+	for (auto& line : lines) count += matches(line);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::printf("%-14s %-12s %8zu lines %10.1f ms %10.1f MB/s\n", c.name, engine, count, elapsed.count(), bytes / elapsed.count() / 1000);
+}
+
+int main(int argc, char* argv[]) {
+	std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+	const char* levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+	std::mt19937 rng(42);
+	std::vector<std::string> lines(n);
+	std::size_t bytes = 0;
+	for (auto& line : lines) {
+		char buffer[160];
+		std::snprintf(buffer, sizeof(buffer), "2024-05-%02u 12:%02u:%02u %s [worker-%u] request id=%u path=/api/v1/items/%u took %ums",
+			rng() % 28 + 1, rng() % 60, rng() % 60, levels[rng() % 6], rng() % 32, rng() % 1000000, rng() % 5000, rng() % 2000);
+		line = buffer;
+		bytes += line.size();
+	}
+
+	const Case cases[] = {
+		{"alternation", "ERROR|FATAL", true, false},
+		{"slow", "took \\d{4,}ms", true, false},
+		{"full_line", "\\d{4}-\\d\\d-\\d\\d \\d\\d:\\d\\d:\\d\\d (INFO|WARN|ERROR) .*", false, false},
+		{"captures", "\\[(\\w+)-(\\d+)\\] request id=(\\d+)", true, true},
+	};
+	for (auto& c : cases) {
+		regex::Regex ours(c.pattern);
+		std::regex theirs(c.pattern);
+		std::vector<std::string> groups;
+		std::smatch match;
+		std::size_t a, b;
+		run("Regex", c, lines, bytes, a, [&](const std::string& line) {
+			if (c.groups) return c.search ? ours.search(line, groups) : ours.match(line, groups);
+			return c.search ? ours.search(line) : ours.match(line);
+		});
+		run("std::regex", c, lines, bytes, b, [&](const std::string& line) {
+			if (c.groups) return c.search ? std::regex_search(line, match, theirs) : std::regex_match(line, match, theirs);
+			return c.search ? std::regex_search(line, theirs) : std::regex_match(line, theirs);
+		});
+		if (a != b) std::abort();
+	}
+	return 0;
+}
@@ -0,0 +1,88 @@
+namespace A {
+	const int n = 7;
+	int g = 3;
+	int sq(int x) { return x * x; }
+}
+
+int counter = 0;
+
+int bump(int x) {
+	counter = counter + 1;
+	return x + counter;
+}
+
+int fib(int n) {
+	if (n < 2) { return n; }
+	return fib(n - 1) + fib(n - 2);
+}
+
+void fill(int a[], int v) {
+	for (int i = 0; i < len(a); i++) { a[i] = v; }
+}
+
+int aliased(int a[], int b[]) {
+	int total = 0;
+	for (int i = 0; i < 4; i++) {
+		a[0] = a[0] + 1;
+		total += b[0] * 10 + len(b);
+		push(a, i);
+	}
+	return total;
+}
+
+int main() {
+	int total = 0;
+	int k = 5;
+	for (int i = 0; i < 10; i++) {
+		total += A::n * 2 + k * k + A::sq(k) + i * 4;
+	}
+	println(total);
+	int j = 0;
+	while (j < 5) {
+		total += bump(k) + A::g * 2;
+		j++;
+	}
+	println(total, counter);
+	for (int i = 0; i < 20; i += 3) {
+		if (i * 2 > 10) { continue; }
+		total += i * 2 + i * 2 + 3 * i;
+	}
+	println(total);
+	int z = 0;
+	for (int i = 0; i < 3; i++) {
+		if (z != 0) { total += 100 / z; }
+		for (int m = 0; m < 3; m++) {
+			total += fib(k) * m + (k + 1) * (i + 1);
+		}
+	}
+	println(total);
+	int a[];
+	for (int i = 0; i < 4; i++) { push(a, 0); }
+	for (int i = 0; i < 3; i++) {
+		fill(a, i);
+		total += sum(a) + len(a) * 2;
+	}
+	println(total);
+	int b[];
+	b = a;
+	for (int i = 0; i < 3; i++) {
+		push(a, i);
+		total += len(b) * 100 + sum(b) + len(a);
+		b = a;
+		a[0] = a[0] + 1;
+	}
+	println(total, len(a), len(b), a[0], b[0]);
+	for (int i = 10; i > 0; i--) {
+		total += i * 7;
+		k = k + 1;
+		total += k * 2;
+	}
+	println(total);
+	int xs[];
+	int ys[];
+	push(xs, 1);
+	push(ys, 1);
+	println(aliased(xs, ys), len(xs), len(ys));
+	println(aliased(xs, xs), len(xs), xs[0]);
+	return 0;
+}
@@ -0,0 +1,72 @@
+const bool DEBUG = false;
+const int LEVEL = 2;
+int unused_global = 5;
+int counter = 0;
+int init() {
+	counter = counter + 10;
+	return 1;
+}
+
+int effect = init();
+
+namespace Lib {
+	const bool VERBOSE = true;
+	int helper(int x) { return x + 1; }
+	int dead(int x) { return helper(x) * 2; }
+	namespace Deep {
+		int deeper(int x) { return x * 3; }
+		int unused() { return 0; }
+	}
+	int use_deep(int x) { return Deep::deeper(x) + helper(x); }
+	void log(string s) {
+		if (VERBOSE) { println("log: " + s); } else { println("quiet"); }
+	}
+}
+
+namespace Empty {
+	int nothing() { return 1; }
+}
+
+int never_called(int x) {
+	return x;
+}
+
+int f(int x) {
+	if (x > 3) {
+		return x;
+		println("never");
+		x = x + 1;
+	}
+	return -x;
+}
+
+int shadow() {
+	bool DEBUG = true;
+	if (DEBUG) { return 1; }
+	return 0;
+}
+
+int main() {
+	if (DEBUG) {
+		println(never_called(1));
+	} else if (LEVEL) {
+		println("level");
+	} else {
+		println("no level");
+	}
+	while (false) {
+		println("loop");
+	}
+	for (int i = 0; i < 5; i++) {
+		if (i == 2) { continue; println("x"); }
+		println(i, f(i));
+	}
+	println(Lib::use_deep(4), effect, counter, shadow());
+	Lib::log("hello");
+	if (0) { println("zero"); }
+	if (DEBUG) println("debug");
+	if (true) println("true");
+	while (DEBUG) { println("debug loop"); }
+	if (LEVEL) { println("level again"); } else { println("never"); }
+	return 0;
+}
@@ -0,0 +1,43 @@
+int main() {
+	int total = 0;
+	for (int i = 0; i < 20; i++) {
+		if (i / 3 * 3 == i) { continue; }
+		total += i * 5;
+	}
+	println(total);
+	for (int i = 30; i > 0; i -= 4) {
+		total += i * 3 + i * -2;
+	}
+	println(total);
+	for (int i = 10; i >= -10; i--) {
+		total += i * 7;
+	}
+	println(total);
+	for (int i = 0; i < 12; i++) {
+		switch (i - i / 4 * 4) {
+			case 0: total += i * 11; break;
+			case 1: continue;
+			case 2: total += i * 13;
+			default: total -= i * 2;
+		}
+		total += i * 100;
+	}
+	println(total);
+	int k = 3;
+	for (int i = -6; i < 6; i += 2) {
+		if (i == 0) { continue; }
+		for (int j = 5; j > -5; j -= 3) {
+			total += i * k + j * 4;
+			if (j < 0) { continue; }
+			total += j * i;
+		}
+	}
+	println(total);
+	int i = 0;
+	while (i < 10) {
+		total += i * 9;
+		i += 3;
+	}
+	println(total);
+	return 0;
+}
@@ -0,0 +1,107 @@
+int classify(char c) {
+	switch (c) {
+		case ' ':
+			return 0;
+		case 'a': case 'e': case 'i': case 'o': case 'u':
+			return 1;
+		default:
+			return 2;
+	}
+	return -1;
+}
+
+int sparse(int x) {
+	int r = 0;
+	switch (x) {
+		case -100: r = 1; break;
+		case 7: r = 2;
+		case 1000: r = r + 10; break;
+		case 50000: r = 3; break;
+	}
+	return r;
+}
+
+int negative(int x) {
+	switch (x) {
+		case -3: return 30;
+		case -2: return 20;
+		case -1: return 10;
+		case 0: return 0;
+		case 1: return -10;
+	}
+	return 99;
+}
+
+int dense(int op) {
+	int acc = 0;
+	switch (op) {
+		case 0: acc += 1; break;
+		case 1: acc += 2; break;
+		case 2: acc += 3; break;
+		case 3: acc += 4; break;
+		case 4: acc += 5;
+		case 5: acc += 6; break;
+		case 6: acc += 7; break;
+		case 7: acc += 8; break;
+		case 8: acc += 9; break;
+		case 9: acc += 10; break;
+		default: acc = -1;
+	}
+	return acc;
+}
+
+int main() {
+	int total = 0;
+	for (int i = 0; i < 12; i++) {
+		switch (i - i / 6 * 6) {
+			case 0: total += 1;
+			case 1: total += 10; break;
+			case 2: continue;
+			case 3: { int k = i * 2; total += k; } break;
+			default: total += 1000;
+		}
+		total += 100000;
+	}
+	println(total);
+	println(sparse(-100), sparse(7), sparse(1000), sparse(50000), sparse(3));
+	char s[];
+	push(s, 'h'); push(s, 'i'); push(s, ' '); push(s, 'o'); push(s, 'u'); push(s, 't');
+	int vowels = 0;
+	for (char c : s) {
+		if (classify(c) == 1) vowels++;
+	}
+	println(vowels, classify(' '), classify('z'));
+	int state = 0;
+	int steps = 0;
+	while (state != 4) {
+		switch (state) {
+			case 0: state = 2; break;
+			case 2: state = 1; break;
+			case 1: state = 3; break;
+			case 3: state = 4; break;
+		}
+		steps++;
+	}
+	println(steps);
+	println(negative(-5), negative(-3), negative(-2), negative(-1), negative(0), negative(1), negative(2));
+	int acc = 0;
+	int op = 0;
+	for (int i = 0; i < 4000; i++) {
+		if (op >= 9) { op = op - 16; }
+		op = op + 7;
+		acc += dense(op);
+	}
+	println(acc);
+	for (int i = 0; i < 6; i++) {
+		int sum = 0;
+		switch (i) {
+			case 0: sum += 1;
+			case 1: sum += 10; break;
+			case 2: continue;
+			case 3: { int k = i * 2; sum += k; } break;
+			default: sum += 1000;
+		}
+		println(i, sum);
+	}
+	return 0;
+}
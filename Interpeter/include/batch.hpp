@@ -0,0 +1,156 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "program.hpp"
+#include "visitor.hpp"
+
+// chars are ints wrapped to 8 bits when stored
+enum class LaneType { Int, Double, Bool, Char };
+
+struct LaneOp {
+	enum Code {
+		ConstI, ConstD, LoadI, LoadD, Copy, Select,
+		AddI, SubI, MulI, DivI, NegI, AddD, SubD, MulD, DivD, NegD,
+		EqI, NeI, LtI, LeI, GtI, GeI, EqD, NeD, LtD, LeD, GtD, GeD,
+		And, Or, Not, IntToDouble, DoubleToInt, IntToMask, DoubleToMask, MaskToInt, IntToChar
+	};
+	Code code;
+	int dst, a, b, c;
+	double value;
+};
+
+struct LaneProgram {
+	std::vector<LaneOp> ops;
+	std::vector<LaneType> params;
+	std::size_t registers = 0;
+	LaneType returnType = LaneType::Int;
+	int result = -1, returned = -1, fallback = -1;
+};
+
+struct BatchUnsupported : public std::runtime_error {
+	BatchUnsupported(const std::string& what) : std::runtime_error(what) {}
+};
+
+// Compiles a pure, loop-free function body into a straight-line program over
+// lanes. Branches become masked writes, callees are inlined; anything else
+// throws BatchUnsupported.
+class BatchCompiler : public Visitor {
+public:
+	BatchCompiler(const std::shared_ptr<Function>&);
+	LaneProgram compile();
+
+	void visit(Namespace_decl&);
+	void visit(Variables_decl&);
+	void visit(ConstVariable&);
+	void visit(Array_decl&);
+	void visit(Functions_decl&);
+	void visit(Extern_decl&);
+
+	void visit(Expression_statement&);
+	void visit(Block_statement&);
+	void visit(Decl_statement&);
+	void visit(While_statement&);
+	void visit(For_statement&);
+	void visit(ForEach_statement&);
+	void visit(Switch_statement&);
+	void visit(ConditionalBlock&);
+	void visit(ConditionalBranches&);
+	void visit(Continue_statement&);
+	void visit(Break_statement&);
+	void visit(Return_statement&);
+
+	void visit(BinaryNode&);
+	void visit(TernaryNode&);
+	void visit(PrefixNode&);
+	void visit(PostfixNode&);
+	void visit(FunctionNode&);
+	void visit(SpawnNode&);
+	void visit(AwaitNode&);
+	void visit(IndexNode&);
+	void visit(IdentifierNode&);
+	void visit(HoistedNode&);
+	void visit(ParenthesizedNode&);
+
+	void visit(IntNode&);
+	void visit(CharNode&);
+	void visit(BoolNode&);
+	void visit(StringNode&);
+	void visit(DoubleNode&);
+
+private:
+	struct Local {
+		int reg;
+		LaneType type;
+	};
+
+	struct Frame {
+		std::shared_ptr<Function> function;
+		std::vector<std::unordered_map<std::string, Local>> scopes;
+		int active, returned, result;
+		LaneType returnType;
+	};
+
+	int emit(LaneOp::Code, int a = -1, int b = -1, int c = -1, double value = 0);
+	int constant(LaneType, double);
+	int convert(int, LaneType, LaneType);
+	int live();
+	void store(Local&, int, LaneType);
+	void inline_call(const std::shared_ptr<Function>&, const std::vector<Local>&);
+	int arithmetic(const std::string&, Local, Local);
+	Local* local(const std::string&);
+	std::shared_ptr<Scope> scope_of(const expression&);
+	static LaneType lane_type(const std::shared_ptr<Type>&);
+
+	std::shared_ptr<Function> function;
+	std::vector<Frame> frames;
+	std::shared_ptr<Scope> qualifier;
+	LaneProgram program;
+
+	int reg = -1;
+	LaneType type = LaneType::Int;
+};
+
+// Runs one script function over columns of argument values. Chunks of rows
+// are evaluated in lockstep by the compiled lane program, four rows to a
+// vector when the CPU has AVX2 and two otherwise; rows the program
+// cannot handle (and whole batches it cannot compile) go through an
+// execution context one call at a time. Those calls are spread over the
+// thread pool, one context per thread, when the function is pure.
+class Batch {
+public:
+	Batch(const Program&, const std::string&, Profiler* = nullptr, const std::shared_ptr<Budget>& = nullptr);
+	// over the globals of an executor that is already running, which also
+	// makes the calls the lanes cannot, on the calling thread: contexts of
+	// other threads would not see the globals it has changed
+	Batch(Executor&, const std::shared_ptr<Function>&);
+
+	std::vector<double> run(const std::vector<std::vector<double>>&);
+	bool vectorized() const;
+private:
+	struct Worker {
+		std::unique_ptr<ExecutionContext> context;
+		// borrowed, when there is no context
+		Executor* executor = nullptr;
+		std::shared_ptr<Function> function;
+	};
+
+	void compile();
+
+	void fallback(const std::vector<std::vector<double>>&, const std::vector<std::size_t>&, std::vector<double>&);
+	double call(Worker&, const std::vector<std::vector<double>>&, std::size_t);
+
+	// null over a borrowed executor
+	const Program* script = nullptr;
+	std::string name;
+	std::shared_ptr<Budget> budget;
+	// the first runs on the calling thread, with the profiler
+	std::vector<Worker> workers;
+	std::shared_ptr<Function> function;
+	LaneProgram program;
+	bool compiled;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+// Thrown when a run has used up its budget; what() names the limit.
+class BudgetExceeded : public std::runtime_error {
+public:
+	BudgetExceeded(const std::string& what, std::uint64_t steps) : std::runtime_error(what), steps(steps) {}
+
+	// steps taken by the run when it was stopped
+	std::uint64_t steps;
+};
+
+// Thrown by operator new for an allocation that takes a run over its memory
+// limit, so that code catching std::bad_alloc sees it as one. It keeps its
+// message in place, since allocating one would go over the limit again.
+// The interpreter turns it into BudgetExceeded once the run has unwound.
+class MemoryExceeded : public std::bad_alloc {
+public:
+	explicit MemoryExceeded(std::size_t limit);
+	const char* what() const noexcept override { return message; }
+private:
+	char message[64];
+};
+
+// Limits on one run: a number of steps, one per loop iteration and per
+// call, a wall-clock deadline counted from construction, and the heap
+// memory the run holds. Executors draw steps in slices, so the shared
+// counter and the clock are touched once per SLICE steps, and an executor
+// without a budget only tests a pointer. Once exhausted a budget stays
+// exhausted, which stops every thread of the run.
+class Budget {
+public:
+	static constexpr std::uint64_t SLICE = 1024;
+
+	// While a Charge is alive, what the thread allocates and frees is
+	// counted against budget; a null budget stops the counting.
+	class Charge {
+	public:
+		explicit Charge(Budget* budget) : previous(charged) { charged = budget; }
+		~Charge() { charged = previous; }
+		Charge(const Charge&) = delete;
+		Charge& operator=(const Charge&) = delete;
+	private:
+		Budget* previous;
+	};
+
+	// zero means no limit
+	Budget(std::uint64_t steps, std::chrono::milliseconds time, std::size_t bytes = 0);
+
+	// grants up to SLICE steps; throws BudgetExceeded when no step is left
+	// or the deadline has passed
+	std::uint64_t take();
+	// returns steps that were granted but not taken
+	void refund(std::uint64_t);
+	std::uint64_t used() const;
+	// bytes the run allocated and has not freed, and the most it held
+	std::size_t memory() const;
+	std::size_t peak_memory() const;
+
+	// whether the program links the operator new and delete of heap.cpp,
+	// without which memory is neither counted nor limited
+	static bool installed();
+	static void install();
+	// called by operator new and delete. An allocation that goes over the
+	// memory limit throws MemoryExceeded, on any thread of the run, unless
+	// the thread is already unwinding from an exception.
+	static void allocated(void*);
+	static void freed(void*);
+private:
+	static thread_local Budget* charged;
+	static bool hooked;
+
+	std::uint64_t limit;
+	bool timed;
+	std::chrono::steady_clock::time_point deadline;
+	std::int64_t memoryLimit;
+	std::atomic<std::uint64_t> granted{0};
+	std::atomic<bool> exhausted{false};
+	// memory freed by the run that it did not allocate can make held negative
+	std::atomic<std::int64_t> held{0};
+	std::atomic<std::int64_t> peak{0};
+};
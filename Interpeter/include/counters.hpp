@@ -0,0 +1,44 @@
+#pragma once
+
+// Execution histograms are only compiled in with -DINTERPRETER_COUNTERS
+// (make COUNTERS=1); otherwise the macros expand to nothing.
+
+#ifdef INTERPRETER_COUNTERS
+
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+
+#include "symbol.hpp"
+
+class ExecutionCounters {
+public:
+	~ExecutionCounters();
+
+	void node(const char* kind, const std::string& detail = "") {
+		nodes[std::make_pair(kind, detail)]++;
+	}
+
+	void binary(const std::string& op, const std::shared_ptr<Symbol>& lhs, const std::shared_ptr<Symbol>& rhs) {
+		operands[std::make_pair(op, std::make_pair(type_of(lhs), type_of(rhs)))]++;
+	}
+
+	static ExecutionCounters& local();
+	static void dump(std::ostream&);
+private:
+	static std::type_index type_of(const std::shared_ptr<Symbol>&);
+
+	std::map<std::pair<const char*, std::string>, std::size_t> nodes;
+	std::map<std::pair<std::string, std::pair<std::type_index, std::type_index>>, std::size_t> operands;
+};
+
+#define COUNT_NODE(...) ExecutionCounters::local().node(__VA_ARGS__)
+#define COUNT_BINARY(op, lhs, rhs) ExecutionCounters::local().binary(op, lhs, rhs)
+
+#else
+
+#define COUNT_NODE(...) ((void)0)
+#define COUNT_BINARY(op, lhs, rhs) ((void)0)
+
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "program.hpp"
+
+// C++ interface for programs that embed the interpreter (C programs use
+// interpreter.h). A script is parsed and analyzed once; calls then go
+// straight to the executor:
+//
+//     auto script = embed::Script::compile(text);
+//     embed::Context context(script);
+//     auto fact = context.function("A::fact");
+//     int x = std::get<int>(fact(10));
+//
+// Scripts are immutable and can be shared between threads. A context holds
+// the global variables of one instance of the script and must be used by
+// one thread at a time; give each thread its own. Errors in the script or
+// in a call are thrown as std::runtime_error, a run that goes over its
+// limits as BudgetExceeded.
+namespace embed {
+	using Argument = std::variant<int, double, bool, char, std::string>;
+	// std::monostate for void functions
+	using Result = std::variant<std::monostate, int, double, bool, char, std::string>;
+
+	class Script {
+	public:
+		static Script compile(const std::string& source);
+		static Script load(const std::string& path);
+	private:
+		friend class Context;
+		explicit Script(std::shared_ptr<const Program> program) : program(std::move(program)) {}
+
+		std::shared_ptr<const Program> program;
+	};
+
+	class Function;
+
+	class Context {
+	public:
+		explicit Context(const Script&);
+		// waits for calls spawned in the script
+		~Context();
+		Context(const Context&) = delete;
+		Context& operator=(const Context&) = delete;
+
+		// bounds every later run() and call on its own: a number of loop
+		// iterations and calls, and a time, zero for no limit
+		void limit(std::uint64_t steps, std::chrono::milliseconds time);
+		// the same for the bytes of heap memory a run holds. Memory is
+		// counted by the operator new of heap.o, which the library does not
+		// replace on its own; without it a limit throws std::runtime_error
+		void limit_memory(std::size_t bytes);
+
+		// calls main, if the script has one
+		void run();
+		// name may be qualified with namespaces; the function stays valid
+		// as long as the context
+		Function function(const std::string& name);
+	private:
+		friend class Function;
+		void start();
+
+		std::shared_ptr<const Program> program;
+		ExecutionContext context;
+		std::uint64_t maxSteps = 0;
+		std::chrono::milliseconds timeout{0};
+		std::size_t maxMemory = 0;
+		std::shared_ptr<Budget> budget;
+	};
+
+	// A function of a script bound to a context. Arguments are converted
+	// into storage made once per function, and only int, double, bool, char
+	// and string parameters and results are supported.
+	class Function {
+	public:
+		std::size_t arity() const { return kinds.size(); }
+
+		// throws when the arguments do not match the parameters
+		Result call(const std::vector<Argument>&);
+
+		template<typename... Args>
+		Result operator()(Args&&... args) {
+			return call({Argument(std::forward<Args>(args))...});
+		}
+
+		// one call for every row of columns, with a column of values for
+		// each parameter, which must all be scalars. Rows are run many at a
+		// time where the function allows; results are converted to double
+		std::vector<double> batch(const std::vector<std::vector<double>>& columns);
+	private:
+		friend class Context;
+		Function(Context&, std::shared_ptr<::Function>);
+
+		Context* context;
+		std::shared_ptr<::Function> function;
+		// index of the Argument alternative each parameter takes
+		std::vector<std::size_t> kinds;
+		std::vector<symbol> args;
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// File access behind read_file, write_file, append_file and lines. Regular
+// files are read by mapping them into memory (MADV_SEQUENTIAL), so scanning
+// a large file line by line never copies it as a whole. append_file keeps
+// one buffered writer open per path until the program ends, or until the
+// same path is read or rewritten.
+//
+// A mapped file that is cut short while it is read would kill the program
+// with SIGBUS. Rewriting it with write_file first copies what the mappings
+// of it hold into memory, so a script reads the file as it was. When
+// something else truncates it, the pages past the end read as zeros, and
+// the mapping is read again with read() to the size the file has now.
+namespace files {
+	// the table of live mappings, in files.cpp
+	class Registry;
+
+	class Mapping {
+	public:
+		// throws std::runtime_error when the file cannot be opened
+		explicit Mapping(const std::string& path);
+		~Mapping();
+		Mapping(const Mapping&) = delete;
+		Mapping& operator=(const Mapping&) = delete;
+
+		std::string_view view() const { return {data, size}; }
+		// whether the file was cut short since the mapping was made or
+		// last reloaded
+		bool truncated() const { return cut.load(std::memory_order_acquire); }
+		// reads the file again into memory, as long as it is now
+		void reload();
+	private:
+		friend class Registry;
+
+		const char* data = nullptr;
+		std::size_t size = 0;
+		bool mapped = false;
+		std::vector<char> buffer;
+		int fd = -1;
+		// slot in the table of live mappings, -1 when not mapped
+		int slot = -1;
+		std::atomic<bool> cut{false};
+	};
+
+	// Splits a mapping into lines without their "\n" or "\r\n"; a final line
+	// without a terminator counts, an empty remainder after the last one not.
+	class Lines {
+	public:
+		explicit Lines(Mapping& file) : file(file) {}
+		bool next(std::string_view& line);
+	private:
+		Mapping& file;
+		std::size_t position = 0;
+	};
+
+	class Writer {
+	public:
+		static constexpr std::size_t CAPACITY = 1 << 20;
+
+		// throws std::runtime_error when the file cannot be opened
+		Writer(const std::string& path, bool append);
+		~Writer();
+		Writer(const Writer&) = delete;
+		Writer& operator=(const Writer&) = delete;
+
+		void write(std::string_view);
+		bool flush();
+		// no write has failed so far
+		bool good() const { return !failed; }
+	private:
+		int fd;
+		std::size_t size = 0;
+		bool failed = false;
+		std::vector<char> buffer;
+	};
+
+	std::string read(const std::string& path);
+	// false when the file cannot be opened or written
+	bool write(const std::string& path, std::string_view text);
+	bool append(const std::string& path, std::string_view text);
+	// writes out and closes the writer append left open for path
+	void close(const std::string& path);
+}
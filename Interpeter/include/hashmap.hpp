@@ -0,0 +1,151 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash table with Robin Hood linear probing: an entry that
+// is further from its home slot takes the place of a closer one, which keeps
+// probe sequences short and lets a lookup stop at the first entry that is
+// closer to home than the key would be. Entries live in one flat array, so a
+// probe touches neighbouring memory only. Erasing shifts the following
+// entries back instead of leaving tombstones.
+template <typename K, typename V>
+class HashMap {
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using value_type = std::pair<K, V>;
+
+	class iterator {
+	public:
+		iterator(const HashMap* map, std::size_t i) : map(map), i(i) { skip(); }
+
+		const value_type& operator*() const { return map->slots[i]; }
+		const value_type* operator->() const { return &map->slots[i]; }
+		iterator& operator++() { i++; skip(); return *this; }
+		bool operator==(const iterator& other) const { return i == other.i; }
+	private:
+		void skip() {
+			while (i < map->distances.size() && !map->distances[i]) i++;
+		}
+
+		const HashMap* map;
+		std::size_t i;
+	};
+
+	std::size_t size() const { return count; }
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, distances.size()); }
+
+	V* find(const K& key) {
+		auto i = index_of(key, hash(key));
+		return i == npos ? nullptr : &slots[i].second;
+	}
+
+	bool contains(const K& key) const {
+		return index_of(key, hash(key)) != npos;
+	}
+
+	// inserts a value-initialized entry when the key is missing
+	V& operator[](const K& key) {
+		auto h = hash(key);
+		if (auto i = index_of(key, h); i != npos) return slots[i].second;
+		if ((count + 1) * 8 > distances.size() * 7) grow();
+		auto i = insert(value_type(key, V()), h);
+		return slots[i == npos ? index_of(key, h) : i].second;
+	}
+
+	bool erase(const K& key) {
+		auto i = index_of(key, hash(key));
+		if (i == npos) return false;
+		for (auto next = (i + 1) & mask; distances[next] > 1; i = next, next = (next + 1) & mask) {
+			slots[i] = std::move(slots[next]);
+			if constexpr (cached) hashes[i] = hashes[next];
+			distances[i] = distances[next] - 1;
+		}
+		distances[i] = 0;
+		slots[i] = value_type();
+		count--;
+		return true;
+	}
+
+private:
+	static constexpr std::size_t npos = -1;
+	// string keys keep their hash, so that growing does not rehash them and
+	// probes compare hashes before strings
+	static constexpr bool cached = std::is_same_v<K, std::string>;
+
+	static std::size_t hash(const K& key) {
+		std::uint64_t h;
+		if constexpr (cached) h = std::hash<std::string_view>()(key);
+		else h = static_cast<std::make_unsigned_t<K>>(key);
+		// Fibonacci hashing spreads sequential keys over the top bits
+		return static_cast<std::size_t>(h * 0x9E3779B97F4A7C15ull);
+	}
+
+	std::size_t index_of(const K& key, std::size_t h) const {
+		if (!count) return npos;
+		auto i = h >> shift;
+		for (std::uint8_t d = 1;; d++, i = (i + 1) & mask) {
+			if (distances[i] < d) return npos;
+			if (distances[i] == d && (!cached || hashes[i] == h) && slots[i].first == key) return i;
+		}
+	}
+
+	// Places an entry whose key is not in the table. Returns its slot, or npos
+	// when a probe sequence grew too long and the table was rebuilt.
+	std::size_t insert(value_type entry, std::size_t h) {
+		auto i = h >> shift, placed = npos;
+		for (std::uint8_t d = 1;; d++, i = (i + 1) & mask) {
+			if (d == UINT8_MAX) {
+				grow();
+				insert(std::move(entry), h);
+				return npos;
+			}
+			if (!distances[i]) {
+				distances[i] = d;
+				slots[i] = std::move(entry);
+				if constexpr (cached) hashes[i] = h;
+				count++;
+				return placed == npos ? i : placed;
+			}
+			if (distances[i] < d) {
+				std::swap(d, distances[i]);
+				std::swap(entry, slots[i]);
+				if constexpr (cached) std::swap(h, hashes[i]);
+				if (placed == npos) placed = i;
+			}
+		}
+	}
+
+	void grow() {
+		auto oldDistances = std::move(distances);
+		auto oldSlots = std::move(slots);
+		auto oldHashes = std::move(hashes);
+		std::size_t capacity = oldDistances.empty() ? 8 : oldDistances.size() * 2;
+		distances.assign(capacity, 0);
+		slots.assign(capacity, value_type());
+		if constexpr (cached) hashes.assign(capacity, 0);
+		mask = capacity - 1;
+		shift = std::numeric_limits<std::size_t>::digits - std::countr_zero(capacity);
+		count = 0;
+		for (std::size_t i = 0; i < oldDistances.size(); i++) {
+			if (oldDistances[i]) insert(std::move(oldSlots[i]), cached ? oldHashes[i] : hash(oldSlots[i].first));
+		}
+	}
+
+	// 0 marks an empty slot, otherwise the distance from the home slot plus one
+	std::vector<std::uint8_t> distances;
+	std::vector<value_type> slots;
+	std::vector<std::size_t> hashes;
+	std::size_t count = 0, mask = 0;
+	int shift = std::numeric_limits<std::size_t>::digits;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Whitespace-separated reader behind the input builtin. A regular file is
+// mapped into memory as a whole; anything else (pipes, terminals) is read
+// through a large buffer that is refilled as tokens are consumed.
+class Input {
+public:
+	static constexpr std::size_t CAPACITY = 1 << 16;
+
+	Input(int fd);
+	~Input();
+	Input(const Input&) = delete;
+	Input& operator=(const Input&) = delete;
+
+	bool read(int&);
+	bool read(double&);
+	bool read(char&);
+	bool read(bool&);
+	bool read(std::string&);
+
+	// a terminal on the other end: pending output is flushed before reading
+	bool interactive() const;
+
+	static Input& standard();
+private:
+	bool skip_space();
+	std::string_view token();
+	bool refill();
+
+	int fd;
+	const char* data = nullptr;
+	std::size_t pos = 0, end = 0;
+	bool mapped = false, eof = false;
+	std::vector<char> buffer;
+};
@@ -0,0 +1,76 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stddef.h>
+
+/* C interface for programs that embed the interpreter, over the one in
+ * embed.hpp. A script is compiled once and can be shared between threads;
+ * each thread calls into it through a context of its own. Functions that
+ * fail return NULL or -1, or INTERP_BUDGET_EXCEEDED for a run stopped by
+ * its limits, and interp_error() then describes the failure on the
+ * calling thread. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERP_BUDGET_EXCEEDED (-2)
+
+typedef struct interp_script interp_script;
+typedef struct interp_context interp_context;
+typedef struct interp_function interp_function;
+
+typedef enum {
+	INTERP_VOID,
+	INTERP_INT,
+	INTERP_DOUBLE,
+	INTERP_BOOL,
+	INTERP_CHAR,
+	INTERP_STRING
+} interp_type;
+
+typedef struct {
+	interp_type type;
+	union {
+		int i;
+		double d;
+		int b;
+		char c;
+		/* a result string stays valid until the next call of the same function */
+		const char* s;
+	} as;
+} interp_value;
+
+interp_script* interp_compile(const char* source);
+interp_script* interp_compile_file(const char* path);
+void interp_script_free(interp_script*);
+
+interp_context* interp_context_new(const interp_script*);
+/* also frees the functions looked up in the context */
+void interp_context_free(interp_context*);
+/* bounds every later run and call on its own: a number of loop iterations
+ * and calls, and a time in milliseconds, zero for no limit */
+void interp_context_limit(interp_context*, unsigned long long steps, unsigned long milliseconds);
+/* the same for the bytes of heap memory a run holds; fails unless the
+ * program links heap.o, which replaces operator new to count it */
+int interp_context_limit_memory(interp_context*, size_t bytes);
+/* calls main, if the script has one */
+int interp_run(interp_context*);
+
+/* name may be qualified with namespaces, as in "A::fact" */
+interp_function* interp_function_find(interp_context*, const char* name);
+size_t interp_function_arity(const interp_function*);
+/* result may be NULL when it is not needed */
+int interp_call(interp_function*, const interp_value* args, size_t count, interp_value* result);
+/* calls the function once for each of rows rows, its i-th argument taken
+ * from columns[i], one column for each parameter, and stores the results
+ * in out as doubles */
+int interp_batch(interp_function*, const double* const* columns, size_t rows, double* out);
+
+const char* interp_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
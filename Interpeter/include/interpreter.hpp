@@ -1,14 +1,51 @@
-#pragma once
-
-#include "ast.hpp"
-
-class Interpreter {
-public:
-    Interpreter(const char*);
-    
-    void print();
-    void analyze();
-    void execute();
-private:
-    std::vector<declaration> nodes;
-};
\ No newline at end of file
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ast.hpp"
+#include "stats.hpp"
+#include "profiler.hpp"
+
+class Budget;
+class Program;
+
+class Interpreter {
+public:
+    Interpreter(const char*, Stats* = nullptr, Profiler* = nullptr);
+    // from the text of a script rather than its path
+    static Interpreter source(const std::string&, Stats* = nullptr, Profiler* = nullptr);
+    
+    // bounds each later execute() or batch(): a number of loop iterations
+    // and calls, a time in milliseconds and the bytes of heap memory held,
+    // zero for no limit. A run that goes over stops with BudgetExceeded.
+    void limit(std::uint64_t steps, std::chrono::milliseconds time, std::size_t bytes = 0);
+
+    // drops what cannot run when the script starts at entry
+    void prune(const std::string& entry = "main");
+    void print();
+    void analyze();
+    // hoists loop-invariant expressions and strength-reduces counter
+    // multiplies; only after analyze()
+    void optimize();
+    void execute();
+    std::vector<double> batch(const std::string&, const std::vector<std::vector<double>>&);
+    // analyzes the script and runs its global declarations, for calling
+    // into it later; the program does not refer back to the interpreter
+    std::shared_ptr<const Program> compile();
+private:
+    Interpreter(Stats*, Profiler*);
+    void parse(const std::string&);
+    std::shared_ptr<Budget> budget() const;
+    void finish(const std::shared_ptr<Budget>&);
+
+    std::vector<declaration> nodes;
+    Stats* stats;
+    Profiler* profiler;
+    std::uint64_t maxSteps = 0;
+    std::chrono::milliseconds timeout{0};
+    std::size_t maxMemory = 0;
+};
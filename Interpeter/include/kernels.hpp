@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+// Numeric kernels behind the array builtins. Each call picks the widest
+// instruction set the CPU supports (AVX2, else SSE2) and splits arrays above
+// PARALLEL_THRESHOLD across threads. Integer results wrap like the
+// interpreter's 32-bit int.
+namespace kernels {
+	int sum(const int*, std::size_t);
+	double sum(const double*, std::size_t);
+
+	int dot(const int*, const int*, std::size_t);
+	double dot(const double*, const double*, std::size_t);
+
+	int min(const int*, std::size_t);
+	double min(const double*, std::size_t);
+	int max(const int*, std::size_t);
+	double max(const double*, std::size_t);
+
+	// x *= a
+	void scale(int* x, int a, std::size_t);
+	void scale(double* x, double a, std::size_t);
+
+	// y += a * x
+	void axpy(int a, const int* x, int* y, std::size_t);
+	void axpy(double a, const double* x, double* y, std::size_t);
+
+	const char* isa();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Calls into C functions bound by extern "C" declarations. Without a
+// foreign function library each call goes through a thunk made for the
+// number of integer and double parameters the function takes, whose
+// prototype takes those in that order. This holds for the System V x86-64
+// and AAPCS64 calling conventions alone, which assign integer and
+// floating-point arguments to their registers independently of each other,
+// so that the order in which the two kinds are declared does not matter.
+// Strings are passed as const char*, and char and bool in integer
+// registers. Variadic functions, which these conventions pass differently,
+// are not supported.
+namespace native {
+	enum class Kind { Void, Int, Double, Char, Bool, String };
+
+	constexpr std::size_t INTEGERS = 6;
+	constexpr std::size_t DOUBLES = 8;
+
+	// arguments in the registers they are passed in
+	struct Arguments {
+		long integers[INTEGERS] = {};
+		double doubles[DOUBLES] = {};
+	};
+
+	// a returned string is in integer
+	union Result {
+		long integer;
+		double real;
+	};
+
+	using Thunk = Result (*)(void* address, const Arguments&);
+
+	// looks name up in library, which is opened once per path; an empty
+	// path looks in the program and the libraries already loaded. Throws
+	// std::runtime_error when either cannot be found.
+	void* resolve(const std::string& library, const std::string& name);
+
+	// the thunk for a function of this signature; throws
+	// std::runtime_error when there are too many parameters of one class,
+	// or on platforms whose calling convention this does not fit
+	Thunk thunk(const std::string& name, Kind result, const std::vector<Kind>& parameters);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "stats.hpp"
+
+// Rewrites for and while loops of an analyzed program. Expressions that
+// cannot change while a loop runs are moved out of it into a HoistedNode,
+// and counter * constant in a for loop becomes a value the loop steps
+// along with the counter. Only what can be proven is rewritten:
+//  - nothing the expression reads is declared or written in the loop, and
+//    globals only when the loop writes none and calls nothing impure
+//  - calls are hoisted only to functions the analyzer found pure that
+//    also write no array element they do not own, so that calling them
+//    once instead of on every iteration cannot be told apart
+// A hoisted expression is evaluated the first time it is used, so one
+// that would fail, or is only used on some paths, behaves as before.
+// Parallel for loops run their body on other threads and are left alone.
+class Optimizer {
+public:
+	explicit Optimizer(Stats* = nullptr);
+	void optimize(std::vector<declaration>&);
+
+	std::size_t hoisted() const { return hoistCount; }
+	std::size_t reduced() const { return reduceCount; }
+private:
+	// what a loop declares and writes, and whether it may write a global
+	struct Loop {
+		std::unordered_set<std::string> declared, written;
+		// names declared in the blocks being scanned
+		std::vector<std::unordered_set<std::string>> scopes;
+		bool globals = false;
+		std::vector<std::string>* slots = nullptr;
+	};
+
+	void declare(const declaration&);
+	void walk(const statement&);
+	void loop(While_statement&);
+	void loop(For_statement&);
+	void reduce(For_statement&);
+
+	void scan(const statement&, Loop&);
+	void scan(const expression&, Loop&);
+	void call(const std::string&, const std::vector<expression>&, Loop&);
+	void write(const expression&, Loop&);
+
+	void hoist(const statement&, Loop&);
+	void hoist(expression&, Loop&);
+	bool invariant(const expression&, const Loop&);
+	bool readable(const std::string&, const Loop&);
+	bool callable(const std::string&, const std::vector<expression>&, const Loop&);
+	void replace(const statement&, const std::string&, std::vector<Induction>&, int);
+	void replace(expression&, const std::string&, std::vector<Induction>&, int);
+
+	bool local(const std::string&) const;
+	// global variables and functions by qualified name, as seen from the
+	// namespace being walked; null or not found when there is none
+	const bool* global(const std::string&) const;
+	bool callee(const std::string&, bool& found) const;
+	std::string slot();
+	void note(const std::string&, const expression&);
+
+	static const std::unordered_set<std::string> readonly;
+
+	Stats* stats;
+	std::string nameSpace;
+	// whether each global variable is const
+	std::unordered_map<std::string, bool> globals;
+	// whether each function is clean; extern ones never are
+	std::unordered_map<std::string, bool> functions;
+	// scopes of the function being walked
+	std::vector<std::unordered_set<std::string>> locals;
+	std::size_t slots = 0, hoistCount = 0, reduceCount = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+// Buffered writer behind the print builtins. Output is collected in a
+// userspace buffer and handed to the FILE in large blocks: when the buffer
+// fills, on flush() (exit, input, terminate) and, when the FILE is a
+// terminal, at the end of every line.
+class Output {
+public:
+	static constexpr std::size_t CAPACITY = 1 << 16;
+
+	Output(std::FILE*);
+	~Output();
+	Output(const Output&) = delete;
+	Output& operator=(const Output&) = delete;
+
+	void put(char c) {
+		if (size == CAPACITY) flush();
+		buffer[size++] = c;
+	}
+
+	void write(std::string_view);
+	void write(int);
+	void write(double);
+	void write(char c) { put(c); }
+	void write(bool b) { put(b ? '1' : '0'); }
+	void newline();
+	void flush();
+
+	// doubles are printed like std::ostream (6 significant digits) unless
+	// shortest round-trip formatting is requested
+	bool shortest = false;
+
+	static Output& standard();
+private:
+	std::FILE* file;
+	std::size_t size = 0;
+	bool lineBuffered;
+	char buffer[CAPACITY];
+};
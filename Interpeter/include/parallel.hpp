@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "pool.hpp"
+
+// Ranges shorter than this are not worth starting threads for.
+constexpr std::size_t PARALLEL_THRESHOLD = 1 << 18;
+
+// Worker thread limit, set by --threads; 0 uses every hardware thread.
+inline std::size_t parallel_threads = 0;
+
+inline std::size_t parallel_chunks(std::size_t n, std::size_t threshold = PARALLEL_THRESHOLD) {
+	if (n < threshold) return 1;
+	std::size_t threads = parallel_threads ? parallel_threads : std::max(1u, std::thread::hardware_concurrency());
+	return std::max<std::size_t>(1, std::min(threads, n / (threshold / 4)));
+}
+
+// Runs f(begin, end, chunk) over `chunks` contiguous slices of [0, n) on
+// the shared pool; the calling thread works on them too.
+template <typename F>
+void parallel_for(std::size_t n, std::size_t chunks, F&& f) {
+	auto slice = [n, chunks](std::size_t i) { return n * i / chunks; };
+	if (chunks <= 1) {
+		f(0, n, 0);
+		return;
+	}
+	ThreadPool::shared().run(chunks, [&f, &slice](std::size_t chunk, std::size_t) {
+		f(slice(chunk), slice(chunk + 1), chunk);
+	});
+}
+
+// Reductions are split into slices of this many elements whatever the
+// number of threads, so that a floating-point sum comes out the same on
+// any machine and with any --threads.
+constexpr std::size_t REDUCE_SLICE = 1 << 16;
+
+// Reduces [0, n) with kernel(begin, end) over slices of REDUCE_SLICE,
+// combining the per-slice results in slice order. The slices are shared
+// out between threads when the range is long enough.
+template <typename T, typename Kernel, typename Combine>
+T parallel_reduce(std::size_t n, Kernel&& kernel, Combine&& combine) {
+	std::size_t slices = (n + REDUCE_SLICE - 1) / REDUCE_SLICE;
+	if (slices <= 1) return kernel(0, n);
+	std::vector<T> partial(slices);
+	auto reduce = [&](std::size_t slice, std::size_t) {
+		partial[slice] = kernel(slice * REDUCE_SLICE, std::min(n, (slice + 1) * REDUCE_SLICE));
+	};
+	if (parallel_chunks(n) <= 1) {
+		for (std::size_t i = 0; i < slices; i++) reduce(i, 0);
+	} else {
+		ThreadPool::shared().run(slices, reduce);
+	}
+	T result = partial[0];
+	for (std::size_t i = 1; i < slices; i++) {
+		result = combine(result, partial[i]);
+	}
+	return result;
+}
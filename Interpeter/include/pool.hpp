@@ -0,0 +1,89 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The submitted tasks of one owner, such as an execution context, which
+// can then wait for its own and not for every task in the pool. Only the
+// pool touches the count, under its lock.
+struct TaskGroup {
+	std::size_t outstanding = 0;
+};
+
+// Work-stealing thread pool behind parallel for and the parallel kernels.
+// A job is split into numbered tasks that are dealt out to one queue per
+// thread; a thread takes tasks from the front of its own queue and, once it
+// is empty, steals from the back of the others. The calling thread works on
+// the job too. Jobs started from inside a task, or while another thread's
+// job is running, run on the calling thread alone.
+//
+// Single tasks can also be submitted to run later, behind spawn. Idle pool
+// threads take the oldest; a thread that waits for one runs the newest
+// meanwhile, which is usually the one it waits for, so waiting never blocks
+// while there is queued work and nested waits stay shallow.
+class ThreadPool {
+public:
+	// threads counts the calling thread, so threads - 1 are started
+	explicit ThreadPool(std::size_t threads);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	std::size_t size() const { return queues.size(); }
+
+	// Calls task(i, thread) for every i in [0, tasks), where thread < size()
+	// is the index of the thread running it. Returns once all are done; the
+	// first exception thrown by a task is rethrown here, and the tasks not
+	// yet started are skipped.
+	void run(std::size_t tasks, const std::function<void(std::size_t, std::size_t)>& task);
+
+	// task must not throw; group, if any, counts it until it has finished
+	void submit(std::function<void()> task, const std::shared_ptr<TaskGroup>& group = nullptr);
+	// runs the newest submitted task, of group if there is one, on the
+	// calling thread; false when none is queued
+	bool run_one(const TaskGroup* group = nullptr);
+	// returns once every submitted task has finished, running queued ones
+	// on the calling thread meanwhile
+	void wait();
+	// the same for the tasks of group alone
+	void wait(const TaskGroup&);
+
+	// sized by --threads on first use
+	static ThreadPool& shared();
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::size_t> tasks;
+	};
+
+	bool take(std::size_t thread, std::size_t& task);
+	void work(std::size_t thread);
+	void loop(std::size_t thread);
+	void finish(TaskGroup*);
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex busy;
+	std::mutex mutex;
+	std::condition_variable wake, finished, idle;
+	const std::function<void(std::size_t, std::size_t)>* job = nullptr;
+	std::size_t generation = 0, remaining = 0;
+	bool cancelled = false, stopping = false;
+	std::exception_ptr error;
+
+	struct Submitted {
+		std::function<void()> task;
+		std::shared_ptr<TaskGroup> group;
+	};
+	std::deque<Submitted> submitted;
+	// submitted and not yet finished
+	std::size_t outstanding = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+class Profiler {
+public:
+	Profiler(std::size_t frequency = 997);
+	~Profiler();
+
+	void start();
+	void stop();
+
+	void enter(const std::string* name, std::size_t line) {
+		if (depth < MAX_DEPTH) stack[depth] = Frame{name, line};
+		std::atomic_signal_fence(std::memory_order_release);
+		depth = depth + 1;
+	}
+
+	void leave() {
+		depth = depth - 1;
+	}
+
+	void line(std::size_t line) {
+		if (depth && depth <= MAX_DEPTH) stack[depth - 1].line = line;
+	}
+
+	void write_folded(std::ostream&) const;
+	void write_summary(std::ostream&, std::size_t) const;
+private:
+	struct Frame {
+		const std::string* name;
+		std::size_t line;
+	};
+
+	static constexpr std::size_t MAX_DEPTH = 256;
+	static constexpr std::size_t BUFFER_FRAMES = 1 << 20;
+
+	static void handler(int);
+	void sample();
+	void aggregate();
+
+	Frame stack[MAX_DEPTH];
+	volatile std::size_t depth = 0;
+
+	std::vector<Frame> buffer;
+	volatile std::size_t used = 0;
+	volatile std::size_t dropped = 0;
+	std::size_t frequency;
+
+	std::size_t total = 0;
+	std::map<std::string, std::size_t> folded;
+	std::map<std::string, std::size_t> selfFunctions;
+	std::map<std::string, std::size_t> totalFunctions;
+	std::map<std::string, std::size_t> selfLines;
+
+	static Profiler* active;
+};
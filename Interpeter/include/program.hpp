@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+#include "symbol.hpp"
+#include "visitor.hpp"
+
+class Profiler;
+
+// An analyzed script together with the global scope its declarations build.
+// Nothing in it changes after construction, so one program can back any
+// number of ExecutionContexts on any number of threads at once.
+class Program {
+public:
+	// runs the global declarations, but not main, charging their loops and
+	// calls to budget if there is one
+	explicit Program(const std::vector<declaration>&, const std::shared_ptr<Budget>& = nullptr);
+	~Program();
+	Program(const Program&) = delete;
+	Program& operator=(const Program&) = delete;
+private:
+	friend class ExecutionContext;
+
+	std::vector<declaration> nodes;
+	std::shared_ptr<Scope> global;
+};
+
+// What one run of a program changes: its own copy of the global variables
+// and namespaces, and an executor with its scope stack, flags and caches.
+// Functions are copied too, pointing at the copied scopes, but share the
+// program's AST. A context is used by one thread at a time; contexts of
+// the same program never touch each other's state. Calls spawned in a
+// context must be done before it is destroyed; wait() waits for them.
+class ExecutionContext {
+public:
+	explicit ExecutionContext(const Program&, Profiler* = nullptr);
+	~ExecutionContext();
+	ExecutionContext(const ExecutionContext&) = delete;
+	ExecutionContext& operator=(const ExecutionContext&) = delete;
+
+	// calls main, if the program has one
+	void run();
+	// name may be qualified with namespaces
+	std::shared_ptr<Function> function(const std::string&);
+	symbol call(const std::shared_ptr<Function>&, const std::vector<symbol>&);
+	// one call for every row of columns, a column for each parameter, run
+	// over the lanes of a Batch where the function allows
+	std::vector<double> batch(const std::shared_ptr<Function>&, const std::vector<std::vector<double>>&);
+	// charges the runs and calls from now on to budget; null for none
+	void limit(const std::shared_ptr<Budget>&);
+	// returns once the calls spawned in the context have finished, and
+	// not those of other contexts
+	void wait();
+private:
+	Executor executor;
+};
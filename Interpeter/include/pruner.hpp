@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.hpp"
+#include "stats.hpp"
+
+// Removes from an analyzed program what can never run, before it is
+// optimized and executed:
+//  - statements after a return, break or continue in the same block
+//  - if branches and while loops whose condition is a literal or a const
+//    global initialized with one
+//  - functions, extern functions and global variables, in namespaces or
+//    not, that cannot be reached from the entry function and from the
+//    initializers of the globals that are kept
+// Globals whose initializer is not a literal are always kept, since running
+// it may have effects. A name is resolved to every declaration it could
+// refer to from where it is used, so nothing it might mean is removed. It
+// runs after the analyzer, so code it removes is still checked.
+class Pruner {
+public:
+	explicit Pruner(Stats* = nullptr);
+	// entry may be qualified with namespaces
+	void prune(std::vector<declaration>&, const std::string& entry = "main");
+
+	std::size_t declarations() const { return declCount; }
+	std::size_t statements() const { return stmtCount; }
+private:
+	struct Entry {
+		declaration decl;
+		std::string space;
+	};
+
+	void index(const std::vector<declaration>&, const std::string&);
+	void simplify(std::vector<declaration>&, const std::string&);
+	statement simplify(const statement&);
+	void reach(const std::string&, const std::string&);
+	void mark(const statement&, const std::string&);
+	void mark(const expression&, const std::string&);
+	void sweep(std::vector<declaration>&, const std::string&);
+
+	bool constant(const statement&, bool&) const;
+	bool constant(const expression&, bool&) const;
+	void declared(const statement&);
+	void removed(std::size_t, const std::string&);
+
+	Stats* stats;
+	// declarations by qualified name
+	std::unordered_map<std::string, std::vector<Entry>> names;
+	std::unordered_set<std::string> used;
+	std::vector<std::string> pending;
+	// namespace and local names of the function being simplified
+	std::string space;
+	std::unordered_set<std::string> locals;
+	std::size_t declCount = 0, stmtCount = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Regular expressions behind regex_match and regex_search. A pattern is
+// compiled once into a Thompson NFA over bytes. Plain yes/no questions run
+// on a DFA whose states are built lazily from sets of NFA states as the
+// input needs them, so each input byte costs one table lookup once the
+// cache is warm. Submatches fall back to a Pike VM simulation of the NFA,
+// with the same leftmost-first priorities as std::regex.
+//
+// Supported syntax: literals, ., [...] and [^...] with ranges, \d \w \s and
+// their negations, escaped metacharacters, ^ $, (...), (?:...), |, and the
+// quantifiers * + ? {n} {n,} {n,m}, each optionally lazy with a trailing ?.
+namespace regex {
+	class Regex {
+	public:
+		// throws std::runtime_error on a malformed pattern
+		explicit Regex(std::string_view pattern);
+		~Regex();
+
+		const std::string& pattern() const { return source; }
+		// number of capture groups, not counting the whole match
+		std::size_t groups() const { return captures; }
+
+		// the whole of s matches
+		bool match(std::string_view s);
+		// some substring of s matches
+		bool search(std::string_view s);
+
+		// As above, and fills groups with the whole match followed by each
+		// capture group; groups that took no part in the match are empty.
+		bool match(std::string_view s, std::vector<std::string>& groups);
+		bool search(std::string_view s, std::vector<std::string>& groups);
+
+	private:
+		struct Instruction {
+			enum Op { Byte, Split, Jump, Save, Reset, Begin, End, Match } op;
+			int x = 0, y = 0;
+		};
+		struct Dfa;
+
+		friend class Compiler;
+
+		void closure(Dfa&, std::vector<int>&, int pc, bool begin, bool end) const;
+		void reset(Dfa&);
+		int add_state(Dfa&, std::vector<int>);
+		int step(Dfa&, int state, unsigned char);
+		bool run(Dfa&, std::string_view);
+		bool simulate(std::string_view, bool anchored, std::vector<std::string>&);
+
+		std::string source;
+		std::size_t captures = 0;
+		std::vector<Instruction> program;
+		std::vector<std::bitset<256>> classes;
+		std::bitset<256> starts;
+		std::unique_ptr<Dfa> anchored, floating;
+
+		// Pike VM thread lists, kept between calls to save allocating them.
+		// Thread k's capture positions are slab[k * width, (k + 1) * width).
+		struct Threads {
+			std::vector<int> pcs;
+			std::vector<std::size_t> slab;
+		};
+		Threads current, next;
+		std::vector<std::size_t> marks, caps;
+	};
+}
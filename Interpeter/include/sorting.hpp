@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Sorting and searching behind the array builtins, instantiated for every
+// array element type. Arrays of at least SORT_THRESHOLD elements are sorted
+// as runs on separate threads and merged in parallel; smaller ones use the
+// standard introsort.
+namespace sorting {
+	constexpr std::size_t SORT_THRESHOLD = 1 << 16;
+
+	template <typename T>
+	void sort(std::vector<T>&);
+
+	template <typename T>
+	void stable_sort(std::vector<T>&);
+
+	// sorts the k smallest elements into the front of the array
+	template <typename T>
+	void partial_sort(std::vector<T>&, std::size_t k);
+
+	// index of the first element not less than the value, in a sorted array
+	template <typename T>
+	std::size_t lower_bound(const std::vector<T>&, const T&);
+
+	template <typename T>
+	bool binary_search(const std::vector<T>&, const T&);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+struct PhaseStats {
+	std::string name;
+	double wall_ms = 0;
+	double cpu_ms = 0;
+	long peak_rss_delta_kb = 0;
+	std::size_t allocations = 0;
+	std::size_t allocated_bytes = 0;
+};
+
+class Stats {
+public:
+	class Phase {
+	public:
+		Phase(Stats*, const std::string&);
+		~Phase();
+		Phase(const Phase&) = delete;
+		Phase& operator=(const Phase&) = delete;
+	private:
+		Stats* stats;
+		PhaseStats phase;
+		double wall_start, cpu_start;
+		long rss_start;
+		std::size_t allocations_start, bytes_start;
+	};
+
+	void count(const std::string&, std::size_t);
+	// a line of text about what was done, such as an expression moved out
+	// of a loop
+	void note(const std::string& kind, std::size_t line, const std::string& text);
+	void report(std::ostream&, bool json) const;
+
+	// called by the operator new of heap.cpp; without it allocations are
+	// not counted
+	static void counted(std::size_t bytes);
+	static std::size_t allocations();
+	static std::size_t allocated_bytes();
+	static long peak_rss_kb();
+private:
+	std::vector<PhaseStats> phases;
+	std::vector<std::pair<std::string, std::size_t>> counters;
+	struct Note {
+		std::string kind;
+		std::size_t line;
+		std::string text;
+	};
+	std::vector<Note> notes;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Substring search and comparison behind the string builtins. find compares
+// the first and last byte of the needle against 16 or 32 positions at once
+// (SSE2, or AVX2 when the CPU has it) and only calls memcmp on positions
+// where both match.
+namespace strings {
+	constexpr std::size_t npos = std::string_view::npos;
+
+	std::size_t find(std::string_view haystack, std::string_view needle, std::size_t from = 0);
+
+	// non-overlapping occurrences; an empty needle is never counted
+	std::size_t count(std::string_view haystack, std::string_view needle);
+
+	std::string replace(std::string_view s, std::string_view from, std::string_view to);
+
+	std::vector<std::string> split(std::string_view s, std::string_view separator);
+
+	bool equal(std::string_view a, std::string_view b);
+	bool starts_with(std::string_view s, std::string_view prefix);
+	bool ends_with(std::string_view s, std::string_view suffix);
+
+	const char* isa();
+}
@@ -1,45 +1,93 @@
-#pragma once
-
-#include <memory>
-#include <string>
-#include <variant>
-
-
-struct Value {
-    virtual ~Value() noexcept = default;
-};
-
-struct Rvalue : public Value {
-    virtual ~Rvalue() noexcept = default;
-};
-
-struct IntValue : public Rvalue {
-    int value;
-    IntValue(int value = 0) : value(value) {}
-};
-
-struct DoubleValue : public Rvalue {
-    double value;
-    DoubleValue(double value = 0) : value(value) {}
-};
-
-struct CharValue : public Rvalue {
-    char value;
-    CharValue(char value = 0) : value(value) {}
-};
-
-struct BoolValue : public Rvalue {
-    bool value;
-    BoolValue(bool value = 0) : value(value) {}
-};
-
-struct StringValue : public Rvalue {
-    std::string value;
-    StringValue(const std::string& value = "") : value(value) {} 
-};
-
-struct Lvalue : public Value {
-    std::shared_ptr<Rvalue> value;
-    Lvalue(const std::shared_ptr<Value>& value = nullptr)
-    	: value(std::dynamic_pointer_cast<Rvalue>(value)) {}
-};
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "hashmap.hpp"
+
+struct Value {
+    virtual ~Value() noexcept = default;
+};
+
+struct Rvalue : public Value {
+    virtual ~Rvalue() noexcept = default;
+};
+
+struct IntValue : public Rvalue {
+    int value;
+    IntValue(int value = 0) : value(value) {}
+};
+
+struct DoubleValue : public Rvalue {
+    double value;
+    DoubleValue(double value = 0) : value(value) {}
+};
+
+struct CharValue : public Rvalue {
+    char value;
+    CharValue(char value = 0) : value(value) {}
+};
+
+struct BoolValue : public Rvalue {
+    bool value;
+    BoolValue(bool value = 0) : value(value) {}
+};
+
+struct StringValue : public Rvalue {
+    std::string value;
+    StringValue(std::string value = "") : value(std::move(value)) {}
+};
+
+// elements are stored unboxed; bool arrays use one byte per element
+struct ArrayValue : public Rvalue {
+    using Elements = std::variant<std::vector<int>, std::vector<double>, std::vector<char>, std::vector<unsigned char>, std::vector<std::string>>;
+    Elements elements;
+    ArrayValue(Elements elements = {}) : elements(std::move(elements)) {}
+
+    std::size_t size() const {
+        return std::visit([](auto& v) { return v.size(); }, elements);
+    }
+};
+
+// keys and values are stored unboxed in an open-addressing table, bools as
+// one byte like in arrays
+struct MapValue : public Rvalue {
+    using Table = std::variant<
+        HashMap<int, int>, HashMap<int, double>, HashMap<int, char>, HashMap<int, unsigned char>, HashMap<int, std::string>,
+        HashMap<char, int>, HashMap<char, double>, HashMap<char, char>, HashMap<char, unsigned char>, HashMap<char, std::string>,
+        HashMap<std::string, int>, HashMap<std::string, double>, HashMap<std::string, char>, HashMap<std::string, unsigned char>, HashMap<std::string, std::string>>;
+    Table table;
+    MapValue(const Table& table = {}) : table(table) {}
+
+    std::size_t size() const {
+        return std::visit([](auto& t) { return t.size(); }, table);
+    }
+};
+
+// a spawned call; await blocks until done is set
+struct TaskState {
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool done = false;
+    std::shared_ptr<Value> value;
+    std::exception_ptr error;
+};
+
+// handle returned by spawn; copies refer to the same task, and a future
+// that was declared but never assigned has none
+struct FutureValue : public Rvalue {
+    std::shared_ptr<TaskState> task;
+    FutureValue(std::shared_ptr<TaskState> task = nullptr) : task(std::move(task)) {}
+};
+
+struct Lvalue : public Value {
+    std::shared_ptr<Rvalue> value;
+    Lvalue(const std::shared_ptr<Value>& value = nullptr)
+    	: value(std::dynamic_pointer_cast<Rvalue>(value)) {}
+};
@@ -1,186 +1,309 @@
-#pragma once
-
-#include <functional>
-#include <stdexcept>
-#include <unordered_map>
-#include <unordered_set>
-
-#include "ast.hpp"
-#include "symbol.hpp"
-
-using symbol = std::shared_ptr<Symbol>;
-
-class Visitor {
-public:
-	virtual void visit(Namespace_decl&) = 0;
-	virtual void visit(Variables_decl&) = 0;
-	virtual void visit(ConstVariable&) = 0;
-	virtual void visit(Functions_decl&) = 0;
-
-	virtual void visit(Expression_statement&) = 0;
-	virtual void visit(Block_statement&) = 0;
-	virtual void visit(Decl_statement&) = 0;
-	virtual void visit(While_statement&) = 0;
-	virtual void visit(For_statement&) = 0;
-	virtual void visit(ConditionalBlock&) = 0;
-	virtual void visit(ConditionalBranches&) = 0;
-	virtual void visit(Continue_statement&) = 0;
-	virtual void visit(Break_statement&) = 0;
-	virtual void visit(Return_statement&) = 0;
-
-	virtual void visit(BinaryNode&) = 0;
-	virtual void visit(TernaryNode&) = 0;
-	virtual void visit(PrefixNode&) = 0;
-	virtual void visit(PostfixNode&) = 0;
-	virtual void visit(FunctionNode&) = 0;
-	virtual void visit(IdentifierNode&) = 0;
-	virtual void visit(ParenthesizedNode&) = 0;
-	virtual void visit(IntNode&) = 0;
-	virtual void visit(CharNode&) = 0;
-	virtual void visit(BoolNode&) = 0;	
-	virtual void visit(StringNode&) = 0;
-	virtual void visit(DoubleNode&) = 0;
-};
-
-class Printer : public Visitor {
-public:
-	void visit(Namespace_decl&);
-	void visit(Variables_decl&);
-	void visit(ConstVariable&);
-	void visit(Functions_decl&);
-
-	void visit(Expression_statement&);
-	void visit(Block_statement&);
-	void visit(Decl_statement&);
-	void visit(While_statement&);
-	void visit(For_statement&);
-	void visit(ConditionalBlock&);
-	void visit(ConditionalBranches&);
-	void visit(Continue_statement&);
-	void visit(Break_statement&);
-	void visit(Return_statement&);
-
-	void visit(BinaryNode&);
-	void visit(TernaryNode&);
-	void visit(PrefixNode&);
-	void visit(PostfixNode&);
-	void visit(FunctionNode&);
-	void visit(IdentifierNode&);
-	void visit(ParenthesizedNode&);
-	void visit(IntNode&);
-	void visit(CharNode&);
-	void visit(BoolNode&);	
-	void visit(StringNode&);
-	void visit(DoubleNode&);
-
-	void print(std::vector<declaration>&);
-};
-
-class Analyzer : public Visitor {
-public:
-	void analyze(std::vector<declaration>&);
-
-	void visit(Namespace_decl&);
-	void visit(Variables_decl&);
-	void visit(ConstVariable&);
-	void visit(Functions_decl&);
-
-	void visit(Expression_statement&);
-	void visit(Block_statement&);
-	void visit(Decl_statement&);
-	void visit(While_statement&);
-	void visit(For_statement&);
-	void visit(ConditionalBlock&);
-	void visit(ConditionalBranches&);
-	void visit(Continue_statement&);
-	void visit(Break_statement&);
-	void visit(Return_statement&);
-
-	void visit(BinaryNode&);
-	void visit(TernaryNode&);
-	void visit(PrefixNode&);
-	void visit(PostfixNode&);
-	void visit(FunctionNode&);
-	void visit(IdentifierNode&);
-	void visit(ParenthesizedNode&);
-	
-	void visit(IntNode&);
-	void visit(CharNode&);
-	void visit(BoolNode&);	
-	void visit(StringNode&);
-	void visit(DoubleNode&);
-
-private:
-	std::shared_ptr<Type> newType(std::string&);
-	std::shared_ptr<Value> newValue(std::string&);
-	void add(std::string&, const std::shared_ptr<Symbol>&);
-	bool lookup(std::string&);
-	std::shared_ptr<Symbol> get_symbol(std::string&);
-
-	static const std::unordered_set<std::string> assignment_operators;
-	static const std::unordered_set<std::string> binary_operators;
-	static const std::unordered_set<std::string> compare_operators;
-	static const std::unordered_set<std::string> logical_operators;
-	
-	
-	std::size_t loopCount = 0;
-	
-	bool returnFlag; 
-	std::shared_ptr<Type> returnType;
-	
-	std::shared_ptr<Symbol> result;
-	ScopeManager scopeManager;
-};
-
-
-class Executor : public Visitor {
-public:
-	void execute(std::vector<declaration>&);
-
-	void visit(Namespace_decl&);
-	void visit(Variables_decl&);
-	void visit(ConstVariable&);
-	void visit(Functions_decl&);
-
-	void visit(Expression_statement&);
-	void visit(Block_statement&);
-	void visit(Decl_statement&);
-	void visit(While_statement&);
-	void visit(For_statement&);
-	void visit(ConditionalBlock&);
-	void visit(ConditionalBranches&);
-	void visit(Continue_statement&);
-	void visit(Break_statement&);
-	void visit(Return_statement&);
-
-	void visit(BinaryNode&);
-	void visit(TernaryNode&);
-	void visit(PrefixNode&);
-	void visit(PostfixNode&);
-	void visit(FunctionNode&);
-	void visit(IdentifierNode&);
-	void visit(ParenthesizedNode&);
-	
-	void visit(IntNode&);
-	void visit(CharNode&);
-	void visit(BoolNode&);	
-	void visit(StringNode&);
-	void visit(DoubleNode&);
-
-private:
-	std::shared_ptr<Type> newType(std::string&);
-	std::shared_ptr<Value> newValue(std::string&);
-	void add(std::string&, const symbol&);
-	symbol get_symbol(std::string&);
-	bool check_condition();
-
-	static const std::unordered_map<std::string, std::function<void(symbol)>> InOutFunctions;
-	static const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> binary_operations;
-	static const std::unordered_map<std::string, std::function<symbol(symbol)>> prefix_operations;
-	static const std::unordered_map<std::string, std::function<symbol(symbol)>> postfix_operations;
-	
-	bool returnFlag = false, continueFlag = false, breakFlag = false, condFlag = false; 
-	
-	symbol result;
-	ScopeManager scopeManager;
-};
+#pragma once
+
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast.hpp"
+#include "budget.hpp"
+#include "regex.hpp"
+#include "symbol.hpp"
+
+using symbol = std::shared_ptr<Symbol>;
+
+class Visitor {
+public:
+	virtual void visit(Namespace_decl&) = 0;
+	virtual void visit(Variables_decl&) = 0;
+	virtual void visit(ConstVariable&) = 0;
+	virtual void visit(Array_decl&) = 0;
+	virtual void visit(Functions_decl&) = 0;
+	virtual void visit(Extern_decl&) = 0;
+
+	virtual void visit(Expression_statement&) = 0;
+	virtual void visit(Block_statement&) = 0;
+	virtual void visit(Decl_statement&) = 0;
+	virtual void visit(While_statement&) = 0;
+	virtual void visit(For_statement&) = 0;
+	virtual void visit(ForEach_statement&) = 0;
+	virtual void visit(Switch_statement&) = 0;
+	virtual void visit(ConditionalBlock&) = 0;
+	virtual void visit(ConditionalBranches&) = 0;
+	virtual void visit(Continue_statement&) = 0;
+	virtual void visit(Break_statement&) = 0;
+	virtual void visit(Return_statement&) = 0;
+
+	virtual void visit(BinaryNode&) = 0;
+	virtual void visit(TernaryNode&) = 0;
+	virtual void visit(PrefixNode&) = 0;
+	virtual void visit(PostfixNode&) = 0;
+	virtual void visit(FunctionNode&) = 0;
+	virtual void visit(SpawnNode&) = 0;
+	virtual void visit(AwaitNode&) = 0;
+	virtual void visit(IndexNode&) = 0;
+	virtual void visit(IdentifierNode&) = 0;
+	virtual void visit(HoistedNode&) = 0;
+	virtual void visit(ParenthesizedNode&) = 0;
+	virtual void visit(IntNode&) = 0;
+	virtual void visit(CharNode&) = 0;
+	virtual void visit(BoolNode&) = 0;	
+	virtual void visit(StringNode&) = 0;
+	virtual void visit(DoubleNode&) = 0;
+};
+
+class Printer : public Visitor {
+public:
+	void visit(Namespace_decl&);
+	void visit(Variables_decl&);
+	void visit(ConstVariable&);
+	void visit(Array_decl&);
+	void visit(Functions_decl&);
+	void visit(Extern_decl&);
+
+	void visit(Expression_statement&);
+	void visit(Block_statement&);
+	void visit(Decl_statement&);
+	void visit(While_statement&);
+	void visit(For_statement&);
+	void visit(ForEach_statement&);
+	void visit(Switch_statement&);
+	void visit(ConditionalBlock&);
+	void visit(ConditionalBranches&);
+	void visit(Continue_statement&);
+	void visit(Break_statement&);
+	void visit(Return_statement&);
+
+	void visit(BinaryNode&);
+	void visit(TernaryNode&);
+	void visit(PrefixNode&);
+	void visit(PostfixNode&);
+	void visit(FunctionNode&);
+	void visit(SpawnNode&);
+	void visit(AwaitNode&);
+	void visit(IndexNode&);
+	void visit(IdentifierNode&);
+	void visit(HoistedNode&);
+	void visit(ParenthesizedNode&);
+	void visit(IntNode&);
+	void visit(CharNode&);
+	void visit(BoolNode&);	
+	void visit(StringNode&);
+	void visit(DoubleNode&);
+
+	void print(std::vector<declaration>&);
+};
+
+class Analyzer : public Visitor {
+public:
+	void analyze(std::vector<declaration>&);
+	std::size_t symbol_count() const;
+
+	void visit(Namespace_decl&);
+	void visit(Variables_decl&);
+	void visit(ConstVariable&);
+	void visit(Array_decl&);
+	void visit(Functions_decl&);
+	void visit(Extern_decl&);
+
+	void visit(Expression_statement&);
+	void visit(Block_statement&);
+	void visit(Decl_statement&);
+	void visit(While_statement&);
+	void visit(For_statement&);
+	void visit(ForEach_statement&);
+	void visit(Switch_statement&);
+	void visit(ConditionalBlock&);
+	void visit(ConditionalBranches&);
+	void visit(Continue_statement&);
+	void visit(Break_statement&);
+	void visit(Return_statement&);
+
+	void visit(BinaryNode&);
+	void visit(TernaryNode&);
+	void visit(PrefixNode&);
+	void visit(PostfixNode&);
+	void visit(FunctionNode&);
+	void visit(SpawnNode&);
+	void visit(AwaitNode&);
+	void visit(IndexNode&);
+	void visit(IdentifierNode&);
+	void visit(HoistedNode&);
+	void visit(ParenthesizedNode&);
+	
+	void visit(IntNode&);
+	void visit(CharNode&);
+	void visit(BoolNode&);	
+	void visit(StringNode&);
+	void visit(DoubleNode&);
+
+private:
+	std::shared_ptr<Type> newType(std::string&);
+	std::shared_ptr<Value> newValue(std::string&);
+	void add(std::string&, const std::shared_ptr<Symbol>&);
+	bool lookup(std::string&);
+	std::shared_ptr<Symbol> get_symbol(std::string&);
+	static void check_container(const std::shared_ptr<Type>&, const std::shared_ptr<Type>&);
+	static void check_key(const std::shared_ptr<MapType>&, const std::shared_ptr<Type>&);
+	void check_parallel(For_statement&);
+	bool shared(const std::string&, const std::shared_ptr<Scope>&);
+	bool counter(expression);
+	void written(const expression&, const std::string&);
+	void side_effect(const std::string&);
+
+	static const std::unordered_set<std::string> assignment_operators;
+	static const std::unordered_set<std::string> binary_operators;
+	static const std::unordered_set<std::string> compare_operators;
+	static const std::unordered_set<std::string> logical_operators;
+	
+	
+	std::size_t loopCount = 0;
+	std::size_t symbolCount = 0;
+	
+	bool returnFlag; 
+	std::shared_ptr<Type> returnType;
+	
+	std::shared_ptr<Symbol> result;
+	std::shared_ptr<Scope> qualifier;
+	ScopeManager scopeManager;
+
+	// the body of a parallel for being checked; names found in scope or
+	// above it are shared between the iterations
+	struct Parallel {
+		std::shared_ptr<Scope> scope;
+		std::string counter;
+		std::unordered_map<std::string, std::size_t> reads, reductions;
+		std::size_t loops = 0;
+	};
+	Parallel* parallel = nullptr;
+
+	// functions that write outside their own scope or do I/O, which a
+	// parallel for may not call
+	std::unordered_set<const Symbol*> impure;
+	// variables declared outside functions and not const, and the functions
+	// that read them, directly or through a call, which spawn may not start
+	// next to a caller that can write them
+	std::unordered_set<const Symbol*> globals, readers;
+	std::shared_ptr<Function> function;
+	std::shared_ptr<Scope> functionScope;
+	// user function of the call checked last
+	std::shared_ptr<Function> called;
+};
+
+
+class Profiler;
+struct TaskGroup;
+
+class Executor : public Visitor {
+public:
+	explicit Executor(Profiler* = nullptr);
+	// runs over an existing global scope instead of a fresh one
+	explicit Executor(const std::shared_ptr<Scope>& global, Profiler* = nullptr);
+	~Executor();
+	void execute(std::vector<declaration>&);
+	const std::shared_ptr<Scope>& globals() const;
+	// every loop iteration, call and allocation from now on is charged to
+	// budget, which is shared with the loops and calls this executor starts on
+	// other threads; null for none
+	void limit(const std::shared_ptr<Budget>&);
+	// the calls spawned by this executor and the executors of those calls
+	const std::shared_ptr<TaskGroup>& spawned() const;
+	void reset();
+	std::shared_ptr<Function> function(const std::string&);
+	symbol call(const std::shared_ptr<Function>&, const std::vector<symbol>&);
+
+	void visit(Namespace_decl&);
+	void visit(Variables_decl&);
+	void visit(ConstVariable&);
+	void visit(Array_decl&);
+	void visit(Functions_decl&);
+	void visit(Extern_decl&);
+
+	void visit(Expression_statement&);
+	void visit(Block_statement&);
+	void visit(Decl_statement&);
+	void visit(While_statement&);
+	void visit(For_statement&);
+	void visit(ForEach_statement&);
+	void visit(Switch_statement&);
+	void visit(ConditionalBlock&);
+	void visit(ConditionalBranches&);
+	void visit(Continue_statement&);
+	void visit(Break_statement&);
+	void visit(Return_statement&);
+
+	void visit(BinaryNode&);
+	void visit(TernaryNode&);
+	void visit(PrefixNode&);
+	void visit(PostfixNode&);
+	void visit(FunctionNode&);
+	void visit(SpawnNode&);
+	void visit(AwaitNode&);
+	void visit(IndexNode&);
+	void visit(IdentifierNode&);
+	void visit(HoistedNode&);
+	void visit(ParenthesizedNode&);
+	
+	void visit(IntNode&);
+	void visit(CharNode&);
+	void visit(BoolNode&);	
+	void visit(StringNode&);
+	void visit(DoubleNode&);
+
+private:
+	std::shared_ptr<Type> newType(std::string&);
+	std::shared_ptr<Value> newValue(std::string&);
+	void add(std::string&, const symbol&);
+	symbol get_symbol(std::string&);
+	bool check_condition();
+	void step() {
+		if (budget) {
+			if (!credit) credit = budget->take();
+			credit--;
+		}
+	}
+
+	// element last read through an IndexNode, for storing modifications back
+	struct Element {
+		std::shared_ptr<ArrayValue> array;
+		std::size_t index = 0;
+		std::shared_ptr<MapValue> map;
+		symbol key;
+
+		explicit operator bool() const { return array || map; }
+	};
+	void store(const Element&, const symbol&);
+	bool append(BinaryNode&);
+	void for_each_line(ForEach_statement&, FunctionNode&);
+	void run_parallel(For_statement&);
+	void run_chunk(For_statement&, const std::shared_ptr<Scope>&, std::string&, int, int, std::vector<symbol>&);
+	void call_native(const NativeFunction&, FunctionNode&);
+	void hoist(const std::vector<std::string>&);
+	std::vector<std::shared_ptr<IntValue>> induce(const std::vector<Induction>&);
+
+	static const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> InOutFunctions;
+	static const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> ArrayFunctions;
+	static const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> StringFunctions;
+	static const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> FileFunctions;
+	static const std::unordered_set<std::string> assignment_operators;
+	static const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> binary_operations;
+	static const std::unordered_map<std::string, std::function<symbol(symbol)>> prefix_operations;
+	static const std::unordered_map<std::string, std::function<symbol(symbol)>> postfix_operations;
+	
+	bool returnFlag = false, continueFlag = false, breakFlag = false, condFlag = false; 
+	
+	symbol result;
+	ScopeManager scopeManager;
+
+	Profiler* profiler;
+	std::shared_ptr<Budget> budget;
+	// steps taken from the budget and not used yet
+	std::uint64_t credit = 0;
+	std::shared_ptr<TaskGroup> tasks;
+	std::string nameSpace;
+	std::shared_ptr<Scope> qualifier;
+	Element element;
+	std::unordered_map<const StringNode*, symbol> literals;
+	// compiled regex_match/regex_search patterns, one per call site
+	std::unordered_map<const FunctionNode*, std::unique_ptr<regex::Regex>> patterns;
+};
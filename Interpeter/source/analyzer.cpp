@@ -43,6 +43,7 @@ void Analyzer::visit(Variables_decl& root) {
 					throw std::runtime_error("invalid conversion from arithmetic type to compound type");
 				}
 			}
+			check_container(type, currType);
 		}
 		auto lvalue = std::make_shared<Lvalue>();
 		add(name, std::make_shared<Variable>(type, lvalue));	
@@ -77,12 +78,38 @@ void Analyzer::visit(ConstVariable& root) {
 					throw std::runtime_error("invalid conversion from arithmetic type to compound type");
 				}
 			}
+			check_container(type, currType);
 		}
 		auto rvalue = std::make_shared<Rvalue>();
 		add(name, std::make_shared<ConstVar>(type, rvalue));	
 	}
 }
 
+void Analyzer::visit(Array_decl& root) {
+	auto element = newType(root.type);
+	if (auto test = std::dynamic_pointer_cast<VoidType>(element); test) {
+		throw std::runtime_error("array of void");
+	} else if (auto test = std::dynamic_pointer_cast<ArrayType>(element); test) {
+		throw std::runtime_error("arrays of arrays are not supported");
+	} else if (auto test = std::dynamic_pointer_cast<MapType>(element); test) {
+		throw std::runtime_error("arrays of maps are not supported");
+	} else if (auto test = std::dynamic_pointer_cast<FutureType>(element); test) {
+		throw std::runtime_error("arrays of futures are not supported");
+	}
+
+	for (auto& var : root.vars) {
+		if (var.second) {
+			result = nullptr;
+			var.second->accept(*this);
+			auto size = std::dynamic_pointer_cast<Variable>(result);
+			if (!size || !std::dynamic_pointer_cast<IntegralType>(size->type)) {
+				throw std::runtime_error("size of array " + var.first + " has non-integral type");
+			}
+		}
+		add(var.first, std::make_shared<Variable>(std::make_shared<ArrayType>(element), std::make_shared<Lvalue>()));
+	}
+}
+
 void Analyzer::visit(Functions_decl& root) {
 	auto type = newType(root.type);
 	auto name = root.name;
@@ -97,9 +124,11 @@ void Analyzer::visit(Functions_decl& root) {
 		arguments.push_back(std::make_pair(paramName, symbol));
 	}
 
-	add(name, std::make_shared<Function>(type, arguments, root.block_statement));
+	auto func = std::make_shared<Function>(type, arguments, root.block_statement);
+	add(name, func);
 
 	scopeManager.enterScope();
+	function = func; functionScope = scopeManager.scopes.top();
 	for (auto& arg : arguments) {
 		auto argName = arg.first;
 		auto symbol = arg.second;
@@ -109,10 +138,33 @@ void Analyzer::visit(Functions_decl& root) {
 	returnType = type; returnFlag = false;
 	root.block_statement->accept(*this);
 	if (auto test = std::dynamic_pointer_cast<VoidType>(type); !test && !returnFlag) throw std::runtime_error("no return statement in function returning non-void");
+	root.pure = !impure.contains(func.get());
 	returnType = nullptr; returnFlag = false; 
+	function = nullptr; functionScope = nullptr;
 	scopeManager.exitScope();
 }
 
+// a C function can do anything, so calling one counts as a side effect
+void Analyzer::visit(Extern_decl& root) {
+	static const std::unordered_set<std::string> scalars = {"int", "double", "char", "bool", "string"};
+	if (root.type != "void" && !scalars.contains(root.type)) {
+		throw std::runtime_error("extern function " + root.name + " cannot return " + root.type);
+	}
+	std::vector<std::pair<std::string, std::shared_ptr<Symbol>>> arguments;
+	for (auto& param : root.parameters) {
+		if (!scalars.contains(param.first)) {
+			throw std::runtime_error("extern function " + root.name + " cannot take " + param.first);
+		}
+		auto symbol = std::make_shared<Variable>(newType(param.first), std::make_shared<Lvalue>(newValue(param.first)));
+		arguments.push_back(std::make_pair(param.second, symbol));
+	}
+	auto type = newType(root.type);
+	statement body;
+	auto func = std::make_shared<Function>(type, arguments, body);
+	add(root.name, func);
+	impure.insert(func.get());
+}
+
 void Analyzer::visit(Expression_statement& root) {
 	root.expr->accept(*this);
 }
@@ -135,11 +187,13 @@ void Analyzer::visit(While_statement& root) {
 			throw std::runtime_error("not expression statement after while()");
 		}
 		root.cond->accept(*this);
+		if (parallel) parallel->loops++;
 		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
 			scopeManager.enterScope(); loopCount++; root.body->accept(*this); loopCount--; scopeManager.exitScope(); 
 		} else {
 			root.body->accept(*this);
 		}		
+		if (parallel) parallel->loops--;
 	} else {
 		throw std::runtime_error("there is no expression in while()");
 	}
@@ -148,6 +202,11 @@ void Analyzer::visit(While_statement& root) {
 void Analyzer::visit(For_statement& root) {
 	if (!root.cond)
 		throw std::runtime_error("there is no condition expression if for()");
+	if (root.parallel) {
+		check_parallel(root);
+		return;
+	}
+	if (parallel) parallel->loops++;
 	scopeManager.enterScope();
 	if (root.var) {
 		root.var->accept(*this);
@@ -160,6 +219,127 @@ void Analyzer::visit(For_statement& root) {
 	}
 	root.Expr->accept(*this);
 	scopeManager.exitScope();
+	if (parallel) parallel->loops--;
+}
+
+// Iterations of a parallel for run in any order and at the same time, so
+// the body may only read what it shares with other iterations, store into
+// the element a[i] of an outer array at the counter i, and add to outer int
+// or double variables with +=. Those variables become the loop's
+// reductions: every chunk of iterations adds into its own copy, and the
+// copies are added back afterwards.
+void Analyzer::check_parallel(For_statement& root) {
+	if (parallel) {
+		throw std::runtime_error("nested parallel for");
+	}
+	auto form = std::runtime_error("parallel for has to have the form for (int i = a; i < b; i++)");
+	auto decl = std::dynamic_pointer_cast<Decl_statement>(root.var);
+	auto vars = decl ? std::dynamic_pointer_cast<Variables_decl>(decl->var) : nullptr;
+	if (!vars || std::dynamic_pointer_cast<ConstVariable>(vars) || vars->type != "int" || vars->vars.size() != 1 || !vars->vars[0].second) {
+		throw form;
+	}
+	auto counter = vars->vars[0].first;
+	auto cond = std::dynamic_pointer_cast<Expression_statement>(root.cond);
+	auto compare = cond ? std::dynamic_pointer_cast<BinaryNode>(cond->expr) : nullptr;
+	auto left = compare ? std::dynamic_pointer_cast<IdentifierNode>(compare->left_branch) : nullptr;
+	if (!left || left->name != counter || (compare->op != "<" && compare->op != "<=")) {
+		throw form;
+	}
+	auto step = std::dynamic_pointer_cast<Expression_statement>(root.Expr);
+	expression operand;
+	if (auto postfix = step ? std::dynamic_pointer_cast<PostfixNode>(step->expr) : nullptr; postfix && postfix->op == "++") {
+		operand = postfix->branch;
+	} else if (auto prefix = step ? std::dynamic_pointer_cast<PrefixNode>(step->expr) : nullptr; prefix && prefix->op == "++") {
+		operand = prefix->branch;
+	}
+	if (auto name = std::dynamic_pointer_cast<IdentifierNode>(operand); !name || name->name != counter) {
+		throw form;
+	}
+
+	scopeManager.enterScope();
+	root.var->accept(*this);
+	Parallel loop{scopeManager.scopes.top(), counter, {}, {}, 0};
+	parallel = &loop;
+	root.cond->accept(*this);
+	if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
+		scopeManager.enterScope(); loopCount++; root.body->accept(*this); loopCount--; scopeManager.exitScope(); 
+	} else {
+		root.body->accept(*this);
+	}
+	parallel = nullptr;
+	scopeManager.exitScope();
+
+	root.reductions.clear();
+	for (auto& [name, count] : loop.reductions) {
+		if (loop.reads[name] != count) {
+			throw std::runtime_error("reduction variable " + name + " is read in parallel for");
+		}
+		root.reductions.push_back(name);
+	}
+}
+
+void Analyzer::visit(ForEach_statement& root) {
+	result = nullptr;
+	root.range->accept(*this);
+	auto range = std::dynamic_pointer_cast<Variable>(result);
+	auto varType = newType(root.type);
+	if (auto map = range ? std::dynamic_pointer_cast<MapType>(range->type) : nullptr; map) {
+		// a map is iterated over its keys
+		if (!std::dynamic_pointer_cast<ArithmeticType>(varType) != !std::dynamic_pointer_cast<ArithmeticType>(map->key)) {
+			throw std::runtime_error("invalid conversion of map key to " + root.type);
+		}
+	} else {
+		auto type = range ? std::dynamic_pointer_cast<ArrayType>(range->type) : nullptr;
+		if (!type) {
+			throw std::runtime_error("range-based for over a value that is not an array or a map");
+		}
+		if (!std::dynamic_pointer_cast<ArithmeticType>(varType) != !std::dynamic_pointer_cast<ArithmeticType>(type->element)) {
+			throw std::runtime_error("invalid conversion of array element to " + root.type);
+		}
+	}
+
+	scopeManager.enterScope(); loopCount++;
+	if (parallel) parallel->loops++;
+	add(root.name, std::make_shared<Variable>(varType, std::make_shared<Lvalue>()));
+	root.body->accept(*this);
+	if (parallel) parallel->loops--;
+	loopCount--; scopeManager.exitScope();
+}
+
+// Labels are sorted for the executor to search them, and put into a table
+// it indexes instead when at least half of the values between the lowest
+// and the highest label are labels. A break leaves the switch only.
+void Analyzer::visit(Switch_statement& root) {
+	result = nullptr;
+	root.value->accept(*this);
+	auto value = std::dynamic_pointer_cast<Variable>(result);
+	if (!value || (!std::dynamic_pointer_cast<IntType>(value->type) && !std::dynamic_pointer_cast<CharType>(value->type))) {
+		throw std::runtime_error("switch quantity is not an int or a char");
+	}
+
+	std::sort(root.cases.begin(), root.cases.end());
+	for (std::size_t i = 1; i < root.cases.size(); i++) {
+		if (root.cases[i].first == root.cases[i - 1].first) {
+			throw std::runtime_error("duplicate case value " + std::to_string(root.cases[i].first));
+		}
+	}
+	root.table.clear();
+	if (!root.cases.empty()) {
+		auto span = static_cast<long long>(root.cases.back().first) - root.cases.front().first + 1;
+		if (span <= 2 * static_cast<long long>(root.cases.size())) {
+			root.low = root.cases.front().first;
+			root.table.assign(span, root.fallback);
+			for (auto& [label, start] : root.cases) root.table[label - root.low] = start;
+		}
+	}
+
+	scopeManager.enterScope(); loopCount++;
+	if (parallel) parallel->loops++;
+	for (auto& state : root.body) {
+		state->accept(*this);
+	}
+	if (parallel) parallel->loops--;
+	loopCount--; scopeManager.exitScope();
 }
 
 void Analyzer::visit(ConditionalBlock& root) {
@@ -198,9 +378,15 @@ void Analyzer::visit(Break_statement&) {
 	if (!loopCount) {
 		throw std::runtime_error("break statement not within a loop");
 	}
+	if (parallel && !parallel->loops) {
+		throw std::runtime_error("break out of parallel for");
+	}
 }
 
 void Analyzer::visit(Return_statement& root) {
+	if (parallel) {
+		throw std::runtime_error("return out of parallel for");
+	}
 	if (auto test = std::dynamic_pointer_cast<VoidType>(returnType); test && !root.expr) {
 		throw std::runtime_error("return-statement with a value, if function returning 'void'");
 	}
@@ -225,6 +411,7 @@ void Analyzer::visit(Return_statement& root) {
 			throw std::runtime_error("invalid conversion from arithmetic type to compound type");
 		}
 	}
+	check_container(returnType, type);
 	returnFlag = true;
 }	
 
@@ -267,8 +454,18 @@ void Analyzer::visit(BinaryNode& root) {
 					}
 				}
 			}
-			
+			if (auto array = std::dynamic_pointer_cast<ArrayType>(lhs->type); array && root.op != "=") {
+				throw std::runtime_error("Invalid operation to array type");
+			}
+			if (auto map = std::dynamic_pointer_cast<MapType>(lhs->type); map && root.op != "=") {
+				throw std::runtime_error("Invalid operation to map type");
+			}
+			if (auto future = std::dynamic_pointer_cast<FutureType>(lhs->type); future && root.op != "=") {
+				throw std::runtime_error("Invalid operation to future type");
+			}
 		}
+		check_container(lhs->type, rhs->type);
+		written(root.left_branch, root.op);
 		result = lhs;
 	} else if (binary_operators.contains(root.op)) {
 		auto lhs = std::dynamic_pointer_cast<Variable>(first), rhs = std::dynamic_pointer_cast<Variable>(second);
@@ -280,7 +477,7 @@ void Analyzer::visit(BinaryNode& root) {
 					}
 					result = std::make_shared<Variable>(lhs->type, std::make_shared<Rvalue>());
 				} else {
-					throw std::runtime_error("");
+					throw std::runtime_error("Invalid operation between compound types");
 				}
 			} else {
 				throw std::runtime_error("Invalid operation between Compound type and Arithmetic Type");
@@ -309,7 +506,7 @@ void Analyzer::visit(BinaryNode& root) {
 		} else if (test1 = std::dynamic_pointer_cast<CompoundType>(lhs->type); test1) {
 			if (test1 = std::dynamic_pointer_cast<StringType>(test1); test1) {
 				if (auto test2 = std::dynamic_pointer_cast<StringType>(rhs->type); test2) {
-					if (root.op != "==") {
+					if (root.op != "==" && root.op != "!=") {
 						throw std::runtime_error("invalid operation between String types");
 					} else {
 						result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<Rvalue>());	
@@ -317,6 +514,10 @@ void Analyzer::visit(BinaryNode& root) {
 				} else {
 					throw std::runtime_error("unknown operation between such types");
 				}
+			} else if (std::dynamic_pointer_cast<MapType>(test1)) {
+				throw std::runtime_error("invalid comparison of map types");
+			} else {
+				throw std::runtime_error("invalid comparison of array types");
 			}
 		}
 	} else if (root.op == "::") {
@@ -329,9 +530,14 @@ void Analyzer::visit(BinaryNode& root) {
 				throw std::runtime_error("Invalid appeal");
 			}
 		}
-		scopeManager.enterScope(nameSpace->scope);
-		root.right_branch->accept(*this);
-		scopeManager.exitScope();	
+		if (auto call = std::dynamic_pointer_cast<FunctionNode>(root.right_branch); call) {
+			qualifier = nameSpace->scope;
+			call->accept(*this);
+		} else {
+			scopeManager.enterScope(nameSpace->scope);
+			root.right_branch->accept(*this);
+			scopeManager.exitScope();
+		}
 	}
 }
 
@@ -345,6 +551,7 @@ void Analyzer::visit(TernaryNode& root) {
 
 void Analyzer::visit(PrefixNode& root) {
 	root.branch->accept(*this);
+	if (root.op == "++" || root.op == "--") written(root.branch, root.op);
 	if (std::shared_ptr<Variable> var = std::dynamic_pointer_cast<ConstVar>(result); var) {
 		if (root.op == "++" || root.op == "--") {
 			throw std::runtime_error("unary operation on constant variable");
@@ -394,20 +601,311 @@ void Analyzer::visit(PostfixNode& root) {
 	} else if (test = std::dynamic_pointer_cast<BoolType>(var->type); test) {
 		throw std::runtime_error("Invalid unary operations with bool type");
 	}
+	written(root.branch, root.op);
 	result = std::make_shared<Variable>(var->type, std::make_shared<Rvalue>());
 }
 
 void Analyzer::visit(FunctionNode& root) {
-	if (root.name == "print") {
+	// user functions and qualified calls shadow the array builtins
+	bool builtin = !qualifier && !scopeManager.scopes.top()->lookup(root.name);
+	if (root.name == "print" || root.name == "println") {
+		side_effect(root.name);
 		for (auto& branch : root.branches) {
 			branch->accept(*this);
 		}
 		result = nullptr;
+	} else if (root.name == "input") {
+		side_effect(root.name);
+		for (auto& branch : root.branches) {
+			branch->accept(*this);
+			written(branch, root.name);
+			auto var = std::dynamic_pointer_cast<Variable>(result);
+			if (!var || std::dynamic_pointer_cast<ConstVar>(var)) {
+				throw std::runtime_error("input into a read-only object");
+			}
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); !test) {
+				throw std::runtime_error("input into a rvalue object");
+			}
+			if (auto test = std::dynamic_pointer_cast<ArrayType>(var->type); test) {
+				throw std::runtime_error("input into an array");
+			}
+			if (auto test = std::dynamic_pointer_cast<MapType>(var->type); test) {
+				throw std::runtime_error("input into a map");
+			}
+		}
+		result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "len" || root.name == "push" || root.name == "pop")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		if (args.size() != (root.name == "push" ? 2u : 1u) || !args[0]) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		auto array = std::dynamic_pointer_cast<ArrayType>(args[0]->type);
+		if (root.name == "len") {
+			if (!array && !std::dynamic_pointer_cast<StringType>(args[0]->type) && !std::dynamic_pointer_cast<MapType>(args[0]->type)) {
+				throw std::runtime_error("len of a value that is not an array, a map or a string");
+			}
+			result = std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<Rvalue>());
+			return;
+		}
+		if (!array) {
+			throw std::runtime_error(root.name + " of a value that is not an array");
+		}
+		if (std::dynamic_pointer_cast<ConstVar>(args[0]) || !std::dynamic_pointer_cast<Lvalue>(args[0]->value)) {
+			throw std::runtime_error(root.name + " of a read-only array");
+		}
+		written(root.branches[0], root.name);
+		if (root.name == "push") {
+			if (!args[1] || !std::dynamic_pointer_cast<ArithmeticType>(args[1]->type) != !std::dynamic_pointer_cast<ArithmeticType>(array->element)) {
+				throw std::runtime_error("invalid conversion to array element");
+			}
+			result = nullptr;
+		} else {
+			result = std::make_shared<Variable>(array->element, std::make_shared<Rvalue>());
+		}
+	} else if (builtin && (root.name == "find" || root.name == "count" || root.name == "replace" || root.name == "split" || root.name == "starts_with" || root.name == "ends_with")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		std::size_t strings = root.name == "replace" ? 3 : 2;
+		bool from = root.name == "find" && args.size() == 3;
+		if (args.size() != strings + from || std::find(args.begin(), args.end(), nullptr) != args.end()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		for (std::size_t i = 0; i < strings; i++) {
+			if (!std::dynamic_pointer_cast<StringType>(args[i]->type)) {
+				throw std::runtime_error(root.name + " of a value that is not a string");
+			}
+		}
+		if (from && !std::dynamic_pointer_cast<IntegralType>(args[2]->type)) {
+			throw std::runtime_error("find position is not an integer");
+		}
+		std::shared_ptr<Type> type;
+		if (root.name == "find" || root.name == "count") type = std::make_shared<IntType>();
+		else if (root.name == "replace") type = std::make_shared<StringType>();
+		else if (root.name == "split") type = std::make_shared<ArrayType>(std::make_shared<StringType>());
+		else type = std::make_shared<BoolType>();
+		result = std::make_shared<Variable>(type, std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "regex_match" || root.name == "regex_search")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		if ((args.size() != 2 && args.size() != 3) || std::find(args.begin(), args.end(), nullptr) != args.end()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		if (!std::dynamic_pointer_cast<StringType>(args[0]->type) || !std::dynamic_pointer_cast<StringType>(args[1]->type)) {
+			throw std::runtime_error(root.name + " of a value that is not a string");
+		}
+		if (args.size() == 3) {
+			auto array = std::dynamic_pointer_cast<ArrayType>(args[2]->type);
+			if (!array || !std::dynamic_pointer_cast<StringType>(array->element)) {
+				throw std::runtime_error(root.name + " groups into a value that is not a string array");
+			}
+			if (std::dynamic_pointer_cast<ConstVar>(args[2]) || !std::dynamic_pointer_cast<Lvalue>(args[2]->value)) {
+				throw std::runtime_error(root.name + " groups into a read-only array");
+			}
+			written(root.branches[2], root.name);
+		}
+		// literal patterns are checked here rather than when first run
+		if (auto literal = std::dynamic_pointer_cast<StringNode>(root.branches[1]); literal) {
+			regex::Regex{literal->value};
+		}
+		result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "read_file" || root.name == "lines" || root.name == "write_file" || root.name == "append_file")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		bool writes = root.name == "write_file" || root.name == "append_file";
+		if (writes) side_effect(root.name);
+		if (args.size() != (writes ? 2u : 1u) || std::find(args.begin(), args.end(), nullptr) != args.end()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		for (auto& arg : args) {
+			if (!std::dynamic_pointer_cast<StringType>(arg->type)) {
+				throw std::runtime_error(root.name + " of a value that is not a string");
+			}
+		}
+		std::shared_ptr<Type> type;
+		if (writes) type = std::make_shared<BoolType>();
+		else if (root.name == "lines") type = std::make_shared<ArrayType>(std::make_shared<StringType>());
+		else type = std::make_shared<StringType>();
+		result = std::make_shared<Variable>(type, std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "concat" || root.name == "join")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		if (std::find(args.begin(), args.end(), nullptr) != args.end() || (root.name == "join" && args.size() != 2)) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		if (root.name == "concat") {
+			for (auto& arg : args) {
+				if (!std::dynamic_pointer_cast<StringType>(arg->type) && !std::dynamic_pointer_cast<CharType>(arg->type)) {
+					throw std::runtime_error("concat of a value that is not a string or a char");
+				}
+			}
+		} else {
+			auto array = std::dynamic_pointer_cast<ArrayType>(args[0]->type);
+			if (!array || !std::dynamic_pointer_cast<StringType>(array->element)) {
+				throw std::runtime_error("join of a value that is not a string array");
+			}
+			if (!std::dynamic_pointer_cast<StringType>(args[1]->type)) {
+				throw std::runtime_error("join separator is not a string");
+			}
+		}
+		result = std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "contains" || root.name == "erase")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		if (args.size() != 2 || !args[0] || !args[1]) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		auto map = std::dynamic_pointer_cast<MapType>(args[0]->type);
+		if (!map) {
+			throw std::runtime_error(root.name + " of a value that is not a map");
+		}
+		check_key(map, args[1]->type);
+		if (root.name == "erase" && (std::dynamic_pointer_cast<ConstVar>(args[0]) || !std::dynamic_pointer_cast<Lvalue>(args[0]->value))) {
+			throw std::runtime_error("erase of a read-only map");
+		}
+		if (root.name == "erase") written(root.branches[0], root.name);
+		result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<Rvalue>());
+	} else if (builtin && (root.name == "sort" || root.name == "stable_sort" || root.name == "partial_sort" || root.name == "lower_bound" || root.name == "binary_search")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		bool sorts = root.name == "sort" || root.name == "stable_sort";
+		if (args.size() != (sorts ? 1u : 2u) || std::find(args.begin(), args.end(), nullptr) != args.end()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		auto array = std::dynamic_pointer_cast<ArrayType>(args[0]->type);
+		if (!array) {
+			throw std::runtime_error(root.name + " of a value that is not an array");
+		}
+		if (root.name == "lower_bound" || root.name == "binary_search") {
+			if (!std::dynamic_pointer_cast<ArithmeticType>(args[1]->type) != !std::dynamic_pointer_cast<ArithmeticType>(array->element)) {
+				throw std::runtime_error("invalid conversion to array element");
+			}
+			if (root.name == "lower_bound") result = std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<Rvalue>());
+			else result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<Rvalue>());
+			return;
+		}
+		if (std::dynamic_pointer_cast<ConstVar>(args[0]) || !std::dynamic_pointer_cast<Lvalue>(args[0]->value)) {
+			throw std::runtime_error(root.name + " of a read-only array");
+		}
+		written(root.branches[0], root.name);
+		if (root.name == "partial_sort" && !std::dynamic_pointer_cast<IntegralType>(args[1]->type)) {
+			throw std::runtime_error("partial_sort count is not an integer");
+		}
+		result = nullptr;
+	} else if (builtin && (root.name == "sum" || root.name == "min" || root.name == "max" || root.name == "dot" || root.name == "scale" || root.name == "axpy")) {
+		std::vector<std::shared_ptr<Variable>> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(std::dynamic_pointer_cast<Variable>(result));
+		}
+		std::size_t count = root.name == "axpy" ? 3 : root.name == "dot" || root.name == "scale" ? 2 : 1;
+		if (args.size() != count || std::find(args.begin(), args.end(), nullptr) != args.end()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		std::size_t first = root.name == "axpy" ? 1 : 0, last = root.name == "scale" ? 0 : count - 1;
+		std::shared_ptr<Type> element;
+		for (std::size_t i = first; i <= last; i++) {
+			auto array = std::dynamic_pointer_cast<ArrayType>(args[i]->type);
+			if (!array || (!std::dynamic_pointer_cast<IntType>(array->element) && !std::dynamic_pointer_cast<DoubleType>(array->element))) {
+				throw std::runtime_error(root.name + " of a value that is not an int or double array");
+			}
+			if (element && typeid(*element) != typeid(*array->element)) {
+				throw std::runtime_error(root.name + " of arrays of different element types");
+			}
+			element = array->element;
+		}
+		if (root.name == "scale" || root.name == "axpy") {
+			auto factor = args[root.name == "scale" ? 1 : 0], target = args[root.name == "scale" ? 0 : 2];
+			if (!std::dynamic_pointer_cast<ArithmeticType>(factor->type)) {
+				throw std::runtime_error(root.name + " by a value that is not a number");
+			}
+			if (std::dynamic_pointer_cast<ConstVar>(target) || !std::dynamic_pointer_cast<Lvalue>(target->value)) {
+				throw std::runtime_error(root.name + " of a read-only array");
+			}
+			written(root.branches[root.name == "scale" ? 0 : 2], root.name);
+			result = nullptr;
+		} else {
+			result = std::make_shared<Variable>(element, std::make_shared<Rvalue>());
+		}
+	} else if (builtin && root.name == "batch") {
+		// batch(f, columns...) calls f once for every row of the columns
+		if (root.branches.empty()) {
+			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
+		}
+		result = nullptr;
+		root.branches[0]->accept(*this);
+		auto func = std::dynamic_pointer_cast<Function>(result);
+		auto node = root.branches[0];
+		for (auto qualified = std::dynamic_pointer_cast<BinaryNode>(node); qualified && qualified->op == "::"; qualified = std::dynamic_pointer_cast<BinaryNode>(node)) {
+			node = qualified->right_branch;
+		}
+		auto named = std::dynamic_pointer_cast<IdentifierNode>(node);
+		if (!func || !named) {
+			throw std::runtime_error("batch of something that is not a function");
+		}
+		auto& name = named->name;
+		if (root.branches.size() != func->arguments.size() + 1) {
+			throw std::runtime_error("Incorrect number of arguments to function " + name);
+		}
+		auto scalar = [](const std::shared_ptr<Type>& type) {
+			return std::dynamic_pointer_cast<ArithmeticType>(type) != nullptr;
+		};
+		if (!scalar(func->returnType)) {
+			throw std::runtime_error("batch of " + name + ", which does not return a scalar");
+		}
+		for (auto& argument : func->arguments) {
+			if (!scalar(std::dynamic_pointer_cast<Variable>(argument.second)->type)) {
+				throw std::runtime_error("batch of " + name + ", which takes a parameter that is not a scalar");
+			}
+		}
+		for (std::size_t i = 1; i < root.branches.size(); i++) {
+			result = nullptr;
+			root.branches[i]->accept(*this);
+			auto column = std::dynamic_pointer_cast<Variable>(result);
+			auto array = column ? std::dynamic_pointer_cast<ArrayType>(column->type) : nullptr;
+			if (!array || !scalar(array->element)) {
+				throw std::runtime_error("batch column that is not an array of scalars");
+			}
+		}
+		if (impure.contains(func.get())) side_effect("call to " + name);
+		if (function && readers.contains(func.get())) readers.insert(function.get());
+		result = std::make_shared<Variable>(std::make_shared<ArrayType>(std::make_shared<DoubleType>()), std::make_shared<Rvalue>());
 	} else {
-		if (!lookup(root.name)) {
+		auto scope = qualifier ? qualifier : scopeManager.scopes.top();
+		qualifier = nullptr;
+		if (!scope->lookup(root.name)) {
 			throw std::runtime_error(root.name + " was not declared");
 		}
-		result = get_symbol(root.name);
+		result = scope->get_symbol(root.name);
 		
 		auto func = std::dynamic_pointer_cast<Function>(result);
 		if (!func) {
@@ -417,6 +915,8 @@ void Analyzer::visit(FunctionNode& root) {
 		if (root.branches.size() != func->arguments.size()) {
 			throw std::runtime_error("Incorrect number of arguments to function " + root.name);
 		}
+		if (impure.contains(func.get())) side_effect("call to " + root.name);
+		if (function && readers.contains(func.get())) readers.insert(function.get());
 	
 	
 		for (std::size_t i = 0; i != root.branches.size(); i++) {
@@ -432,17 +932,98 @@ void Analyzer::visit(FunctionNode& root) {
 					throw std::runtime_error("Incorrect argument");
 				}
 			}
+			check_container(param->type, arg->type);
 		}
 		
+		called = func;
 		result = std::make_shared<Variable>(func->returnType, std::make_shared<Rvalue>());
 	}
 }
 
+// The spawned function runs next to its caller, so like the body of a
+// parallel for it may not write anything outside its own scope, and since
+// the caller may be writing the global variables meanwhile it may not read
+// them either.
+void Analyzer::visit(SpawnNode& root) {
+	auto node = root.call;
+	for (auto qualified = std::dynamic_pointer_cast<BinaryNode>(node); qualified && qualified->op == "::"; qualified = std::dynamic_pointer_cast<BinaryNode>(node)) {
+		node = qualified->right_branch;
+	}
+	auto call = std::dynamic_pointer_cast<FunctionNode>(node);
+	if (!call || (node == root.call && !lookup(call->name))) {
+		throw std::runtime_error("spawn of something that is not a call to a user function");
+	}
+	called = nullptr;
+	result = nullptr;
+	root.call->accept(*this);
+	if (impure.contains(called.get())) {
+		throw std::runtime_error("spawn of " + call->name + ", which has side effects");
+	}
+	if (readers.contains(called.get())) {
+		throw std::runtime_error("spawn of " + call->name + ", which reads global variables");
+	}
+	auto returned = std::dynamic_pointer_cast<Variable>(result);
+	result = std::make_shared<Variable>(std::make_shared<FutureType>(returned->type), std::make_shared<Rvalue>());
+}
+
+void Analyzer::visit(AwaitNode& root) {
+	result = nullptr;
+	root.handle->accept(*this);
+	auto handle = std::dynamic_pointer_cast<Variable>(result);
+	auto future = handle ? std::dynamic_pointer_cast<FutureType>(handle->type) : nullptr;
+	if (!future) {
+		throw std::runtime_error("await of a value that is not a future");
+	}
+	result = std::make_shared<Variable>(future->value, std::make_shared<Rvalue>());
+}
+
+void Analyzer::visit(IndexNode& root) {
+	result = nullptr;
+	root.branch->accept(*this);
+	auto array = std::dynamic_pointer_cast<Variable>(result);
+	if (auto map = array ? std::dynamic_pointer_cast<MapType>(array->type) : nullptr; map) {
+		// reading a missing key inserts it, so the map has to be writable
+		if (!std::dynamic_pointer_cast<Lvalue>(array->value)) {
+			throw std::runtime_error("subscript of a read-only map");
+		}
+		written(root.branch, "[]");
+		result = nullptr;
+		root.index->accept(*this);
+		auto key = std::dynamic_pointer_cast<Variable>(result);
+		if (!key) {
+			throw std::runtime_error("invalid map key");
+		}
+		check_key(map, key->type);
+		result = std::make_shared<Variable>(map->value, std::make_shared<Lvalue>());
+		return;
+	}
+	auto type = array ? std::dynamic_pointer_cast<ArrayType>(array->type) : nullptr;
+	if (!type) {
+		throw std::runtime_error("subscripted value is not an array or a map");
+	}
+	root.index->accept(*this);
+	auto index = std::dynamic_pointer_cast<Variable>(result);
+	if (!index || !std::dynamic_pointer_cast<IntegralType>(index->type)) {
+		throw std::runtime_error("array subscript is not an integer");
+	}
+	if (std::dynamic_pointer_cast<Lvalue>(array->value) && !std::dynamic_pointer_cast<ConstVar>(array)) {
+		result = std::make_shared<Variable>(type->element, std::make_shared<Lvalue>());
+	} else {
+		result = std::make_shared<Variable>(type->element, std::make_shared<Rvalue>());
+	}
+}
+
 void Analyzer::visit(IdentifierNode& root) {
 	if (!lookup(root.name)) {
 		throw std::runtime_error(root.name + " was not declared");
 	}
 	result = get_symbol(root.name);
+	if (parallel && shared(root.name, parallel->scope)) parallel->reads[root.name]++;
+	if (function && globals.contains(result.get())) readers.insert(function.get());
+}
+
+void Analyzer::visit(HoistedNode& root) {
+	root.expr->accept(*this);
 }
 
 void Analyzer::visit(ParenthesizedNode& root) {
@@ -472,7 +1053,30 @@ void Analyzer::visit(DoubleNode&) {
 ///////////////////////////////////////////////////////////////////////////
 
 std::shared_ptr<Type> Analyzer::newType(std::string& type) {
-	if (type == "int") {
+	if (type.ends_with("[]")) {
+		auto element = type.substr(0, type.size() - 2);
+		auto elementType = newType(element);
+		if (std::dynamic_pointer_cast<MapType>(elementType)) {
+			throw std::runtime_error("arrays of maps are not supported");
+		}
+		if (std::dynamic_pointer_cast<FutureType>(elementType)) {
+			throw std::runtime_error("arrays of futures are not supported");
+		}
+		return std::make_shared<ArrayType>(elementType);
+	} else if (type.starts_with("map<")) {
+		auto comma = type.find(',');
+		auto key = type.substr(4, comma - 4), value = type.substr(comma + 1, type.size() - comma - 2);
+		if (key != "int" && key != "char" && key != "string") {
+			throw std::runtime_error("invalid map key type " + key);
+		}
+		if (value != "int" && value != "double" && value != "char" && value != "bool" && value != "string") {
+			throw std::runtime_error("invalid map value type " + value);
+		}
+		return std::make_shared<MapType>(newType(key), newType(value));
+	} else if (type.starts_with("future<")) {
+		auto value = type.substr(7, type.size() - 8);
+		return std::make_shared<FutureType>(newType(value));
+	} else if (type == "int") {
 		return std::make_shared<IntType>();
 	} else if (type == "double") {
 		return std::make_shared<DoubleType>();
@@ -503,7 +1107,124 @@ std::shared_ptr<Value> Analyzer::newValue(std::string& v) {
 	}
 }
 
+void Analyzer::check_container(const std::shared_ptr<Type>& to, const std::shared_ptr<Type>& from) {
+	auto leftFuture = std::dynamic_pointer_cast<FutureType>(to), rightFuture = std::dynamic_pointer_cast<FutureType>(from);
+	if (leftFuture || rightFuture) {
+		if (!leftFuture || !rightFuture || typeid(*leftFuture->value) != typeid(*rightFuture->value)) {
+			throw std::runtime_error("invalid conversion between future types");
+		}
+		check_container(leftFuture->value, rightFuture->value);
+		return;
+	}
+	auto leftMap = std::dynamic_pointer_cast<MapType>(to), rightMap = std::dynamic_pointer_cast<MapType>(from);
+	if (leftMap || rightMap) {
+		if (!leftMap || !rightMap || typeid(*leftMap->key) != typeid(*rightMap->key) || typeid(*leftMap->value) != typeid(*rightMap->value)) {
+			throw std::runtime_error("invalid conversion between map types");
+		}
+		return;
+	}
+	auto left = std::dynamic_pointer_cast<ArrayType>(to), right = std::dynamic_pointer_cast<ArrayType>(from);
+	if (!left && !right) return;
+	if (!left || !right || typeid(*left->element) != typeid(*right->element)) {
+		throw std::runtime_error("invalid conversion between array types");
+	}
+}
+
+// int and char keys take any integral key, string keys only strings
+void Analyzer::check_key(const std::shared_ptr<MapType>& map, const std::shared_ptr<Type>& key) {
+	if (std::dynamic_pointer_cast<StringType>(map->key) ? !std::dynamic_pointer_cast<StringType>(key) : !std::dynamic_pointer_cast<IntegralType>(key)) {
+		throw std::runtime_error("invalid map key type");
+	}
+}
+
+// name resolves to the same symbol here as from scope, so it was declared
+// in scope or above it
+bool Analyzer::shared(const std::string& name, const std::shared_ptr<Scope>& scope) {
+	auto symbol = scopeManager.scopes.top()->get_symbol(name);
+	return symbol && symbol == scope->get_symbol(name);
+}
+
+// index is the counter of the enclosing parallel for, not a name that hides it
+bool Analyzer::counter(expression index) {
+	while (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(index)) {
+		index = paren->expr;
+	}
+	auto name = std::dynamic_pointer_cast<IdentifierNode>(index);
+	return name && name->name == parallel->counter && shared(name->name, parallel->scope);
+}
+
+// target is modified by op: an assignment operator, ++ or --, or a builtin
+// that stores into it or changes the container itself
+void Analyzer::written(const expression& target, const std::string& op) {
+	auto node = target;
+	expression subscript;
+	while (true) {
+		if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) {
+			node = paren->expr;
+		} else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) {
+			node = index->branch;
+			subscript = index->index;
+		} else {
+			break;
+		}
+	}
+	// a stored element is checked as a subscript of the map it belongs to,
+	// and an element a[i] of an array, i the counter of a parallel for, is
+	// that iteration's own
+	if (subscript && (!parallel || counter(subscript))) return;
+	auto name = std::dynamic_pointer_cast<IdentifierNode>(node);
+	auto qualified = std::dynamic_pointer_cast<BinaryNode>(node);
+	if (!name && !(qualified && qualified->op == "::")) return;
+	if (subscript) {
+		if (!name) {
+			throw std::runtime_error("write to a namespace variable in parallel for");
+		}
+		if (shared(name->name, parallel->scope)) {
+			throw std::runtime_error("write to shared array " + name->name + " at an index other than " + parallel->counter + " in parallel for");
+		}
+		return;
+	}
+
+	std::shared_ptr<Variable> var = name ? std::dynamic_pointer_cast<Variable>(scopeManager.scopes.top()->get_symbol(name->name)) : nullptr;
+	if (function && !impure.contains(function.get())) {
+		// arrays and maps passed in are the caller's own
+		bool container = var && (std::dynamic_pointer_cast<ArrayType>(var->type) || std::dynamic_pointer_cast<MapType>(var->type));
+		if (!name || shared(name->name, container ? functionScope : functionScope->parent)) {
+			impure.insert(function.get());
+		}
+	}
+	if (!parallel) return;
+	if (!name) {
+		throw std::runtime_error("write to a namespace variable in parallel for");
+	}
+	if (!shared(name->name, parallel->scope)) return;
+	if (name->name == parallel->counter) {
+		throw std::runtime_error("parallel for counter " + name->name + " modified in the loop");
+	}
+	if (op == "+=" && var && (std::dynamic_pointer_cast<IntType>(var->type) || std::dynamic_pointer_cast<DoubleType>(var->type))) {
+		parallel->reductions[name->name]++;
+		return;
+	}
+	throw std::runtime_error("write to shared variable " + name->name + " in parallel for");
+}
+
+// name does I/O or has side effects through a function it calls
+void Analyzer::side_effect(const std::string& name) {
+	if (function) impure.insert(function.get());
+	if (parallel) {
+		throw std::runtime_error(name + " in parallel for");
+	}
+}
+
+std::size_t Analyzer::symbol_count() const {
+	return symbolCount;
+}
+
 void Analyzer::add(std::string& name, const std::shared_ptr<Symbol>& symbol) {
+	++symbolCount;
+	if (!function && std::dynamic_pointer_cast<Variable>(symbol) && !std::dynamic_pointer_cast<ConstVar>(symbol)) {
+		globals.insert(symbol.get());
+	}
 	scopeManager.scopes.top()->add(name, symbol);
 }
 
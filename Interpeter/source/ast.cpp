@@ -9,9 +9,15 @@ void Variables_decl::accept(Visitor& visitor) {
 void ConstVariable::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
+void Array_decl::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
 void Functions_decl::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
+void Extern_decl::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
 
 /////////////////////////////////////////////////////
 
@@ -30,6 +36,12 @@ void While_statement::accept(Visitor& visitor) {
 void For_statement::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
+void ForEach_statement::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+void Switch_statement::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
 void ConditionalBlock::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
@@ -63,9 +75,21 @@ void PostfixNode::accept(Visitor& visitor) {
 void FunctionNode::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
+void SpawnNode::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+void AwaitNode::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+void IndexNode::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
 void IdentifierNode::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
+void HoistedNode::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
 void ParenthesizedNode::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
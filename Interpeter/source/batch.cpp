@@ -0,0 +1,755 @@
+#include "batch.hpp"
+
+#include <cstring>
+
+#include "pool.hpp"
+
+namespace {
+	using vi2 = long long __attribute__((vector_size(16)));
+	using vd2 = double __attribute__((vector_size(16)));
+	using vi4 = long long __attribute__((vector_size(32)));
+	using vd4 = double __attribute__((vector_size(32)));
+
+	// Registers hold CHUNK 64-bit lanes each. They are stored as vectors of
+	// four, aligned for the widest width the lane program runs in: two lanes
+	// in SSE2, four when the CPU has AVX2.
+	constexpr std::size_t CHUNK = 256;
+	constexpr std::size_t STRIDE = CHUNK / 4;
+
+	// ints are kept in 64-bit lanes and truncated back to 32 bits, in place,
+	// after every operation that can overflow
+	template <typename V>
+	[[gnu::always_inline]] inline void wrap(V& x) {
+		x = (x << 32) >> 32;
+	}
+
+	template <typename V>
+	[[gnu::always_inline]] inline void wrap_char(V& x) {
+		x = (x << 56) >> 56;
+	}
+
+	bool scalar_value(const symbol& sym, LaneType& type, double& value) {
+		auto var = std::dynamic_pointer_cast<Variable>(sym);
+		if (!var) return false;
+		std::shared_ptr<Value> v = var->value;
+		if (auto lvalue = std::dynamic_pointer_cast<Lvalue>(v); lvalue) v = lvalue->value;
+		if (auto tmp = std::dynamic_pointer_cast<IntValue>(v); tmp) {
+			type = LaneType::Int; value = tmp->value;
+		} else if (auto tmp = std::dynamic_pointer_cast<DoubleValue>(v); tmp) {
+			type = LaneType::Double; value = tmp->value;
+		} else if (auto tmp = std::dynamic_pointer_cast<BoolValue>(v); tmp) {
+			type = LaneType::Bool; value = tmp->value;
+		} else if (auto tmp = std::dynamic_pointer_cast<CharValue>(v); tmp) {
+			type = LaneType::Char; value = tmp->value;
+		} else {
+			return false;
+		}
+		return true;
+	}
+}
+
+BatchCompiler::BatchCompiler(const std::shared_ptr<Function>& function) : function(function) {}
+
+LaneProgram BatchCompiler::compile() {
+	if (!function->body) {
+		throw BatchUnsupported("extern function " + function->name);
+	}
+	program = LaneProgram{};
+	program.returnType = lane_type(function->returnType);
+	program.fallback = constant(LaneType::Bool, 0);
+
+	Frame frame{function, {{}}, constant(LaneType::Bool, 1), constant(LaneType::Bool, 0), constant(program.returnType, 0), program.returnType};
+	for (std::size_t i = 0; i < function->arguments.size(); i++) {
+		auto param = std::dynamic_pointer_cast<Variable>(function->arguments[i].second);
+		auto paramType = lane_type(param->type);
+		program.params.push_back(paramType);
+		auto loaded = paramType == LaneType::Int || paramType == LaneType::Char ? LaneType::Int : LaneType::Double;
+		int reg = emit(loaded == LaneType::Int ? LaneOp::LoadI : LaneOp::LoadD, i);
+		frame.scopes[0][function->arguments[i].first] = Local{convert(reg, loaded, paramType), paramType};
+	}
+
+	frames.push_back(frame);
+	function->body->accept(*this);
+	program.result = frames.back().result;
+	program.returned = frames.back().returned;
+	frames.clear();
+	return program;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void BatchCompiler::visit(Namespace_decl&) {
+	throw BatchUnsupported("namespace declaration");
+}
+
+void BatchCompiler::visit(Variables_decl& root) {
+	LaneType declType;
+	if (root.type == "int") declType = LaneType::Int;
+	else if (root.type == "double") declType = LaneType::Double;
+	else if (root.type == "bool") declType = LaneType::Bool;
+	else if (root.type == "char") declType = LaneType::Char;
+	else throw BatchUnsupported("variable of type " + root.type);
+
+	for (auto& var : root.vars) {
+		int value;
+		if (var.second) {
+			var.second->accept(*this);
+			value = convert(reg, type, declType);
+		} else {
+			value = constant(declType, 0);
+		}
+		frames.back().scopes.back()[var.first] = Local{value, declType};
+	}
+}
+
+void BatchCompiler::visit(ConstVariable& root) {
+	visit(static_cast<Variables_decl&>(root));
+}
+
+void BatchCompiler::visit(Array_decl&) {
+	throw BatchUnsupported("array");
+}
+
+void BatchCompiler::visit(Functions_decl&) {
+	throw BatchUnsupported("function declaration");
+}
+
+void BatchCompiler::visit(Extern_decl&) {
+	throw BatchUnsupported("extern declaration");
+}
+
+void BatchCompiler::visit(Expression_statement& root) {
+	root.expr->accept(*this);
+}
+
+void BatchCompiler::visit(Block_statement& root) {
+	frames.back().scopes.emplace_back();
+	for (auto& state : root.body) {
+		state->accept(*this);
+	}
+	frames.back().scopes.pop_back();
+}
+
+void BatchCompiler::visit(Decl_statement& root) {
+	root.var->accept(*this);
+}
+
+void BatchCompiler::visit(While_statement&) {
+	throw BatchUnsupported("loop");
+}
+
+void BatchCompiler::visit(For_statement&) {
+	throw BatchUnsupported("loop");
+}
+
+void BatchCompiler::visit(ForEach_statement&) {
+	throw BatchUnsupported("loop");
+}
+
+void BatchCompiler::visit(Switch_statement&) {
+	throw BatchUnsupported("switch");
+}
+
+void BatchCompiler::visit(ConditionalBlock& root) {
+	int saved = frames.back().active;
+	int taken = constant(LaneType::Bool, 0);
+	for (auto& branch : root.branches) {
+		auto test = std::dynamic_pointer_cast<ConditionalBranches>(branch);
+		int cond = emit(LaneOp::Not, taken);
+		frames.back().active = emit(LaneOp::And, saved, cond);
+		if (test->key != "else") {
+			test->cond->accept(*this);
+			cond = emit(LaneOp::And, convert(reg, type, LaneType::Bool), cond);
+		}
+		frames.back().active = emit(LaneOp::And, saved, cond);
+		frames.back().scopes.emplace_back();
+		test->body->accept(*this);
+		frames.back().scopes.pop_back();
+		taken = emit(LaneOp::Or, taken, cond);
+	}
+	frames.back().active = saved;
+}
+
+void BatchCompiler::visit(ConditionalBranches&) {
+	throw BatchUnsupported("conditional branch outside of a conditional block");
+}
+
+void BatchCompiler::visit(Continue_statement&) {
+	throw BatchUnsupported("continue");
+}
+
+void BatchCompiler::visit(Break_statement&) {
+	throw BatchUnsupported("break");
+}
+
+void BatchCompiler::visit(Return_statement& root) {
+	if (!root.expr) {
+		throw BatchUnsupported("return without a value");
+	}
+	root.expr->accept(*this);
+	auto& frame = frames.back();
+	int value = convert(reg, type, frame.returnType);
+	int mask = live();
+	frame.result = emit(LaneOp::Select, mask, value, frame.result);
+	frame.returned = emit(LaneOp::Or, frame.returned, mask);
+}
+
+void BatchCompiler::visit(BinaryNode& root) {
+	if (root.op == "::") {
+		auto scope = scope_of(root.left_branch);
+		qualifier = scope;
+		root.right_branch->accept(*this);
+		return;
+	}
+
+	if (root.op == "=" || root.op == "+=" || root.op == "-=" || root.op == "*=" || root.op == "/=") {
+		auto name = std::dynamic_pointer_cast<IdentifierNode>(root.left_branch);
+		auto target = name ? local(name->name) : nullptr;
+		if (!target) {
+			throw BatchUnsupported("assignment to a non-local object");
+		}
+		root.right_branch->accept(*this);
+		Local rhs{reg, type};
+		target = local(name->name);
+		if (root.op != "=") {
+			rhs.reg = arithmetic(root.op.substr(0, 1), *target, rhs);
+			rhs.type = type;
+		}
+		store(*target, rhs.reg, rhs.type);
+		reg = target->reg;
+		type = target->type;
+		return;
+	}
+
+	root.left_branch->accept(*this);
+	Local lhs{reg, type};
+	root.right_branch->accept(*this);
+	Local rhs{reg, type};
+
+	if (root.op == "&&" || root.op == "||") {
+		reg = emit(root.op == "&&" ? LaneOp::And : LaneOp::Or, convert(lhs.reg, lhs.type, LaneType::Bool), convert(rhs.reg, rhs.type, LaneType::Bool));
+		type = LaneType::Bool;
+	} else if (root.op == "+" || root.op == "-" || root.op == "*" || root.op == "/") {
+		reg = arithmetic(root.op, lhs, rhs);
+	} else {
+		static const std::unordered_map<std::string, std::pair<LaneOp::Code, LaneOp::Code>> compare = {
+			{"==", {LaneOp::EqI, LaneOp::EqD}}, {"!=", {LaneOp::NeI, LaneOp::NeD}},
+			{"<", {LaneOp::LtI, LaneOp::LtD}}, {"<=", {LaneOp::LeI, LaneOp::LeD}},
+			{">", {LaneOp::GtI, LaneOp::GtD}}, {">=", {LaneOp::GeI, LaneOp::GeD}}
+		};
+		if (!compare.contains(root.op)) {
+			throw BatchUnsupported("operator " + root.op);
+		}
+		auto common = lhs.type == LaneType::Double || rhs.type == LaneType::Double ? LaneType::Double : LaneType::Int;
+		auto code = common == LaneType::Double ? compare.at(root.op).second : compare.at(root.op).first;
+		reg = emit(code, convert(lhs.reg, lhs.type, common), convert(rhs.reg, rhs.type, common));
+		type = LaneType::Bool;
+	}
+}
+
+void BatchCompiler::visit(TernaryNode& root) {
+	root.cond->accept(*this);
+	int cond = convert(reg, type, LaneType::Bool);
+	int saved = frames.back().active;
+
+	frames.back().active = emit(LaneOp::And, saved, cond);
+	root.true_expression->accept(*this);
+	Local lhs{reg, type};
+
+	frames.back().active = emit(LaneOp::And, saved, emit(LaneOp::Not, cond));
+	root.false_expression->accept(*this);
+	Local rhs{reg, type};
+	frames.back().active = saved;
+
+	if (lhs.type == LaneType::Double || rhs.type == LaneType::Double) type = LaneType::Double;
+	else if (lhs.type == rhs.type) type = lhs.type;
+	else type = LaneType::Int;
+	reg = emit(LaneOp::Select, cond, convert(lhs.reg, lhs.type, type), convert(rhs.reg, rhs.type, type));
+}
+
+void BatchCompiler::visit(PrefixNode& root) {
+	if (root.op == "++" || root.op == "--") {
+		auto name = std::dynamic_pointer_cast<IdentifierNode>(root.branch);
+		auto target = name ? local(name->name) : nullptr;
+		if (!target) {
+			throw BatchUnsupported("increment of a non-local object");
+		}
+		int value = arithmetic(root.op.substr(0, 1), *target, Local{constant(LaneType::Int, 1), LaneType::Int});
+		store(*target, value, type);
+		reg = target->reg;
+		type = target->type;
+		return;
+	}
+
+	root.branch->accept(*this);
+	if (root.op == "-") {
+		if (type == LaneType::Bool || type == LaneType::Char) {
+			reg = convert(reg, type, LaneType::Int);
+			type = LaneType::Int;
+		}
+		reg = emit(type == LaneType::Double ? LaneOp::NegD : LaneOp::NegI, reg);
+	} else if (root.op == "!") {
+		reg = emit(LaneOp::Not, convert(reg, type, LaneType::Bool));
+		type = LaneType::Bool;
+	}
+}
+
+void BatchCompiler::visit(PostfixNode& root) {
+	auto name = std::dynamic_pointer_cast<IdentifierNode>(root.branch);
+	auto target = name ? local(name->name) : nullptr;
+	if (!target) {
+		throw BatchUnsupported("increment of a non-local object");
+	}
+	Local old = *target;
+	int value = arithmetic(root.op.substr(0, 1), old, Local{constant(LaneType::Int, 1), LaneType::Int});
+	store(*target, value, type);
+	reg = old.reg;
+	type = old.type;
+}
+
+void BatchCompiler::visit(FunctionNode& root) {
+	if (root.name == "print" || root.name == "println" || root.name == "input") {
+		throw BatchUnsupported(root.name);
+	}
+	auto scope = qualifier ? qualifier : frames.back().function->scope.lock();
+	qualifier = nullptr;
+	auto callee = std::dynamic_pointer_cast<Function>(scope ? scope->get_symbol(root.name) : nullptr);
+	if (!callee) {
+		throw BatchUnsupported(root.name + " is not a function");
+	}
+	if (!callee->body) {
+		throw BatchUnsupported("extern function " + callee->name);
+	}
+	for (auto& frame : frames) {
+		if (frame.function == callee) {
+			throw BatchUnsupported("recursive call of " + callee->name);
+		}
+	}
+	if (root.branches.size() != callee->arguments.size()) {
+		throw BatchUnsupported("incorrect number of arguments to " + callee->name);
+	}
+
+	std::vector<Local> args;
+	for (auto& branch : root.branches) {
+		branch->accept(*this);
+		args.push_back(Local{reg, type});
+	}
+	inline_call(callee, args);
+}
+
+void BatchCompiler::visit(SpawnNode&) {
+	throw BatchUnsupported("spawn");
+}
+
+void BatchCompiler::visit(AwaitNode&) {
+	throw BatchUnsupported("await");
+}
+
+void BatchCompiler::visit(IndexNode&) {
+	throw BatchUnsupported("array");
+}
+
+void BatchCompiler::visit(IdentifierNode& root) {
+	if (!qualifier) {
+		if (auto var = local(root.name); var) {
+			reg = var->reg;
+			type = var->type;
+			return;
+		}
+	}
+	auto scope = qualifier ? qualifier : frames.back().function->scope.lock();
+	qualifier = nullptr;
+	double value;
+	if (!scope || !scalar_value(scope->get_symbol(root.name), type, value)) {
+		throw BatchUnsupported(root.name + " is not a scalar");
+	}
+	reg = constant(type, value);
+}
+
+// only found inside loops, which are never compiled
+void BatchCompiler::visit(HoistedNode& root) {
+	root.expr->accept(*this);
+}
+
+void BatchCompiler::visit(ParenthesizedNode& root) {
+	root.expr->accept(*this);
+}
+
+void BatchCompiler::visit(IntNode& root) {
+	type = LaneType::Int;
+	reg = constant(type, root.value);
+}
+
+void BatchCompiler::visit(CharNode& root) {
+	type = LaneType::Char;
+	reg = constant(type, root.value);
+}
+
+void BatchCompiler::visit(BoolNode& root) {
+	type = LaneType::Bool;
+	reg = constant(type, root.value);
+}
+
+void BatchCompiler::visit(StringNode&) {
+	throw BatchUnsupported("string");
+}
+
+void BatchCompiler::visit(DoubleNode& root) {
+	type = LaneType::Double;
+	reg = constant(type, root.value);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+int BatchCompiler::emit(LaneOp::Code code, int a, int b, int c, double value) {
+	int dst = program.registers++;
+	program.ops.push_back(LaneOp{code, dst, a, b, c, value});
+	return dst;
+}
+
+int BatchCompiler::constant(LaneType constType, double value) {
+	if (constType == LaneType::Double) return emit(LaneOp::ConstD, -1, -1, -1, value);
+	if (constType == LaneType::Bool) return emit(LaneOp::ConstI, -1, -1, -1, value ? -1 : 0);
+	return emit(LaneOp::ConstI, -1, -1, -1, static_cast<int>(value));
+}
+
+int BatchCompiler::convert(int value, LaneType from, LaneType to) {
+	if (from == to) return value;
+	switch (to) {
+		case LaneType::Int:
+			if (from == LaneType::Char) return value;
+			return emit(from == LaneType::Double ? LaneOp::DoubleToInt : LaneOp::MaskToInt, value);
+		case LaneType::Char:
+			if (from == LaneType::Bool) return emit(LaneOp::MaskToInt, value);
+			return emit(LaneOp::IntToChar, convert(value, from, LaneType::Int));
+		case LaneType::Double:
+			return emit(LaneOp::IntToDouble, from == LaneType::Bool ? emit(LaneOp::MaskToInt, value) : value);
+		case LaneType::Bool:
+			return emit(from == LaneType::Double ? LaneOp::DoubleToMask : LaneOp::IntToMask, value);
+	}
+	return value;
+}
+
+int BatchCompiler::live() {
+	return emit(LaneOp::And, frames.back().active, emit(LaneOp::Not, frames.back().returned));
+}
+
+void BatchCompiler::store(Local& target, int value, LaneType valueType) {
+	value = convert(value, valueType, target.type);
+	target.reg = emit(LaneOp::Select, live(), value, target.reg);
+}
+
+int BatchCompiler::arithmetic(const std::string& op, Local lhs, Local rhs) {
+	type = lhs.type == LaneType::Double || rhs.type == LaneType::Double ? LaneType::Double : LaneType::Int;
+	int a = convert(lhs.reg, lhs.type, type), b = convert(rhs.reg, rhs.type, type);
+	if (op == "/" && type == LaneType::Int) {
+		int quotient = emit(LaneOp::DivI, a, b, program.fallback);
+		program.fallback = emit(LaneOp::Or, program.fallback, emit(LaneOp::EqI, b, constant(LaneType::Int, 0)));
+		return quotient;
+	}
+	static const std::unordered_map<std::string, std::pair<LaneOp::Code, LaneOp::Code>> codes = {
+		{"+", {LaneOp::AddI, LaneOp::AddD}}, {"-", {LaneOp::SubI, LaneOp::SubD}},
+		{"*", {LaneOp::MulI, LaneOp::MulD}}, {"/", {LaneOp::DivI, LaneOp::DivD}}
+	};
+	return emit(type == LaneType::Double ? codes.at(op).second : codes.at(op).first, a, b);
+}
+
+void BatchCompiler::inline_call(const std::shared_ptr<Function>& callee, const std::vector<Local>& args) {
+	auto returnType = lane_type(callee->returnType);
+	Frame frame{callee, {{}}, live(), constant(LaneType::Bool, 0), constant(returnType, 0), returnType};
+	for (std::size_t i = 0; i < args.size(); i++) {
+		auto param = std::dynamic_pointer_cast<Variable>(callee->arguments[i].second);
+		auto paramType = lane_type(param->type);
+		frame.scopes[0][callee->arguments[i].first] = Local{convert(args[i].reg, args[i].type, paramType), paramType};
+	}
+
+	frames.push_back(frame);
+	callee->body->accept(*this);
+	auto done = frames.back();
+	frames.pop_back();
+
+	// lanes that ran off the end of the callee have no defined result
+	int missing = emit(LaneOp::And, done.active, emit(LaneOp::Not, done.returned));
+	program.fallback = emit(LaneOp::Or, program.fallback, missing);
+	reg = done.result;
+	type = done.returnType;
+}
+
+BatchCompiler::Local* BatchCompiler::local(const std::string& name) {
+	auto& scopes = frames.back().scopes;
+	for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+		if (auto found = it->find(name); found != it->end()) {
+			return &found->second;
+		}
+	}
+	return nullptr;
+}
+
+std::shared_ptr<Scope> BatchCompiler::scope_of(const expression& expr) {
+	std::shared_ptr<Symbol> symbol;
+	if (auto name = std::dynamic_pointer_cast<IdentifierNode>(expr); name) {
+		auto scope = frames.back().function->scope.lock();
+		symbol = scope ? scope->get_symbol(name->name) : nullptr;
+	} else if (auto node = std::dynamic_pointer_cast<BinaryNode>(expr); node && node->op == "::") {
+		auto outer = scope_of(node->left_branch);
+		auto inner = std::dynamic_pointer_cast<IdentifierNode>(node->right_branch);
+		if (inner && outer->table.contains(inner->name)) symbol = outer->table[inner->name];
+	}
+	auto space = std::dynamic_pointer_cast<Namespace>(symbol);
+	if (!space) {
+		throw BatchUnsupported("invalid namespace qualifier");
+	}
+	return space->scope;
+}
+
+LaneType BatchCompiler::lane_type(const std::shared_ptr<Type>& type) {
+	if (std::dynamic_pointer_cast<IntType>(type)) return LaneType::Int;
+	if (std::dynamic_pointer_cast<CharType>(type)) return LaneType::Char;
+	if (std::dynamic_pointer_cast<DoubleType>(type)) return LaneType::Double;
+	if (std::dynamic_pointer_cast<BoolType>(type)) return LaneType::Bool;
+	throw BatchUnsupported("non-scalar type");
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+// The body is inlined into one wrapper per instruction set, like the array
+// kernels, with VI and VD vectors of 64-bit ints and doubles of its width.
+template <typename VI, typename VD>
+[[gnu::always_inline]] inline void lanes_body(const LaneProgram& program, vi4* registers, const std::vector<std::vector<double>>& columns, std::size_t offset, std::size_t count) {
+	using vi = VI;
+	using vd = VD;
+	constexpr std::size_t WIDTH = sizeof(vi) / sizeof(long long);
+	constexpr std::size_t VECTORS = CHUNK / WIDTH;
+	auto R = [&](int index) { return reinterpret_cast<vi*>(registers + index * STRIDE); };
+	for (auto& op : program.ops) {
+		vi* d = R(op.dst);
+		switch (op.code) {
+			case LaneOp::ConstI: {
+				vi v = {};
+				v += static_cast<long long>(op.value);
+				for (std::size_t j = 0; j < VECTORS; j++) d[j] = v;
+				break;
+			}
+			case LaneOp::ConstD: {
+				vd v = {};
+				v += op.value;
+				for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)v;
+				break;
+			}
+			case LaneOp::LoadI:
+			case LaneOp::LoadD: {
+				auto& column = columns[op.a];
+				if (count == CHUNK) {
+					std::memcpy(d, column.data() + offset, CHUNK * sizeof(double));
+				} else {
+					for (std::size_t j = 0; j < VECTORS; j++) {
+						vd v;
+						for (std::size_t k = 0; k < WIDTH; k++) v[k] = column[offset + std::min(j * WIDTH + k, count - 1)];
+						d[j] = (vi)v;
+					}
+				}
+				if (op.code == LaneOp::LoadI) {
+					for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = __builtin_convertvector((vd)d[j], vi));
+				}
+				break;
+			}
+			case LaneOp::Copy: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j]; break; }
+			case LaneOp::Select: {
+				const vi *m = R(op.a), *a = R(op.b), *b = R(op.c);
+				for (std::size_t j = 0; j < VECTORS; j++) d[j] = m[j] ? a[j] : b[j];
+				break;
+			}
+
+			case LaneOp::AddI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = a[j] + b[j]); break; }
+			case LaneOp::SubI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = a[j] - b[j]); break; }
+			case LaneOp::MulI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = a[j] * b[j]); break; }
+			case LaneOp::DivI: {
+				const vi *a = R(op.a), *b = R(op.b);
+				vi one = {};
+				one += 1;
+				for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = a[j] / (b[j] == 0 ? one : b[j]));
+				break;
+			}
+			case LaneOp::NegI: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = -a[j]); break; }
+
+			case LaneOp::AddD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] + (vd)b[j]); break; }
+			case LaneOp::SubD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] - (vd)b[j]); break; }
+			case LaneOp::MulD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] * (vd)b[j]); break; }
+			case LaneOp::DivD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] / (vd)b[j]); break; }
+			case LaneOp::NegD: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)(-(vd)a[j]); break; }
+
+			case LaneOp::EqI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] == b[j]; break; }
+			case LaneOp::NeI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] != b[j]; break; }
+			case LaneOp::LtI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] < b[j]; break; }
+			case LaneOp::LeI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] <= b[j]; break; }
+			case LaneOp::GtI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] > b[j]; break; }
+			case LaneOp::GeI: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] >= b[j]; break; }
+			case LaneOp::EqD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] == (vd)b[j]); break; }
+			case LaneOp::NeD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] != (vd)b[j]); break; }
+			case LaneOp::LtD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] < (vd)b[j]); break; }
+			case LaneOp::LeD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] <= (vd)b[j]); break; }
+			case LaneOp::GtD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] > (vd)b[j]); break; }
+			case LaneOp::GeD: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] >= (vd)b[j]); break; }
+
+			case LaneOp::And: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] & b[j]; break; }
+			case LaneOp::Or: { const vi *a = R(op.a), *b = R(op.b); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] | b[j]; break; }
+			case LaneOp::Not: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = ~a[j]; break; }
+
+			case LaneOp::IntToDouble: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)__builtin_convertvector(a[j], vd); break; }
+			case LaneOp::DoubleToInt: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) wrap(d[j] = __builtin_convertvector((vd)a[j], vi)); break; }
+			case LaneOp::IntToMask: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = a[j] != 0; break; }
+			case LaneOp::DoubleToMask: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = (vi)((vd)a[j] != 0.0); break; }
+			case LaneOp::MaskToInt: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) d[j] = -a[j]; break; }
+			case LaneOp::IntToChar: { const vi* a = R(op.a); for (std::size_t j = 0; j < VECTORS; j++) wrap_char(d[j] = a[j]); break; }
+		}
+	}
+}
+
+static void lanes_sse2(const LaneProgram& program, vi4* registers, const std::vector<std::vector<double>>& columns, std::size_t offset, std::size_t count) {
+	lanes_body<vi2, vd2>(program, registers, columns, offset, count);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void lanes_avx2(const LaneProgram& program, vi4* registers, const std::vector<std::vector<double>>& columns, std::size_t offset, std::size_t count) {
+	lanes_body<vi4, vd4>(program, registers, columns, offset, count);
+}
+#endif
+
+static void run_lanes(const LaneProgram& program, std::vector<vi4>& registers, const std::vector<std::vector<double>>& columns, std::size_t offset, std::size_t count) {
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+	if (avx2) {
+		lanes_avx2(program, registers.data(), columns, offset, count);
+		return;
+	}
+#endif
+	lanes_sse2(program, registers.data(), columns, offset, count);
+}
+
+Batch::Batch(const Program& script, const std::string& name, Profiler* profiler, const std::shared_ptr<Budget>& budget) : script(&script), name(name), budget(budget) {
+	auto context = std::make_unique<ExecutionContext>(script, profiler);
+	context->limit(budget);
+	function = context->function(name);
+	workers.push_back(Worker{std::move(context), nullptr, function});
+	compile();
+}
+
+Batch::Batch(Executor& executor, const std::shared_ptr<Function>& function) : name(function->name), function(function) {
+	workers.push_back(Worker{nullptr, &executor, function});
+	compile();
+}
+
+void Batch::compile() {
+	try {
+		program = BatchCompiler(function).compile();
+		compiled = true;
+	} catch (BatchUnsupported&) {
+		compiled = false;
+	}
+}
+
+bool Batch::vectorized() const {
+	return compiled;
+}
+
+std::vector<double> Batch::run(const std::vector<std::vector<double>>& columns) {
+	if (columns.size() != function->arguments.size()) {
+		throw std::runtime_error("Incorrect number of argument columns to function " + function->name);
+	}
+	std::size_t rows = columns.empty() ? 0 : columns[0].size();
+	for (auto& column : columns) {
+		if (column.size() != rows) {
+			throw std::runtime_error("argument columns of different length");
+		}
+	}
+
+	std::vector<double> out(rows);
+	std::vector<std::size_t> left;
+	if (!compiled || columns.empty()) {
+		left.resize(rows);
+		for (std::size_t row = 0; row < rows; row++) left[row] = row;
+		fallback(columns, left, out);
+		return out;
+	}
+
+	std::vector<vi4> registers(program.registers * STRIDE);
+	for (std::size_t offset = 0; offset < rows; offset += CHUNK) {
+		std::size_t count = std::min(CHUNK, rows - offset);
+		run_lanes(program, registers, columns, offset, count);
+
+		const vi4* result = registers.data() + program.result * STRIDE;
+		const vi4* returned = registers.data() + program.returned * STRIDE;
+		const vi4* fallback = registers.data() + program.fallback * STRIDE;
+		for (std::size_t lane = 0; lane < count; lane++) {
+			std::size_t j = lane / 4, k = lane % 4;
+			if (fallback[j][k] || !returned[j][k]) {
+				left.push_back(offset + lane);
+			} else if (program.returnType == LaneType::Double) {
+				out[offset + lane] = ((vd4)result[j])[k];
+			} else if (program.returnType == LaneType::Bool) {
+				out[offset + lane] = result[j][k] != 0;
+			} else {
+				out[offset + lane] = result[j][k];
+			}
+		}
+	}
+	fallback(columns, left, out);
+	return out;
+}
+
+// A function with side effects sees them in row order, so its rows stay on
+// the calling thread.
+void Batch::fallback(const std::vector<std::vector<double>>& columns, const std::vector<std::size_t>& rows, std::vector<double>& out) {
+	auto& pool = ThreadPool::shared();
+	if (!script || !function->pure || pool.size() == 1) {
+		for (auto row : rows) {
+			out[row] = call(workers[0], columns, row);
+		}
+		return;
+	}
+	workers.resize(pool.size());
+	std::size_t chunks = std::min(rows.size(), pool.size() * 8);
+	pool.run(chunks, [&](std::size_t chunk, std::size_t thread) {
+		auto& worker = workers[thread];
+		if (!worker.context) {
+			worker.context = std::make_unique<ExecutionContext>(*script);
+			worker.context->limit(budget);
+			worker.function = worker.context->function(name);
+		}
+		for (std::size_t i = rows.size() * chunk / chunks; i < rows.size() * (chunk + 1) / chunks; i++) {
+			out[rows[i]] = call(worker, columns, rows[i]);
+		}
+	});
+}
+
+double Batch::call(Worker& worker, const std::vector<std::vector<double>>& columns, std::size_t row) {
+	std::vector<symbol> args;
+	for (std::size_t i = 0; i < columns.size(); i++) {
+		auto param = std::dynamic_pointer_cast<Variable>(function->arguments[i].second);
+		double x = columns[i][row];
+		std::shared_ptr<Value> value;
+		if (std::shared_ptr<Type> check = std::dynamic_pointer_cast<IntType>(param->type); check) {
+			value = std::make_shared<IntValue>(x);
+		} else if (check = std::dynamic_pointer_cast<DoubleType>(param->type); check) {
+			value = std::make_shared<DoubleValue>(x);
+		} else if (check = std::dynamic_pointer_cast<CharType>(param->type); check) {
+			value = std::make_shared<CharValue>(x);
+		} else if (check = std::dynamic_pointer_cast<BoolType>(param->type); check) {
+			value = std::make_shared<BoolValue>(x);
+		} else {
+			throw std::runtime_error("batch arguments of " + function->name + " must be scalar");
+		}
+		args.push_back(std::make_shared<Variable>(param->type, std::make_shared<Lvalue>(value)));
+	}
+
+	LaneType resultType;
+	double value = 0;
+	auto returned = worker.context ? worker.context->call(worker.function, args) : worker.executor->call(worker.function, args);
+	if (!scalar_value(returned, resultType, value)) {
+		throw std::runtime_error(function->name + " does not return a scalar");
+	}
+	if (std::dynamic_pointer_cast<IntType>(function->returnType)) return static_cast<int>(value);
+	if (std::dynamic_pointer_cast<CharType>(function->returnType)) return static_cast<char>(value);
+	if (std::dynamic_pointer_cast<BoolType>(function->returnType)) return value != 0;
+	return value;
+}
@@ -0,0 +1,86 @@
+#include "budget.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <malloc.h>
+
+MemoryExceeded::MemoryExceeded(std::size_t limit) {
+	std::snprintf(message, sizeof(message), "memory limit of %zu bytes exceeded", limit);
+}
+
+thread_local Budget* Budget::charged = nullptr;
+bool Budget::hooked = false;
+
+Budget::Budget(std::uint64_t steps, std::chrono::milliseconds time, std::size_t bytes)
+	: limit(steps), timed(time.count() > 0), deadline(std::chrono::steady_clock::now() + time), memoryLimit(bytes) {}
+
+std::uint64_t Budget::take() {
+	if (exhausted.load(std::memory_order_relaxed)) {
+		throw BudgetExceeded("execution budget exceeded", used());
+	}
+	std::uint64_t grant = SLICE;
+	auto before = granted.fetch_add(SLICE);
+	if (limit) {
+		grant = before < limit ? std::min(SLICE, limit - before) : 0;
+		if (grant < SLICE) granted.fetch_sub(SLICE - grant);
+		if (!grant) {
+			exhausted = true;
+			throw BudgetExceeded("step limit of " + std::to_string(limit) + " exceeded", used());
+		}
+	}
+	if (timed && std::chrono::steady_clock::now() >= deadline) {
+		granted.fetch_sub(grant);
+		exhausted = true;
+		throw BudgetExceeded("time limit exceeded", used());
+	}
+	return grant;
+}
+
+void Budget::refund(std::uint64_t steps) {
+	granted.fetch_sub(steps);
+}
+
+std::uint64_t Budget::used() const {
+	return granted.load();
+}
+
+std::size_t Budget::memory() const {
+	return std::max<std::int64_t>(held.load(), 0);
+}
+
+std::size_t Budget::peak_memory() const {
+	return peak.load();
+}
+
+bool Budget::installed() {
+	return hooked;
+}
+
+void Budget::install() {
+	hooked = true;
+}
+
+// sizes are taken from malloc so that a block is freed with the size it
+// was allocated with, whichever delete frees it
+void Budget::allocated(void* ptr) {
+	Budget* budget = charged;
+	if (!budget) return;
+	std::int64_t size = malloc_usable_size(ptr);
+	auto now = budget->held.fetch_add(size, std::memory_order_relaxed) + size;
+	// destructors and handlers running during unwinding may still allocate
+	if (budget->memoryLimit && now > budget->memoryLimit && !std::uncaught_exceptions()) {
+		// the caller frees the block
+		budget->held.fetch_sub(size, std::memory_order_relaxed);
+		budget->exhausted = true;
+		throw MemoryExceeded(budget->memoryLimit);
+	}
+	auto most = budget->peak.load(std::memory_order_relaxed);
+	while (now > most && !budget->peak.compare_exchange_weak(most, now, std::memory_order_relaxed)) {}
+}
+
+void Budget::freed(void* ptr) {
+	Budget* budget = charged;
+	if (!budget || !ptr) return;
+	budget->held.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
@@ -0,0 +1,75 @@
+#ifdef INTERPRETER_COUNTERS
+
+#include "counters.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cxxabi.h>
+#include <mutex>
+#include <vector>
+
+namespace {
+	struct Totals {
+		std::mutex mutex;
+		std::map<std::string, std::size_t> nodes;
+		std::map<std::string, std::size_t> operands;
+
+		~Totals() {
+			ExecutionCounters::dump(std::cerr);
+		}
+	};
+
+	Totals totals;
+
+	std::string type_name(std::type_index type) {
+		int status = 0;
+		char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+		std::string result = status == 0 ? name : type.name();
+		std::free(name);
+		return result;
+	}
+
+	void write_sorted(std::ostream& out, const char* title, const std::map<std::string, std::size_t>& table) {
+		std::vector<std::pair<std::size_t, std::string>> rows;
+		for (auto& [name, count] : table) {
+			rows.push_back(std::make_pair(count, name));
+		}
+		std::sort(rows.begin(), rows.end(), [](auto& a, auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+		out << title << "\n";
+		char line[256];
+		for (auto& [count, name] : rows) {
+			std::snprintf(line, sizeof(line), "%14zu  %s\n", count, name.c_str());
+			out << line;
+		}
+	}
+}
+
+ExecutionCounters::~ExecutionCounters() {
+	std::lock_guard<std::mutex> lock(totals.mutex);
+	for (auto& [key, count] : nodes) {
+		totals.nodes[key.second.empty() ? std::string(key.first) : key.first + (" " + key.second)] += count;
+	}
+	for (auto& [key, count] : operands) {
+		totals.operands[key.first + " (" + type_name(key.second.first) + ", " + type_name(key.second.second) + ")"] += count;
+	}
+}
+
+ExecutionCounters& ExecutionCounters::local() {
+	thread_local ExecutionCounters counters;
+	return counters;
+}
+
+void ExecutionCounters::dump(std::ostream& out) {
+	if (totals.nodes.empty()) return;
+	write_sorted(out, "node visits:", totals.nodes);
+	write_sorted(out, "binary operand types:", totals.operands);
+}
+
+std::type_index ExecutionCounters::type_of(const std::shared_ptr<Symbol>& symbol) {
+	if (auto var = std::dynamic_pointer_cast<Variable>(symbol); var && var->type) {
+		return std::type_index(typeid(*var->type));
+	}
+	return std::type_index(typeid(void));
+}
+
+#endif
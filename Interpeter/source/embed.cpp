@@ -0,0 +1,284 @@
+#include "embed.hpp"
+#include "interpreter.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "interpreter.hpp"
+
+namespace {
+	enum Kind { INT = 1, DOUBLE, BOOL, CHAR, STRING };
+
+	Kind kind_of(const std::shared_ptr<Type>& type) {
+		if (std::dynamic_pointer_cast<IntType>(type)) return INT;
+		if (std::dynamic_pointer_cast<DoubleType>(type)) return DOUBLE;
+		if (std::dynamic_pointer_cast<BoolType>(type)) return BOOL;
+		if (std::dynamic_pointer_cast<CharType>(type)) return CHAR;
+		if (std::dynamic_pointer_cast<StringType>(type)) return STRING;
+		throw std::runtime_error("only scalars and strings can be passed to and from an embedding program");
+	}
+
+	template<typename T>
+	T number(const embed::Argument& arg) {
+		return std::visit([](auto& x) -> T {
+			using X = std::decay_t<decltype(x)>;
+			if constexpr (std::is_same_v<X, std::string>) {
+				throw std::runtime_error("string passed for a scalar parameter");
+			} else {
+				return static_cast<T>(x);
+			}
+		}, arg);
+	}
+}
+
+embed::Script embed::Script::compile(const std::string& source) {
+	return Script(Interpreter::source(source).compile());
+}
+
+embed::Script embed::Script::load(const std::string& path) {
+	return Script(Interpreter(path.c_str()).compile());
+}
+
+embed::Context::Context(const Script& script) : program(script.program), context(*program) {}
+
+embed::Context::~Context() {
+	context.wait();
+}
+
+void embed::Context::limit(std::uint64_t steps, std::chrono::milliseconds time) {
+	maxSteps = steps;
+	timeout = time;
+	if (!steps && !time.count() && !maxMemory) context.limit(nullptr);
+}
+
+void embed::Context::limit_memory(std::size_t bytes) {
+	if (bytes && !Budget::installed()) {
+		throw std::runtime_error("memory limits need heap.o linked into the program");
+	}
+	maxMemory = bytes;
+	if (!maxSteps && !timeout.count() && !bytes) context.limit(nullptr);
+}
+
+// every run gets a budget of its own
+void embed::Context::start() {
+	if (maxSteps || timeout.count() || maxMemory) context.limit(budget = std::make_shared<Budget>(maxSteps, timeout, maxMemory));
+}
+
+void embed::Context::run() {
+	start();
+	try {
+		context.run();
+	} catch (const MemoryExceeded& e) {
+		throw BudgetExceeded(e.what(), budget->used());
+	}
+}
+
+embed::Function embed::Context::function(const std::string& name) {
+	return Function(*this, context.function(name));
+}
+
+embed::Function::Function(Context& context, std::shared_ptr<::Function> function) : context(&context), function(std::move(function)) {
+	if (!std::dynamic_pointer_cast<VoidType>(this->function->returnType)) kind_of(this->function->returnType);
+	for (auto& [name, symbol] : this->function->arguments) {
+		auto param = std::dynamic_pointer_cast<Variable>(symbol);
+		auto kind = kind_of(param->type);
+		std::shared_ptr<Value> value;
+		switch (kind) {
+			case INT: value = std::make_shared<IntValue>(); break;
+			case DOUBLE: value = std::make_shared<DoubleValue>(); break;
+			case BOOL: value = std::make_shared<BoolValue>(); break;
+			case CHAR: value = std::make_shared<CharValue>(); break;
+			case STRING: value = std::make_shared<StringValue>(); break;
+		}
+		kinds.push_back(kind);
+		args.push_back(std::make_shared<Variable>(param->type, std::make_shared<Lvalue>(value)));
+	}
+}
+
+embed::Result embed::Function::call(const std::vector<Argument>& arguments) {
+	if (arguments.size() != kinds.size()) {
+		throw std::runtime_error("Incorrect number of arguments to function " + function->name);
+	}
+	for (std::size_t i = 0; i < kinds.size(); i++) {
+		auto value = std::dynamic_pointer_cast<Lvalue>(std::dynamic_pointer_cast<Variable>(args[i])->value)->value.get();
+		switch (kinds[i]) {
+			case INT: static_cast<IntValue*>(value)->value = number<int>(arguments[i]); break;
+			case DOUBLE: static_cast<DoubleValue*>(value)->value = number<double>(arguments[i]); break;
+			case BOOL: static_cast<BoolValue*>(value)->value = number<bool>(arguments[i]); break;
+			case CHAR: static_cast<CharValue*>(value)->value = number<char>(arguments[i]); break;
+			case STRING:
+				if (!std::holds_alternative<std::string>(arguments[i])) {
+					throw std::runtime_error("scalar passed for a string parameter");
+				}
+				static_cast<StringValue*>(value)->value = std::get<std::string>(arguments[i]);
+				break;
+		}
+	}
+
+	context->start();
+	std::shared_ptr<Variable> returned;
+	try {
+		returned = std::dynamic_pointer_cast<Variable>(context->context.call(function, args));
+	} catch (const MemoryExceeded& e) {
+		throw BudgetExceeded(e.what(), context->budget->used());
+	}
+	if (std::dynamic_pointer_cast<VoidType>(function->returnType) || !returned) return std::monostate();
+	std::shared_ptr<Value> value = returned->value;
+	if (auto lvalue = std::dynamic_pointer_cast<Lvalue>(value); lvalue) value = lvalue->value;
+	// the value returned may be of another scalar type than declared
+	double x = 0;
+	if (auto v = std::dynamic_pointer_cast<IntValue>(value); v) x = v->value;
+	else if (auto v = std::dynamic_pointer_cast<DoubleValue>(value); v) x = v->value;
+	else if (auto v = std::dynamic_pointer_cast<BoolValue>(value); v) x = v->value;
+	else if (auto v = std::dynamic_pointer_cast<CharValue>(value); v) x = v->value;
+	else if (auto v = std::dynamic_pointer_cast<StringValue>(value); v) return v->value;
+	switch (kind_of(function->returnType)) {
+		case INT: return static_cast<int>(x);
+		case DOUBLE: return x;
+		case BOOL: return x != 0;
+		case CHAR: return static_cast<char>(x);
+		default: throw std::runtime_error(function->name + " does not return a string");
+	}
+}
+
+std::vector<double> embed::Function::batch(const std::vector<std::vector<double>>& columns) {
+	context->start();
+	try {
+		return context->context.batch(function, columns);
+	} catch (const MemoryExceeded& e) {
+		throw BudgetExceeded(e.what(), context->budget->used());
+	}
+}
+
+struct interp_script {
+	embed::Script script;
+};
+
+struct interp_function {
+	embed::Function function;
+	std::vector<embed::Argument> arguments;
+	std::string text;
+};
+
+struct interp_context {
+	embed::Context context;
+	std::unordered_map<interp_function*, std::unique_ptr<interp_function>> functions;
+};
+
+namespace {
+	thread_local std::string error;
+
+	// runs body, turning any exception into the message interp_error returns
+	template<typename F>
+	int guarded(F body) {
+		try {
+			body();
+			return 0;
+		} catch (const BudgetExceeded& e) {
+			error = e.what();
+			return INTERP_BUDGET_EXCEEDED;
+		} catch (const std::exception& e) {
+			error = e.what();
+		} catch (...) {
+			error = "unknown error";
+		}
+		return -1;
+	}
+}
+
+interp_script* interp_compile(const char* source) {
+	interp_script* script = nullptr;
+	guarded([&] { script = new interp_script{embed::Script::compile(source)}; });
+	return script;
+}
+
+interp_script* interp_compile_file(const char* path) {
+	interp_script* script = nullptr;
+	guarded([&] { script = new interp_script{embed::Script::load(path)}; });
+	return script;
+}
+
+void interp_script_free(interp_script* script) {
+	delete script;
+}
+
+interp_context* interp_context_new(const interp_script* script) {
+	interp_context* context = nullptr;
+	guarded([&] { context = new interp_context{embed::Context(script->script), {}}; });
+	return context;
+}
+
+void interp_context_free(interp_context* context) {
+	delete context;
+}
+
+void interp_context_limit(interp_context* context, unsigned long long steps, unsigned long milliseconds) {
+	context->context.limit(steps, std::chrono::milliseconds(milliseconds));
+}
+
+int interp_context_limit_memory(interp_context* context, size_t bytes) {
+	return guarded([&] { context->context.limit_memory(bytes); });
+}
+
+int interp_run(interp_context* context) {
+	return guarded([&] { context->context.run(); });
+}
+
+interp_function* interp_function_find(interp_context* context, const char* name) {
+	interp_function* found = nullptr;
+	guarded([&] {
+		auto function = std::make_unique<interp_function>(interp_function{context->context.function(name), {}, {}});
+		found = function.get();
+		context->functions[found] = std::move(function);
+	});
+	return found;
+}
+
+size_t interp_function_arity(const interp_function* function) {
+	return function->function.arity();
+}
+
+int interp_call(interp_function* function, const interp_value* args, size_t count, interp_value* result) {
+	return guarded([&] {
+		auto& arguments = function->arguments;
+		arguments.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			switch (args[i].type) {
+				case INTERP_INT: arguments[i] = args[i].as.i; break;
+				case INTERP_DOUBLE: arguments[i] = args[i].as.d; break;
+				case INTERP_BOOL: arguments[i] = args[i].as.b != 0; break;
+				case INTERP_CHAR: arguments[i] = args[i].as.c; break;
+				case INTERP_STRING: arguments[i] = std::string(args[i].as.s); break;
+				default: throw std::runtime_error("argument of type void");
+			}
+		}
+		auto value = function->function.call(arguments);
+		if (!result) return;
+		std::visit([&](auto& x) {
+			using X = std::decay_t<decltype(x)>;
+			if constexpr (std::is_same_v<X, std::monostate>) { result->type = INTERP_VOID; }
+			else if constexpr (std::is_same_v<X, int>) { result->type = INTERP_INT; result->as.i = x; }
+			else if constexpr (std::is_same_v<X, double>) { result->type = INTERP_DOUBLE; result->as.d = x; }
+			else if constexpr (std::is_same_v<X, bool>) { result->type = INTERP_BOOL; result->as.b = x; }
+			else if constexpr (std::is_same_v<X, char>) { result->type = INTERP_CHAR; result->as.c = x; }
+			else { function->text = std::move(x); result->type = INTERP_STRING; result->as.s = function->text.c_str(); }
+		}, value);
+	});
+}
+
+int interp_batch(interp_function* function, const double* const* columns, size_t rows, double* out) {
+	return guarded([&] {
+		std::vector<std::vector<double>> values;
+		for (size_t i = 0; i < function->function.arity(); i++) {
+			values.emplace_back(columns[i], columns[i] + rows);
+		}
+		auto results = function->function.batch(values);
+		std::copy(results.begin(), results.end(), out);
+	});
+}
+
+const char* interp_error(void) {
+	return error.c_str();
+}
@@ -1,21 +1,203 @@
 #include "visitor.hpp"
+#include "profiler.hpp"
+#include "counters.hpp"
+#include "output.hpp"
+#include "input.hpp"
+#include "files.hpp"
+#include "kernels.hpp"
+#include "pool.hpp"
+#include "sorting.hpp"
+#include "strings.hpp"
+#include "batch.hpp"
+
+#include <cmath>
+#include <limits>
+
+static std::shared_ptr<Value> rvalue_of(const symbol& arg) {
+	auto var = std::dynamic_pointer_cast<Variable>(arg);
+	std::shared_ptr<Value> value = var->value;
+	if (auto test = std::dynamic_pointer_cast<Lvalue>(value); test) value = test->value;
+	return value;
+}
+
+// Predicates share two immutable results rather than allocating one per
+// evaluation; conditions recognise them by address.
+static symbol boolean(bool value) {
+	static const symbol yes = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(true));
+	static const symbol no = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(false));
+	return value ? yes : no;
+}
+
+template <typename T>
+static T element_cast(const symbol& arg) {
+	auto value = rvalue_of(arg);
+	if constexpr (std::is_same_v<T, std::string>) {
+		return std::dynamic_pointer_cast<StringValue>(value)->value;
+	} else {
+		if (auto tmp = std::dynamic_pointer_cast<IntValue>(value); tmp) return static_cast<T>(tmp->value);
+		if (auto tmp = std::dynamic_pointer_cast<DoubleValue>(value); tmp) return static_cast<T>(tmp->value);
+		if (auto tmp = std::dynamic_pointer_cast<CharValue>(value); tmp) return static_cast<T>(tmp->value);
+		if (auto tmp = std::dynamic_pointer_cast<BoolValue>(value); tmp) return static_cast<T>(tmp->value);
+		throw std::runtime_error("invalid conversion to array element");
+	}
+}
+
+static ArrayValue::Elements elements_of(const std::shared_ptr<Type>& type) {
+	if (std::dynamic_pointer_cast<IntType>(type)) return std::vector<int>();
+	if (std::dynamic_pointer_cast<DoubleType>(type)) return std::vector<double>();
+	if (std::dynamic_pointer_cast<CharType>(type)) return std::vector<char>();
+	if (std::dynamic_pointer_cast<BoolType>(type)) return std::vector<unsigned char>();
+	return std::vector<std::string>();
+}
+
+template <typename K>
+static MapValue::Table table_of(const std::shared_ptr<Type>& value) {
+	if (std::dynamic_pointer_cast<IntType>(value)) return HashMap<K, int>();
+	if (std::dynamic_pointer_cast<DoubleType>(value)) return HashMap<K, double>();
+	if (std::dynamic_pointer_cast<CharType>(value)) return HashMap<K, char>();
+	if (std::dynamic_pointer_cast<BoolType>(value)) return HashMap<K, unsigned char>();
+	return HashMap<K, std::string>();
+}
+
+static MapValue::Table table_of(const std::shared_ptr<MapType>& type) {
+	if (std::dynamic_pointer_cast<IntType>(type->key)) return table_of<int>(type->value);
+	if (std::dynamic_pointer_cast<CharType>(type->key)) return table_of<char>(type->value);
+	return table_of<std::string>(type->value);
+}
+
+// copy of one unboxed element, as a temporary lvalue so that it can be
+// modified and stored back
+template <typename E>
+static symbol boxed(const std::shared_ptr<Type>& type, const E& v) {
+	std::shared_ptr<Value> value;
+	if constexpr (std::is_same_v<E, int>) value = std::make_shared<IntValue>(v);
+	else if constexpr (std::is_same_v<E, double>) value = std::make_shared<DoubleValue>(v);
+	else if constexpr (std::is_same_v<E, char>) value = std::make_shared<CharValue>(v);
+	else if constexpr (std::is_same_v<E, unsigned char>) value = std::make_shared<BoolValue>(v);
+	else value = std::make_shared<StringValue>(v);
+	return std::make_shared<Variable>(type, std::make_shared<Lvalue>(value));
+}
+
+static symbol element_symbol(const std::shared_ptr<Type>& type, const ArrayValue& array, std::size_t i) {
+	return std::visit([&](auto& v) { return boxed(type, v[i]); }, array.elements);
+}
+
+// Scalar and string arguments are copied into the parameter's type, so a
+// callee never writes through to the caller or to an interned literal.
+// Arrays and maps are shared with the caller.
+static symbol parameter(const std::shared_ptr<Type>& type, const symbol& arg) {
+	std::shared_ptr<Value> value;
+	if (std::dynamic_pointer_cast<IntType>(type)) value = std::make_shared<IntValue>(element_cast<int>(arg));
+	else if (std::dynamic_pointer_cast<DoubleType>(type)) value = std::make_shared<DoubleValue>(element_cast<double>(arg));
+	else if (std::dynamic_pointer_cast<CharType>(type)) value = std::make_shared<CharValue>(element_cast<char>(arg));
+	else if (std::dynamic_pointer_cast<BoolType>(type)) value = std::make_shared<BoolValue>(element_cast<bool>(arg));
+	else if (std::dynamic_pointer_cast<StringType>(type)) value = std::make_shared<StringValue>(element_cast<std::string>(arg));
+	else return arg;
+	return std::make_shared<Variable>(type, std::make_shared<Lvalue>(value));
+}
+
+// steps the values Executor::induce declared along with their counter;
+// wrapping as the multiplication would
+static void stride(const std::vector<Induction>& inductions, std::vector<std::shared_ptr<IntValue>>& derived) {
+	for (std::size_t i = 0; i < derived.size(); i++) {
+		derived[i]->value = static_cast<int>(static_cast<unsigned>(derived[i]->value) + static_cast<unsigned>(inductions[i].step));
+	}
+}
+
+// Arguments of a C function go straight from the evaluated expression into
+// the register they are passed in; a string is kept alive by its symbol.
+static void pass(native::Arguments& args, std::size_t& integers, std::size_t& doubles, native::Kind kind, const symbol& arg) {
+	switch (kind) {
+		case native::Kind::Double: args.doubles[doubles++] = element_cast<double>(arg); break;
+		case native::Kind::String: args.integers[integers++] = reinterpret_cast<long>(std::dynamic_pointer_cast<StringValue>(rvalue_of(arg))->value.c_str()); break;
+		case native::Kind::Char: args.integers[integers++] = element_cast<char>(arg); break;
+		case native::Kind::Bool: args.integers[integers++] = element_cast<bool>(arg); break;
+		default: args.integers[integers++] = element_cast<int>(arg); break;
+	}
+}
+
+static symbol returned(const NativeFunction& func, native::Result out) {
+	std::shared_ptr<Value> value;
+	switch (func.result) {
+		case native::Kind::Void: return nullptr;
+		case native::Kind::Double: value = std::make_shared<DoubleValue>(out.real); break;
+		case native::Kind::String: {
+			auto string = reinterpret_cast<const char*>(out.integer);
+			value = std::make_shared<StringValue>(string ? string : "");
+			break;
+		}
+		case native::Kind::Char: value = std::make_shared<CharValue>(static_cast<char>(out.integer)); break;
+		// only the low byte of a returned bool is defined
+		case native::Kind::Bool: return boolean(static_cast<unsigned char>(out.integer) != 0);
+		case native::Kind::Int: value = std::make_shared<IntValue>(static_cast<int>(out.integer)); break;
+	}
+	return std::make_shared<Variable>(func.returnType, value);
+}
+
+static native::Kind kind_of(const std::shared_ptr<Type>& type) {
+	if (std::dynamic_pointer_cast<IntType>(type)) return native::Kind::Int;
+	if (std::dynamic_pointer_cast<DoubleType>(type)) return native::Kind::Double;
+	if (std::dynamic_pointer_cast<CharType>(type)) return native::Kind::Char;
+	if (std::dynamic_pointer_cast<BoolType>(type)) return native::Kind::Bool;
+	if (std::dynamic_pointer_cast<StringType>(type)) return native::Kind::String;
+	return native::Kind::Void;
+}
+
+Executor::Executor(Profiler* profiler) : profiler(profiler), tasks(std::make_shared<TaskGroup>()) {}
+
+Executor::Executor(const std::shared_ptr<Scope>& global, Profiler* profiler) : scopeManager(global), profiler(profiler), tasks(std::make_shared<TaskGroup>()) {}
+
+Executor::~Executor() {
+	if (budget) budget->refund(credit);
+}
+
+const std::shared_ptr<Scope>& Executor::globals() const {
+	return scopeManager.global;
+}
+
+void Executor::limit(const std::shared_ptr<Budget>& budget) {
+	if (this->budget) this->budget->refund(credit);
+	this->budget = budget;
+	credit = 0;
+}
+
+const std::shared_ptr<TaskGroup>& Executor::spawned() const {
+	return tasks;
+}
+
+// after a run was stopped by an exception, so that the next call starts
+// from the global scope with no flag left set
+void Executor::reset() {
+	while (scopeManager.scopes.top() != scopeManager.global) scopeManager.scopes.pop();
+	returnFlag = continueFlag = breakFlag = condFlag = false;
+	result = nullptr;
+	qualifier = nullptr;
+	element = Element{};
+}
+
 void Executor::execute(std::vector<declaration>& nodes) {
+	Budget::Charge charge(budget.get());
 	for (auto& decl : nodes) {
 		decl->accept(*this);
 	} 
 }
 
 void Executor::visit(Namespace_decl& root) {
+	COUNT_NODE("Namespace_decl");
 	auto name = root.name;
+	auto outer = nameSpace;
+	nameSpace += name + "::";
 	scopeManager.enterScope();
 	for (auto& decl : root.declarations) {
 		decl->accept(*this);
 	}
 	auto newScope = scopeManager.exitScope();
+	nameSpace = outer;
 	add(name, std::make_shared<Namespace>(newScope));
 }
 
 void Executor::visit(Variables_decl& root) {
+	COUNT_NODE("Variables_decl");
 	auto type = newType(root.type);
 	for (auto& var : root.vars) {
 		auto name = var.first;
@@ -30,6 +212,7 @@ void Executor::visit(Variables_decl& root) {
 
 
 void Executor::visit(ConstVariable& root) {
+	COUNT_NODE("ConstVariable");
 	auto type = newType(root.type);
 	for (auto& var : root.vars) {
 		auto name = var.first;
@@ -42,7 +225,27 @@ void Executor::visit(ConstVariable& root) {
 	}
 }
 
+void Executor::visit(Array_decl& root) {
+	COUNT_NODE("Array_decl");
+	auto element = newType(root.type);
+	for (auto& var : root.vars) {
+		std::size_t size = 0;
+		if (var.second) {
+			var.second->accept(*this);
+			auto n = element_cast<int>(result);
+			if (n < 0) {
+				throw std::runtime_error("size of array " + var.first + " is negative");
+			}
+			size = n;
+		}
+		auto array = std::make_shared<ArrayValue>(elements_of(element));
+		std::visit([size](auto& v) { v.resize(size); }, array->elements);
+		add(var.first, std::make_shared<Variable>(std::make_shared<ArrayType>(element), std::make_shared<Lvalue>(array)));
+	}
+}
+
 void Executor::visit(Functions_decl& root) {
+	COUNT_NODE("Functions_decl");
 	auto type = newType(root.type);
 	auto name = root.name;
 	
@@ -56,21 +259,39 @@ void Executor::visit(Functions_decl& root) {
 		arguments.push_back(std::make_pair(paramName, symbol));
 	}
 
-	if (name == "main") {
-		root.block_statement->accept(*this);		
-	}
+	auto function = std::make_shared<Function>(type, arguments, root.block_statement, nameSpace + name);
+	function->scope = scopeManager.scopes.top();
+	function->pure = root.pure;
+	add(name, function);
 
-	add(name, std::make_shared<Function>(type, arguments, root.block_statement));
+}
 
+void Executor::visit(Extern_decl& root) {
+	COUNT_NODE("Extern_decl");
+	auto type = newType(root.type);
+	std::vector<std::pair<std::string, std::shared_ptr<Symbol>>> arguments;
+	std::vector<native::Kind> kinds;
+	for (auto& param : root.parameters) {
+		auto paramType = newType(param.first);
+		arguments.push_back(std::make_pair(param.second, std::make_shared<Variable>(paramType, std::make_shared<Lvalue>(newValue(param.first)))));
+		kinds.push_back(kind_of(paramType));
+	}
+	auto thunk = native::thunk(root.name, kind_of(type), kinds);
+	auto address = native::resolve(root.library, root.name);
+	statement body;
+	add(root.name, std::make_shared<NativeFunction>(type, arguments, body, nameSpace + root.name, address, kind_of(type), kinds, thunk));
 }
 
 void Executor::visit(Expression_statement& root) {
+	COUNT_NODE("Expression_statement");
 	root.expr->accept(*this);
 }
 
 void Executor::visit(Block_statement& root) {
+	COUNT_NODE("Block_statement");
 	scopeManager.enterScope();
 	for (auto& state : root.body) {
+		if (profiler) profiler->line(state->line);
 		state->accept(*this);
 		if (continueFlag || breakFlag || returnFlag) break; 
 	}
@@ -78,12 +299,19 @@ void Executor::visit(Block_statement& root) {
 }
 
 void Executor::visit(Decl_statement& root) { 
+	COUNT_NODE("Decl_statement");
 	root.var->accept(*this);
 }
 
 void Executor::visit(While_statement& root) {
+	COUNT_NODE("While_statement");
+	if (!root.hoisted.empty()) {
+		scopeManager.enterScope();
+		hoist(root.hoisted);
+	}
 	root.cond->accept(*this);
 	while (check_condition()) {
+		step();
 		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
 			scopeManager.enterScope(); root.body->accept(*this); scopeManager.exitScope(); 
 		} else { root.body->accept(*this); }
@@ -94,28 +322,214 @@ void Executor::visit(While_statement& root) {
 
 		root.cond->accept(*this);
 	}
+	if (!root.hoisted.empty()) scopeManager.exitScope();
 }
 
 void Executor::visit(For_statement& root) {
+	COUNT_NODE("For_statement");
+	if (root.parallel) {
+		run_parallel(root);
+		return;
+	}
 	scopeManager.enterScope();
+	hoist(root.hoisted);
 	if (root.var) {
 		root.var->accept(*this);
 	}
+	auto derived = induce(root.inductions);
 	root.cond->accept(*this);
 	while (check_condition()) {
+		step();
 		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
 			scopeManager.enterScope(); root.body->accept(*this); scopeManager.exitScope(); 
 		} else { root.body->accept(*this); }
-		if (continueFlag) {continueFlag = false; root.Expr->accept(*this); root.cond->accept(*this); continue;}
+		if (continueFlag) {continueFlag = false; root.Expr->accept(*this); stride(root.inductions, derived); root.cond->accept(*this); continue;}
 		else if (breakFlag) {breakFlag = false; break;}
 		else if (returnFlag) break;
 		root.Expr->accept(*this);
+		stride(root.inductions, derived);
 		root.cond->accept(*this);
 	}
 	scopeManager.exitScope();
 }
 
+// declares the slots of the expressions hoisted out of a loop, empty until
+// the loop first uses them
+void Executor::hoist(const std::vector<std::string>& names) {
+	for (auto& name : names) {
+		scopeManager.scopes.top()->add(name, std::make_shared<Hoisted>());
+	}
+}
+
+// declares counter * factor for each strength-reduced multiplication
+std::vector<std::shared_ptr<IntValue>> Executor::induce(const std::vector<Induction>& inductions) {
+	std::vector<std::shared_ptr<IntValue>> derived;
+	for (auto& induction : inductions) {
+		auto counter = static_cast<unsigned>(element_cast<int>(scopeManager.scopes.top()->get_symbol(induction.counter)));
+		derived.push_back(std::make_shared<IntValue>(static_cast<int>(counter * induction.factor)));
+		scopeManager.scopes.top()->add(induction.name, std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<Lvalue>(derived.back())));
+	}
+	return derived;
+}
+
+// The bounds of a parallel for are evaluated once and [begin, end) is cut
+// into a few chunks per pool thread, so that threads which finish early can
+// steal the rest. Each thread runs its chunks on an executor of its own,
+// over a scope that declares the counter and a zeroed copy of every
+// reduction variable on top of the scope the loop is in. The copies of all
+// chunks are added to the variables in chunk order, which keeps the result
+// the same however the chunks were spread over the threads.
+void Executor::run_parallel(For_statement& root) {
+	scopeManager.enterScope();
+	root.var->accept(*this);
+	auto vars = std::dynamic_pointer_cast<Variables_decl>(std::dynamic_pointer_cast<Decl_statement>(root.var)->var);
+	auto& counter = vars->vars[0].first;
+	long long begin = element_cast<int>(get_symbol(counter));
+	auto compare = std::dynamic_pointer_cast<BinaryNode>(std::dynamic_pointer_cast<Expression_statement>(root.cond)->expr);
+	compare->right_branch->accept(*this);
+	double bound = element_cast<double>(result);
+	scopeManager.exitScope();
+	long long end = compare->op == "<" ? std::ceil(bound) : std::floor(bound) + 1;
+	end = std::min<long long>(end, std::numeric_limits<int>::max());
+	if (end <= begin) return;
+
+	auto outer = scopeManager.scopes.top();
+	auto& pool = ThreadPool::shared();
+	std::size_t n = end - begin, chunks = std::min<std::size_t>(n, pool.size() * 8);
+	std::vector<std::vector<symbol>> partial(chunks);
+	std::vector<std::unique_ptr<Executor>> workers(pool.size());
+	pool.run(chunks, [&](std::size_t chunk, std::size_t thread) {
+		auto& worker = workers[thread];
+		if (!worker) {
+			worker = std::make_unique<Executor>(scopeManager.global);
+			worker->budget = budget;
+		}
+		worker->run_chunk(root, outer, counter, begin + n * chunk / chunks, begin + n * (chunk + 1) / chunks, partial[chunk]);
+	});
+	for (std::size_t i = 0; i < root.reductions.size(); i++) {
+		auto sum = get_symbol(root.reductions[i]);
+		for (auto& sums : partial) {
+			binary_operations.at("+=")(sum, sums[i]);
+		}
+	}
+}
+
+void Executor::run_chunk(For_statement& root, const std::shared_ptr<Scope>& outer, std::string& counter, int from, int to, std::vector<symbol>& sums) {
+	Budget::Charge charge(budget.get());
+	scopeManager.scopes.push(std::make_shared<Scope>(outer));
+	for (auto& name : root.reductions) {
+		auto type = std::dynamic_pointer_cast<Variable>(outer->get_symbol(name))->type;
+		std::shared_ptr<Value> zero;
+		if (std::dynamic_pointer_cast<IntType>(type)) zero = std::make_shared<IntValue>(0);
+		else zero = std::make_shared<DoubleValue>(0);
+		sums.push_back(std::make_shared<Variable>(type, std::make_shared<Lvalue>(zero)));
+		add(name, sums.back());
+	}
+	auto index = std::make_shared<IntValue>(from);
+	add(counter, std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<Lvalue>(index)));
+	for (int i = from; i < to; i++) {
+		step();
+		index->value = i;
+		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
+			scopeManager.enterScope(); root.body->accept(*this); scopeManager.exitScope(); 
+		} else { root.body->accept(*this); }
+		continueFlag = false;
+	}
+	scopeManager.exitScope();
+}
+
+void Executor::visit(ForEach_statement& root) {
+	COUNT_NODE("ForEach_statement");
+	if (auto call = std::dynamic_pointer_cast<FunctionNode>(root.range); call && call->name == "lines" && !qualifier && !scopeManager.scopes.top()->lookup(call->name)) {
+		for_each_line(root, *call);
+		return;
+	}
+	root.range->accept(*this);
+	auto varType = newType(root.type);
+	std::shared_ptr<ArrayValue> array;
+	std::shared_ptr<Type> element;
+	if (auto map = std::dynamic_pointer_cast<MapType>(std::dynamic_pointer_cast<Variable>(result)->type); map) {
+		// the keys are copied first, so the body may insert and erase freely
+		auto table = std::dynamic_pointer_cast<MapValue>(rvalue_of(result));
+		array = std::make_shared<ArrayValue>(elements_of(map->key));
+		std::visit([&](auto& keys) {
+			std::visit([&](auto& t) {
+				if constexpr (std::is_same_v<typename std::decay_t<decltype(keys)>::value_type, typename std::decay_t<decltype(t)>::key_type>) {
+					keys.reserve(t.size());
+					for (auto& entry : t) keys.push_back(entry.first);
+				}
+			}, table->table);
+		}, array->elements);
+		element = map->key;
+	} else {
+		array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(result));
+		element = std::dynamic_pointer_cast<ArrayType>(std::dynamic_pointer_cast<Variable>(result)->type)->element;
+	}
+	for (std::size_t i = 0; i < array->size(); i++) {
+		step();
+		scopeManager.enterScope();
+		result = element_symbol(element, *array, i);
+		add(root.name, std::make_shared<Variable>(varType, std::make_shared<Lvalue>(newValue(root.type))));
+		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
+			scopeManager.enterScope(); root.body->accept(*this); scopeManager.exitScope(); 
+		} else { root.body->accept(*this); }
+		scopeManager.exitScope();
+		if (continueFlag) continueFlag = false;
+		else if (breakFlag) {breakFlag = false; break;}
+		else if (returnFlag) break;
+	}
+}
+
+// Streams the lines of a file straight off its mapping instead of building
+// the string[] that lines() returns. The loop variable keeps one buffer for
+// the whole loop, so a line costs a copy into it and no allocation.
+void Executor::for_each_line(ForEach_statement& root, FunctionNode& call) {
+	call.branches[0]->accept(*this);
+	files::Mapping file(std::dynamic_pointer_cast<StringValue>(rvalue_of(result))->value);
+	files::Lines lines(file);
+	auto type = newType(root.type);
+	auto line = std::make_shared<StringValue>();
+	auto var = std::make_shared<Variable>(type, std::make_shared<Lvalue>(line));
+	for (std::string_view view; lines.next(view);) {
+		step();
+		scopeManager.enterScope();
+		line->value.assign(view);
+		add(root.name, var);
+		if (auto test = std::dynamic_pointer_cast<Block_statement>(root.body); !test) { 
+			scopeManager.enterScope(); root.body->accept(*this); scopeManager.exitScope(); 
+		} else { root.body->accept(*this); }
+		scopeManager.exitScope();
+		if (continueFlag) continueFlag = false;
+		else if (breakFlag) {breakFlag = false; break;}
+		else if (returnFlag) break;
+	}
+}
+
+void Executor::visit(Switch_statement& root) {
+	COUNT_NODE("Switch_statement");
+	root.value->accept(*this);
+	auto value = element_cast<int>(result);
+	auto start = root.fallback;
+	if (!root.table.empty()) {
+		auto index = static_cast<long long>(value) - root.low;
+		if (index >= 0 && index < static_cast<long long>(root.table.size())) start = root.table[index];
+	} else {
+		auto found = std::lower_bound(root.cases.begin(), root.cases.end(), value, [](const auto& label, int value) { return label.first < value; });
+		if (found != root.cases.end() && found->first == value) start = found->second;
+	}
+	scopeManager.enterScope();
+	for (auto i = start; i < root.body.size(); i++) {
+		if (profiler) profiler->line(root.body[i]->line);
+		root.body[i]->accept(*this);
+		if (continueFlag || breakFlag || returnFlag) break;
+	}
+	// a break ends the switch, a continue the loop around it
+	breakFlag = false;
+	scopeManager.exitScope();
+}
+
 void Executor::visit(ConditionalBlock& root) {
+	COUNT_NODE("ConditionalBlock");
 	for (auto& branches : root.branches) {
 		branches->accept(*this);
 		if (condFlag) break;				
@@ -124,6 +538,7 @@ void Executor::visit(ConditionalBlock& root) {
 }
 
 void Executor::visit(ConditionalBranches& root) {
+	COUNT_NODE("ConditionalBranches");
 	if (root.key != "else") {
 		root.cond->accept(*this);
 	}
@@ -138,36 +553,52 @@ void Executor::visit(ConditionalBranches& root) {
 }
 
 void Executor::visit(Continue_statement&) {
+	COUNT_NODE("Continue_statement");
 	continueFlag = true;
 }
 
 void Executor::visit(Break_statement&) {
+	COUNT_NODE("Break_statement");
 	breakFlag = true;
 }
 
 void Executor::visit(Return_statement& root) {
+	COUNT_NODE("Return_statement");
 	if (root.expr) root.expr->accept(*this);
 	returnFlag = true;
 }	
 
 void Executor::visit(BinaryNode& root) {
+	COUNT_NODE("BinaryNode", root.op);
 	if (root.op == "::") {
 		root.left_branch->accept(*this);
 		auto space = std::dynamic_pointer_cast<Namespace>(result);
-		scopeManager.enterScope(space->scope);
-		root.right_branch->accept(*this);
-		scopeManager.exitScope();
+		if (auto call = std::dynamic_pointer_cast<FunctionNode>(root.right_branch); call) {
+			qualifier = space->scope;
+			call->accept(*this);
+		} else {
+			scopeManager.enterScope(space->scope);
+			root.right_branch->accept(*this);
+			scopeManager.exitScope();
+		}
+	} else if (root.op == "=" && append(root)) {
+		return;
 	} else {
 		root.left_branch->accept(*this);
 		auto lhs = result;
+		Element target;
+		if (std::dynamic_pointer_cast<IndexNode>(root.left_branch)) target = element;
 		root.right_branch->accept(*this);
 		auto rhs = result;	
+		COUNT_BINARY(root.op, lhs, rhs);
 		result = nullptr;
 		result = binary_operations.at(root.op)(lhs, rhs);
+		if (target && assignment_operators.contains(root.op)) store(target, lhs);
 	}
 }
 
 void Executor::visit(TernaryNode& root) {
+	COUNT_NODE("TernaryNode");
 	root.cond->accept(*this);
 	if (check_condition()) {
 		root.true_expression->accept(*this);
@@ -177,69 +608,352 @@ void Executor::visit(TernaryNode& root) {
 }
 
 void Executor::visit(PrefixNode& root) {
+	COUNT_NODE("PrefixNode", root.op);
 	root.branch->accept(*this);
+	auto operand = result;
+	Element target;
+	if (std::dynamic_pointer_cast<IndexNode>(root.branch)) target = element;
 	result = prefix_operations.at(root.op)(result);
+	if (target && (root.op == "++" || root.op == "--")) store(target, operand);
 }
 
 void Executor::visit(PostfixNode& root) {
+	COUNT_NODE("PostfixNode", root.op);
 	root.branch->accept(*this);	
+	auto operand = result;
+	Element target;
+	if (std::dynamic_pointer_cast<IndexNode>(root.branch)) target = element;
 	result = postfix_operations.at(root.op)(result);
+	if (target) store(target, operand);
 }
 
 void Executor::visit(FunctionNode& root) {
-	if (root.name == "print" || root.name == "input") {
+	COUNT_NODE("FunctionNode");
+	if (InOutFunctions.contains(root.name)) {
+		std::vector<symbol> args;
+		std::vector<std::pair<Element, symbol>> targets;
 		for (auto& branch : root.branches) {
 			result = nullptr;
 			branch->accept(*this);
-			InOutFunctions.at(root.name)(result);
+			args.push_back(result);
+			if (std::dynamic_pointer_cast<IndexNode>(branch)) targets.push_back(std::make_pair(element, result));
 		}
-		result = nullptr;
-	} else {
-		result = get_symbol(root.name);
+		result = InOutFunctions.at(root.name)(args);
+		if (root.name == "input") {
+			for (auto& [target, value] : targets) store(target, value);
+		}
+	} else if ((ArrayFunctions.contains(root.name) || StringFunctions.contains(root.name) || FileFunctions.contains(root.name)) && !qualifier && !scopeManager.scopes.top()->lookup(root.name)) {
+		std::vector<symbol> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(result);
+		}
+		auto& functions = ArrayFunctions.contains(root.name) ? ArrayFunctions : StringFunctions.contains(root.name) ? StringFunctions : FileFunctions;
+		result = functions.at(root.name)(args);
+	} else if ((root.name == "regex_match" || root.name == "regex_search") && !qualifier && !scopeManager.scopes.top()->lookup(root.name)) {
+		std::vector<symbol> args;
+		for (auto& branch : root.branches) {
+			result = nullptr;
+			branch->accept(*this);
+			args.push_back(result);
+		}
+		auto& text = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		auto& pattern = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		// recompiled only when the pattern at this call site changes
+		auto& compiled = patterns[&root];
+		if (!compiled || compiled->pattern() != pattern) compiled = std::make_unique<regex::Regex>(pattern);
+		bool search = root.name == "regex_search", matched;
+		if (args.size() > 2) {
+			std::vector<std::string> groups;
+			matched = search ? compiled->search(text, groups) : compiled->match(text, groups);
+			std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[2]))->elements = std::move(groups);
+		} else {
+			matched = search ? compiled->search(text) : compiled->match(text);
+		}
+		result = boolean(matched);
+	} else if (root.name == "batch" && !qualifier && !scopeManager.scopes.top()->lookup(root.name)) {
+		root.branches[0]->accept(*this);
 		auto func = std::dynamic_pointer_cast<Function>(result);
-		scopeManager.enterScope(); returnFlag = false;
-		for (std::size_t i = 0; i < root.branches.size(); i++) {
+		std::vector<std::vector<double>> columns;
+		for (std::size_t i = 1; i < root.branches.size(); i++) {
+			result = nullptr;
 			root.branches[i]->accept(*this);
-			add(func->arguments[i].first, result);
+			std::visit([&](auto& v) {
+				using E = typename std::decay_t<decltype(v)>::value_type;
+				if constexpr (!std::is_same_v<E, std::string>) columns.emplace_back(v.begin(), v.end());
+			}, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(result))->elements);
+		}
+		auto rows = Batch(*this, func).run(columns);
+		result = std::make_shared<Variable>(std::make_shared<ArrayType>(std::make_shared<DoubleType>()), std::make_shared<ArrayValue>(std::move(rows)));
+	} else {
+		auto scope = qualifier ? qualifier : scopeManager.scopes.top();
+		qualifier = nullptr;
+		auto func = std::dynamic_pointer_cast<Function>(scope->get_symbol(root.name));
+		if (auto native = dynamic_cast<const NativeFunction*>(func.get()); native) {
+			call_native(*native, root);
+			return;
+		}
+		std::vector<symbol> args;
+		for (auto& branch : root.branches) {
 			result = nullptr;
+			branch->accept(*this);
+			args.push_back(result);
+		}
+		call(func, args);
+	}
+}
+
+void Executor::call_native(const NativeFunction& func, FunctionNode& root) {
+	step();
+	native::Arguments args;
+	symbol strings[native::INTEGERS];
+	std::size_t integers = 0, doubles = 0;
+	for (std::size_t i = 0; i < root.branches.size(); i++) {
+		result = nullptr;
+		root.branches[i]->accept(*this);
+		if (func.kinds[i] == native::Kind::String) strings[integers] = result;
+		pass(args, integers, doubles, func.kinds[i], result);
+	}
+	result = returned(func, func.thunk(func.address, args));
+}
+
+// The arguments are evaluated and copied here, arrays and maps included, so
+// the caller can go on changing them; then the call runs on the shared pool
+// in an executor of its own, over the scope the function was declared in.
+// Only the parsed program and the global scope are shared with the caller,
+// and the analyzer keeps the function from touching global variables.
+void Executor::visit(SpawnNode& root) {
+	COUNT_NODE("SpawnNode");
+	auto scope = scopeManager.scopes.top();
+	auto node = root.call;
+	for (auto qualified = std::dynamic_pointer_cast<BinaryNode>(node); qualified && qualified->op == "::"; qualified = std::dynamic_pointer_cast<BinaryNode>(node)) {
+		auto space = std::dynamic_pointer_cast<Namespace>(scope->get_symbol(std::dynamic_pointer_cast<IdentifierNode>(qualified->left_branch)->name));
+		scope = space->scope;
+		node = qualified->right_branch;
+	}
+	auto call = std::dynamic_pointer_cast<FunctionNode>(node);
+	auto func = std::dynamic_pointer_cast<Function>(scope->get_symbol(call->name));
+	std::vector<symbol> args;
+	for (std::size_t i = 0; i < call->branches.size(); i++) {
+		result = nullptr;
+		call->branches[i]->accept(*this);
+		auto type = std::dynamic_pointer_cast<Variable>(func->arguments[i].second)->type;
+		if (auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(result)); array) {
+			args.push_back(std::make_shared<Variable>(type, std::make_shared<Lvalue>(std::make_shared<ArrayValue>(*array))));
+		} else if (auto map = std::dynamic_pointer_cast<MapValue>(rvalue_of(result)); map) {
+			args.push_back(std::make_shared<Variable>(type, std::make_shared<Lvalue>(std::make_shared<MapValue>(*map))));
+		} else {
+			args.push_back(parameter(type, result));
+		}
+	}
+
+	auto task = std::make_shared<TaskState>();
+	ThreadPool::shared().submit([task, func, args, global = scopeManager.global, budget = budget, tasks = tasks] {
+		Executor executor(global);
+		executor.budget = budget;
+		executor.tasks = tasks;
+		std::shared_ptr<Value> value;
+		std::exception_ptr error;
+		try {
+			if (auto returned = executor.call(func, args); returned) value = rvalue_of(returned);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		std::lock_guard lock(task->mutex);
+		task->value = value;
+		task->error = error;
+		task->done = true;
+		task->ready.notify_all();
+	}, tasks);
+	result = std::make_shared<Variable>(std::make_shared<FutureType>(func->returnType), std::make_shared<FutureValue>(task));
+}
+
+// A thread waiting for a task runs queued ones meanwhile, which also keeps
+// a task that awaits another from holding up a pool thread.
+void Executor::visit(AwaitNode& root) {
+	COUNT_NODE("AwaitNode");
+	root.handle->accept(*this);
+	auto type = std::dynamic_pointer_cast<FutureType>(std::dynamic_pointer_cast<Variable>(result)->type);
+	auto task = std::dynamic_pointer_cast<FutureValue>(rvalue_of(result))->task;
+	if (!task) {
+		throw std::runtime_error("await of a future that was never spawned");
+	}
+	std::unique_lock lock(task->mutex);
+	while (!task->done) {
+		lock.unlock();
+		bool ran = ThreadPool::shared().run_one();
+		lock.lock();
+		if (!ran) task->ready.wait(lock, [&task] { return task->done; });
+	}
+	if (task->error) std::rethrow_exception(task->error);
+	result = task->value ? std::make_shared<Variable>(type->value, task->value) : nullptr;
+}
+
+// s = s + a + b on a string s appends to s in place rather than building
+// a new string on every step. Only literals and other variables may follow,
+// so evaluating them early cannot be observed.
+bool Executor::append(BinaryNode& root) {
+	auto target = std::dynamic_pointer_cast<IdentifierNode>(root.left_branch);
+	if (!target) return false;
+	std::vector<expression> operands;
+	auto node = root.right_branch;
+	for (auto sum = std::dynamic_pointer_cast<BinaryNode>(node); sum && sum->op == "+"; sum = std::dynamic_pointer_cast<BinaryNode>(node)) {
+		auto name = std::dynamic_pointer_cast<IdentifierNode>(sum->right_branch);
+		if (name ? name->name == target->name : !std::dynamic_pointer_cast<StringNode>(sum->right_branch)) return false;
+		operands.push_back(sum->right_branch);
+		node = sum->left_branch;
+	}
+	auto first = std::dynamic_pointer_cast<IdentifierNode>(node);
+	if (operands.empty() || !first || first->name != target->name) return false;
+	auto var = std::dynamic_pointer_cast<Variable>(get_symbol(target->name));
+	if (!var || !std::dynamic_pointer_cast<StringType>(var->type)) return false;
+
+	std::vector<std::shared_ptr<StringValue>> parts;
+	std::size_t size = 0;
+	for (auto it = operands.rbegin(); it != operands.rend(); ++it) {
+		(*it)->accept(*this);
+		auto part = std::dynamic_pointer_cast<StringValue>(rvalue_of(result));
+		if (!part) return false;
+		size += part->value.size();
+		parts.push_back(part);
+	}
+	auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(var))->value;
+	s.reserve(s.size() + size);
+	for (auto& part : parts) s += part->value;
+	result = var;
+	return true;
+}
+
+symbol Executor::call(const std::shared_ptr<Function>& func, const std::vector<symbol>& args) {
+	Budget::Charge charge(budget.get());
+	step();
+	if (auto native = dynamic_cast<const NativeFunction*>(func.get()); native) {
+		native::Arguments registers;
+		std::size_t integers = 0, doubles = 0;
+		for (std::size_t i = 0; i < args.size(); i++) {
+			pass(registers, integers, doubles, native->kinds[i], args[i]);
 		}
-		func->body->accept(*this);
-		scopeManager.exitScope(); returnFlag = false;
+		return result = returned(*native, native->thunk(native->address, registers));
+	}
+	scopeManager.scopes.push(std::make_shared<Scope>(func->scope.lock())); returnFlag = false;
+	for (std::size_t i = 0; i < args.size(); i++) {
+		auto param = std::dynamic_pointer_cast<Variable>(func->arguments[i].second);
+		add(func->arguments[i].first, parameter(param->type, args[i]));
 	}
+	result = nullptr;
+	if (profiler) profiler->enter(&func->name, func->body->line);
+	func->body->accept(*this);
+	if (profiler) profiler->leave();
+	scopeManager.exitScope(); returnFlag = false;
+	return result;
+}
+
+std::shared_ptr<Function> Executor::function(const std::string& name) {
+	auto scope = scopeManager.global;
+	std::size_t begin = 0;
+	for (auto end = name.find("::"); end != std::string::npos; begin = end + 2, end = name.find("::", begin)) {
+		auto part = name.substr(begin, end - begin);
+		auto space = scope->table.contains(part) ? std::dynamic_pointer_cast<Namespace>(scope->table[part]) : nullptr;
+		if (!space) {
+			throw std::runtime_error(name.substr(0, end) + " is not a namespace");
+		}
+		scope = space->scope;
+	}
+	auto func = std::dynamic_pointer_cast<Function>(scope->get_symbol(name.substr(begin)));
+	if (!func) {
+		throw std::runtime_error(name + " is not a function");
+	}
+	return func;
+}
+
+void Executor::visit(IndexNode& root) {
+	COUNT_NODE("IndexNode");
+	root.branch->accept(*this);
+	if (auto map = std::dynamic_pointer_cast<MapType>(std::dynamic_pointer_cast<Variable>(result)->type); map) {
+		auto table = std::dynamic_pointer_cast<MapValue>(rvalue_of(result));
+		root.index->accept(*this);
+		auto key = result;
+		std::visit([&](auto& t) {
+			using K = typename std::decay_t<decltype(t)>::key_type;
+			auto k = element_cast<K>(key);
+			element = Element{nullptr, 0, table, boxed(map->key, k)};
+			result = boxed(map->value, t[k]);
+		}, table->table);
+		return;
+	}
+	auto type = std::dynamic_pointer_cast<ArrayType>(std::dynamic_pointer_cast<Variable>(result)->type);
+	auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(result));
+	root.index->accept(*this);
+	auto index = element_cast<int>(result);
+	if (index < 0 || static_cast<std::size_t>(index) >= array->size()) {
+		throw std::runtime_error("array index " + std::to_string(index) + " is out of range for array of size " + std::to_string(array->size()));
+	}
+	element = Element{array, static_cast<std::size_t>(index), nullptr, nullptr};
+	result = element_symbol(type->element, *array, index);
 }
 
 void Executor::visit(IdentifierNode& root) {
+	COUNT_NODE("IdentifierNode");
 	result = get_symbol(root.name);
 }
 
+void Executor::visit(HoistedNode& root) {
+	COUNT_NODE("HoistedNode");
+	auto slot = std::static_pointer_cast<Hoisted>(get_symbol(root.name));
+	if (!slot->value) {
+		root.expr->accept(*this);
+		slot->value = result;
+	}
+	result = slot->value;
+}
+
 void Executor::visit(ParenthesizedNode& root) {
+	COUNT_NODE("ParenthesizedNode");
 	root.expr->accept(*this);
 }
 
 void Executor::visit(IntNode& root) {
+	COUNT_NODE("IntNode");
 	result = std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(root.value));
 }
 
 void Executor::visit(CharNode& root) {
+	COUNT_NODE("CharNode");
 	result = std::make_shared<Variable>(std::make_shared<CharType>(), std::make_shared<CharValue>(root.value));
 }
 
 void Executor::visit(BoolNode& root) {
+	COUNT_NODE("BoolNode");
 	result = std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(root.value));
 }
 
 void Executor::visit(StringNode& root) {
-	result = std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(root.value));
+	COUNT_NODE("StringNode");
+	auto& literal = literals[&root];
+	if (!literal) literal = std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(root.value));
+	result = literal;
 }
 
 void Executor::visit(DoubleNode& root) {
+	COUNT_NODE("DoubleNode");
 	result = std::make_shared<Variable>(std::make_shared<DoubleType>(), std::make_shared<DoubleValue>(root.value));
 }
 
 ///////////////////////////////////////////////////////////////////////////
 
 std::shared_ptr<Type> Executor::newType(std::string& type) {
-	if (type == "int") {
+	if (type.ends_with("[]")) {
+		auto element = type.substr(0, type.size() - 2);
+		return std::make_shared<ArrayType>(newType(element));
+	} else if (type.starts_with("map<")) {
+		auto comma = type.find(',');
+		auto key = type.substr(4, comma - 4), value = type.substr(comma + 1, type.size() - comma - 2);
+		return std::make_shared<MapType>(newType(key), newType(value));
+	} else if (type.starts_with("future<")) {
+		auto value = type.substr(7, type.size() - 8);
+		return std::make_shared<FutureType>(newType(value));
+	} else if (type == "int") {
 		return std::make_shared<IntType>();
 	} else if (type == "double") {
 		return std::make_shared<DoubleType>();
@@ -255,29 +969,45 @@ std::shared_ptr<Type> Executor::newType(std::string& type) {
 }
 
 std::shared_ptr<Value> Executor::newValue(std::string& v) {
+	if (v.ends_with("[]")) {
+		if (result) {
+			return std::make_shared<ArrayValue>(std::dynamic_pointer_cast<ArrayValue>(rvalue_of(result))->elements);
+		}
+		auto type = std::dynamic_pointer_cast<ArrayType>(newType(v));
+		return std::make_shared<ArrayValue>(elements_of(type->element));
+	}
+	if (v.starts_with("map<")) {
+		if (result) {
+			return std::make_shared<MapValue>(std::dynamic_pointer_cast<MapValue>(rvalue_of(result))->table);
+		}
+		return std::make_shared<MapValue>(table_of(std::dynamic_pointer_cast<MapType>(newType(v))));
+	}
+	if (v.starts_with("future<")) {
+		return std::make_shared<FutureValue>(result ? std::dynamic_pointer_cast<FutureValue>(rvalue_of(result))->task : nullptr);
+	}
 	auto var = std::dynamic_pointer_cast<Variable>(result);
 	double n = {};
 	std::string s = {};
 	if (result) {
 		if (std::shared_ptr<Type> check = std::dynamic_pointer_cast<IntType>(var->type); check) {
 			auto v = std::dynamic_pointer_cast<IntValue>(var->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) auto v = std::dynamic_pointer_cast<IntValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) v = std::dynamic_pointer_cast<IntValue>(test->value);
 			n = v->value;
 		} else if (check = std::dynamic_pointer_cast<DoubleType>(var->type); check) {
 			auto v = std::dynamic_pointer_cast<DoubleValue>(var->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) auto v = std::dynamic_pointer_cast<DoubleValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) v = std::dynamic_pointer_cast<DoubleValue>(test->value);
 			n = v->value;
 		} else if (check = std::dynamic_pointer_cast<CharType>(var->type); check) {
 			auto v = std::dynamic_pointer_cast<CharValue>(var->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) auto v = std::dynamic_pointer_cast<CharValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) v = std::dynamic_pointer_cast<CharValue>(test->value);
 			n = v->value;
 		} else if (check = std::dynamic_pointer_cast<BoolType>(var->type); check) {
 			auto v = std::dynamic_pointer_cast<BoolValue>(var->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) auto v = std::dynamic_pointer_cast<BoolValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) v = std::dynamic_pointer_cast<BoolValue>(test->value);
 			n = v->value;
 		} else if (check = std::dynamic_pointer_cast<StringType>(var->type); check) {
 			auto v = std::dynamic_pointer_cast<StringValue>(var->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) auto v = std::dynamic_pointer_cast<StringValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var->value); test) v = std::dynamic_pointer_cast<StringValue>(test->value);
 			s = v->value;
 		}
 	}
@@ -296,6 +1026,26 @@ std::shared_ptr<Value> Executor::newValue(std::string& v) {
 	}
 }
 
+void Executor::store(const Element& target, const symbol& value) {
+	if (target.map) {
+		std::visit([&](auto& t) {
+			using K = typename std::decay_t<decltype(t)>::key_type;
+			using V = typename std::decay_t<decltype(t)>::mapped_type;
+			t[element_cast<K>(target.key)] = element_cast<V>(value);
+		}, target.map->table);
+		return;
+	}
+	// the right side ran after the index was checked and may have shrunk
+	// the array, with pop or through a call
+	if (target.index >= target.array->size()) {
+		throw std::runtime_error("array index " + std::to_string(target.index) + " is out of range for array of size " + std::to_string(target.array->size()));
+	}
+	std::visit([&](auto& v) {
+		using E = typename std::decay_t<decltype(v)>::value_type;
+		v[target.index] = element_cast<E>(value);
+	}, target.array->elements);
+}
+
 void Executor::add(std::string& name, const symbol& newSymbol) {
 	scopeManager.scopes.top()->add(name, newSymbol);
 }
@@ -305,6 +1055,8 @@ symbol Executor::get_symbol(std::string& name) {
 }
 
 bool Executor::check_condition() {
+	if (result == boolean(true)) return true;
+	if (result == boolean(false)) return false;
 	auto var = std::dynamic_pointer_cast<Variable>(result);
 	if (std::shared_ptr<Type> check = std::dynamic_pointer_cast<IntType>(var->type); check) {
 		auto tmp = std::dynamic_pointer_cast<IntValue>(var->value);
@@ -327,34 +1079,315 @@ bool Executor::check_condition() {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-#include<iostream>
-const std::unordered_map<std::string, std::function<void(symbol)>> Executor::InOutFunctions = {
-	{"print", [](symbol arg) {
-		auto v = std::dynamic_pointer_cast<Variable>(arg);
-		if (std::shared_ptr<Type> check = std::dynamic_pointer_cast<IntType>(v->type); check) {
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(v->value); test) {
-				std::cout << std::dynamic_pointer_cast<IntValue>(test->value)->value << std::endl;
-			} else std::cout << std::dynamic_pointer_cast<IntValue>(v->value)->value << std::endl;
-		} else if (check = std::dynamic_pointer_cast<DoubleType>(v->type); check) {
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(v->value); test) {
-				std::cout << std::dynamic_pointer_cast<DoubleValue>(test->value)->value << std::endl;
-			} else std::cout << std::dynamic_pointer_cast<DoubleValue>(v->value)->value << std::endl;
-		} else if (check = std::dynamic_pointer_cast<CharType>(v->type); check) {
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(v->value); test) {
-				std::cout << std::dynamic_pointer_cast<CharValue>(test->value)->value << std::endl;
-			} else std::cout << std::dynamic_pointer_cast<CharValue>(v->value)->value << std::endl;
-		} else if (check = std::dynamic_pointer_cast<BoolType>(v->type); check) {
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(v->value); test) {
-				std::cout << std::dynamic_pointer_cast<BoolValue>(test->value)->value << std::endl;
-			} else std::cout << std::dynamic_pointer_cast<BoolValue>(v->value)->value << std::endl;
-		} else if (check = std::dynamic_pointer_cast<StringType>(v->type); check) {
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(v->value); test) {
-				std::cout << std::dynamic_pointer_cast<StringValue>(test->value)->value << std::endl;
-			} else std::cout << std::dynamic_pointer_cast<StringValue>(v->value)->value << std::endl;
+static void write_value(Output& out, const symbol& arg) {
+	auto v = std::dynamic_pointer_cast<Variable>(arg);
+	std::shared_ptr<Value> value = v->value;
+	if (auto test = std::dynamic_pointer_cast<Lvalue>(value); test) value = test->value;
+	if (std::shared_ptr<Type> check = std::dynamic_pointer_cast<IntType>(v->type); check) {
+		out.write(std::dynamic_pointer_cast<IntValue>(value)->value);
+	} else if (check = std::dynamic_pointer_cast<DoubleType>(v->type); check) {
+		out.write(std::dynamic_pointer_cast<DoubleValue>(value)->value);
+	} else if (check = std::dynamic_pointer_cast<CharType>(v->type); check) {
+		out.write(std::dynamic_pointer_cast<CharValue>(value)->value);
+	} else if (check = std::dynamic_pointer_cast<BoolType>(v->type); check) {
+		out.write(std::dynamic_pointer_cast<BoolValue>(value)->value);
+	} else if (check = std::dynamic_pointer_cast<StringType>(v->type); check) {
+		out.write(std::string_view(std::dynamic_pointer_cast<StringValue>(value)->value));
+	} else if (check = std::dynamic_pointer_cast<ArrayType>(v->type); check) {
+		std::visit([&out](auto& elements) {
+			for (std::size_t i = 0; i < elements.size(); i++) {
+				if (i) out.put(' ');
+				if constexpr (std::is_same_v<std::decay_t<decltype(elements[i])>, unsigned char>) out.write(static_cast<bool>(elements[i]));
+				else if constexpr (std::is_same_v<std::decay_t<decltype(elements[i])>, std::string>) out.write(std::string_view(elements[i]));
+				else out.write(elements[i]);
+			}
+		}, std::dynamic_pointer_cast<ArrayValue>(value)->elements);
+	} else if (check = std::dynamic_pointer_cast<MapType>(v->type); check) {
+		auto map = std::dynamic_pointer_cast<MapType>(check);
+		std::visit([&](auto& t) {
+			bool first = true;
+			for (auto& [key, item] : t) {
+				if (!first) out.put(' ');
+				first = false;
+				write_value(out, boxed(map->key, key));
+				out.put(':');
+				write_value(out, boxed(map->value, item));
+			}
+		}, std::dynamic_pointer_cast<MapValue>(value)->table);
+	}
+}
+
+const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> Executor::InOutFunctions = {
+	{"print", [](const std::vector<symbol>& args)->symbol {
+		auto& out = Output::standard();
+		for (auto& arg : args) {
+			write_value(out, arg);
+			out.newline();
+		}
+		return nullptr;
+	}},
+	{"println", [](const std::vector<symbol>& args)->symbol {
+		auto& out = Output::standard();
+		for (std::size_t i = 0; i < args.size(); i++) {
+			if (i) out.put(' ');
+			write_value(out, args[i]);
+		}
+		out.newline();
+		return nullptr;
+	}},
+	{"input", [](const std::vector<symbol>& args)->symbol {
+		auto& in = Input::standard();
+		if (in.interactive()) Output::standard().flush();
+		bool ok = true;
+		for (auto& arg : args) {
+			auto v = std::dynamic_pointer_cast<Variable>(arg);
+			auto value = std::dynamic_pointer_cast<Lvalue>(v->value)->value;
+			if (auto tmp = std::dynamic_pointer_cast<IntValue>(value); tmp) {
+				ok = in.read(tmp->value);
+			} else if (auto tmp = std::dynamic_pointer_cast<DoubleValue>(value); tmp) {
+				ok = in.read(tmp->value);
+			} else if (auto tmp = std::dynamic_pointer_cast<CharValue>(value); tmp) {
+				ok = in.read(tmp->value);
+			} else if (auto tmp = std::dynamic_pointer_cast<BoolValue>(value); tmp) {
+				ok = in.read(tmp->value);
+			} else if (auto tmp = std::dynamic_pointer_cast<StringValue>(value); tmp) {
+				ok = in.read(tmp->value);
+			}
+			if (!ok) break;
+		}
+		return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(ok));
+	}}
+};
+
+const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> Executor::ArrayFunctions = {
+	{"len", [](const std::vector<symbol>& args)->symbol {
+		auto value = rvalue_of(args[0]);
+		std::size_t size;
+		if (auto tmp = std::dynamic_pointer_cast<StringValue>(value); tmp) size = tmp->value.size();
+		else if (auto tmp = std::dynamic_pointer_cast<MapValue>(value); tmp) size = tmp->size();
+		else size = std::dynamic_pointer_cast<ArrayValue>(value)->size();
+		return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(size));
+	}},
+	{"push", [](const std::vector<symbol>& args)->symbol {
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		std::visit([&](auto& v) {
+			using E = typename std::decay_t<decltype(v)>::value_type;
+			v.push_back(element_cast<E>(args[1]));
+		}, array->elements);
+		return nullptr;
+	}},
+	{"pop", [](const std::vector<symbol>& args)->symbol {
+		auto type = std::dynamic_pointer_cast<ArrayType>(std::dynamic_pointer_cast<Variable>(args[0])->type);
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		if (!array->size()) {
+			throw std::runtime_error("pop from an empty array");
+		}
+		auto last = element_symbol(type->element, *array, array->size() - 1);
+		std::visit([](auto& v) { v.pop_back(); }, array->elements);
+		return last;
+	}},
+	{"sum", [](const std::vector<symbol>& args)->symbol {
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		if (auto v = std::get_if<std::vector<int>>(&array->elements); v) {
+			return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(kernels::sum(v->data(), v->size())));
+		}
+		auto& v = std::get<std::vector<double>>(array->elements);
+		return std::make_shared<Variable>(std::make_shared<DoubleType>(), std::make_shared<DoubleValue>(kernels::sum(v.data(), v.size())));
+	}},
+	{"dot", [](const std::vector<symbol>& args)->symbol {
+		auto x = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0])), y = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[1]));
+		if (x->size() != y->size()) {
+			throw std::runtime_error("dot of arrays of different sizes");
+		}
+		if (auto v = std::get_if<std::vector<int>>(&x->elements); v) {
+			auto& w = std::get<std::vector<int>>(y->elements);
+			return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(kernels::dot(v->data(), w.data(), v->size())));
+		}
+		auto& v = std::get<std::vector<double>>(x->elements);
+		auto& w = std::get<std::vector<double>>(y->elements);
+		return std::make_shared<Variable>(std::make_shared<DoubleType>(), std::make_shared<DoubleValue>(kernels::dot(v.data(), w.data(), v.size())));
+	}},
+	{"min", [](const std::vector<symbol>& args)->symbol {
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		if (!array->size()) {
+			throw std::runtime_error("min of an empty array");
+		}
+		if (auto v = std::get_if<std::vector<int>>(&array->elements); v) {
+			return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(kernels::min(v->data(), v->size())));
+		}
+		auto& v = std::get<std::vector<double>>(array->elements);
+		return std::make_shared<Variable>(std::make_shared<DoubleType>(), std::make_shared<DoubleValue>(kernels::min(v.data(), v.size())));
+	}},
+	{"max", [](const std::vector<symbol>& args)->symbol {
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		if (!array->size()) {
+			throw std::runtime_error("max of an empty array");
+		}
+		if (auto v = std::get_if<std::vector<int>>(&array->elements); v) {
+			return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(kernels::max(v->data(), v->size())));
+		}
+		auto& v = std::get<std::vector<double>>(array->elements);
+		return std::make_shared<Variable>(std::make_shared<DoubleType>(), std::make_shared<DoubleValue>(kernels::max(v.data(), v.size())));
+	}},
+	{"scale", [](const std::vector<symbol>& args)->symbol {
+		auto array = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]));
+		if (auto v = std::get_if<std::vector<int>>(&array->elements); v) {
+			kernels::scale(v->data(), element_cast<int>(args[1]), v->size());
+		} else {
+			auto& w = std::get<std::vector<double>>(array->elements);
+			kernels::scale(w.data(), element_cast<double>(args[1]), w.size());
+		}
+		return nullptr;
+	}},
+	{"axpy", [](const std::vector<symbol>& args)->symbol {
+		auto x = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[1])), y = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[2]));
+		if (x->size() != y->size()) {
+			throw std::runtime_error("axpy of arrays of different sizes");
+		}
+		if (auto v = std::get_if<std::vector<int>>(&x->elements); v) {
+			auto& w = std::get<std::vector<int>>(y->elements);
+			kernels::axpy(element_cast<int>(args[0]), v->data(), w.data(), v->size());
+		} else {
+			auto& u = std::get<std::vector<double>>(x->elements);
+			auto& w = std::get<std::vector<double>>(y->elements);
+			kernels::axpy(element_cast<double>(args[0]), u.data(), w.data(), u.size());
+		}
+		return nullptr;
+	}},
+	{"contains", [](const std::vector<symbol>& args)->symbol {
+		auto found = std::visit([&](auto& t) {
+			using K = typename std::decay_t<decltype(t)>::key_type;
+			return t.contains(element_cast<K>(args[1]));
+		}, std::dynamic_pointer_cast<MapValue>(rvalue_of(args[0]))->table);
+		return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(found));
+	}},
+	{"erase", [](const std::vector<symbol>& args)->symbol {
+		auto erased = std::visit([&](auto& t) {
+			using K = typename std::decay_t<decltype(t)>::key_type;
+			return t.erase(element_cast<K>(args[1]));
+		}, std::dynamic_pointer_cast<MapValue>(rvalue_of(args[0]))->table);
+		return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(erased));
+	}},
+	{"sort", [](const std::vector<symbol>& args)->symbol {
+		std::visit([](auto& v) { sorting::sort(v); }, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		return nullptr;
+	}},
+	{"stable_sort", [](const std::vector<symbol>& args)->symbol {
+		std::visit([](auto& v) { sorting::stable_sort(v); }, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		return nullptr;
+	}},
+	{"partial_sort", [](const std::vector<symbol>& args)->symbol {
+		int k = element_cast<int>(args[1]);
+		if (k < 0) {
+			throw std::runtime_error("partial_sort of a negative number of elements");
 		}
+		std::visit([k](auto& v) { sorting::partial_sort(v, k); }, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		return nullptr;
+	}},
+	{"lower_bound", [](const std::vector<symbol>& args)->symbol {
+		auto index = std::visit([&](auto& v) {
+			using E = typename std::decay_t<decltype(v)>::value_type;
+			return sorting::lower_bound(v, element_cast<E>(args[1]));
+		}, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(index));
+	}},
+	{"binary_search", [](const std::vector<symbol>& args)->symbol {
+		auto found = std::visit([&](auto& v) {
+			using E = typename std::decay_t<decltype(v)>::value_type;
+			return sorting::binary_search(v, element_cast<E>(args[1]));
+		}, std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(found));
 	}}
 };
 
+// string builders allocate their result once at its final size
+const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> Executor::StringFunctions = {
+	{"concat", [](const std::vector<symbol>& args)->symbol {
+		std::size_t size = 0;
+		for (auto& arg : args) {
+			auto value = rvalue_of(arg);
+			if (auto tmp = std::dynamic_pointer_cast<StringValue>(value); tmp) size += tmp->value.size();
+			else size++;
+		}
+		std::string s;
+		s.reserve(size);
+		for (auto& arg : args) {
+			auto value = rvalue_of(arg);
+			if (auto tmp = std::dynamic_pointer_cast<StringValue>(value); tmp) s += tmp->value;
+			else s += std::dynamic_pointer_cast<CharValue>(value)->value;
+		}
+		return std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(std::move(s)));
+	}},
+	{"find", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		auto& t = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		int from = args.size() > 2 ? element_cast<int>(args[2]) : 0;
+		auto i = from < 0 ? strings::npos : strings::find(s, t, from);
+		return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(i == strings::npos ? -1 : static_cast<int>(i)));
+	}},
+	{"count", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		auto& t = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		return std::make_shared<Variable>(std::make_shared<IntType>(), std::make_shared<IntValue>(strings::count(s, t)));
+	}},
+	{"replace", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		auto& from = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		auto& to = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[2]))->value;
+		return std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(strings::replace(s, from, to)));
+	}},
+	{"split", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		auto& separator = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		return std::make_shared<Variable>(std::make_shared<ArrayType>(std::make_shared<StringType>()), std::make_shared<ArrayValue>(strings::split(s, separator)));
+	}},
+	{"starts_with", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		return boolean(strings::starts_with(s, std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value));
+	}},
+	{"ends_with", [](const std::vector<symbol>& args)->symbol {
+		auto& s = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		return boolean(strings::ends_with(s, std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value));
+	}},
+	{"join", [](const std::vector<symbol>& args)->symbol {
+		auto& parts = std::get<std::vector<std::string>>(std::dynamic_pointer_cast<ArrayValue>(rvalue_of(args[0]))->elements);
+		auto& separator = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value;
+		std::size_t size = parts.empty() ? 0 : separator.size() * (parts.size() - 1);
+		for (auto& part : parts) size += part.size();
+		std::string s;
+		s.reserve(size);
+		for (std::size_t i = 0; i < parts.size(); i++) {
+			if (i) s += separator;
+			s += parts[i];
+		}
+		return std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(std::move(s)));
+	}}
+};
+
+const std::unordered_map<std::string, std::function<symbol(const std::vector<symbol>&)>> Executor::FileFunctions = {
+	{"read_file", [](const std::vector<symbol>& args)->symbol {
+		auto& path = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		return std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(files::read(path)));
+	}},
+	{"write_file", [](const std::vector<symbol>& args)->symbol {
+		auto& path = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		return boolean(files::write(path, std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value));
+	}},
+	{"append_file", [](const std::vector<symbol>& args)->symbol {
+		auto& path = std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value;
+		return boolean(files::append(path, std::dynamic_pointer_cast<StringValue>(rvalue_of(args[1]))->value));
+	}},
+	{"lines", [](const std::vector<symbol>& args)->symbol {
+		files::Mapping file(std::dynamic_pointer_cast<StringValue>(rvalue_of(args[0]))->value);
+		files::Lines lines(file);
+		std::vector<std::string> all;
+		for (std::string_view line; lines.next(line);) all.emplace_back(line);
+		return std::make_shared<Variable>(std::make_shared<ArrayType>(std::make_shared<StringType>()), std::make_shared<ArrayValue>(std::move(all)));
+	}}
+};
+
+const std::unordered_set<std::string> Executor::assignment_operators = {"=", "+=", "-=", "/=", "*="};
+
 const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Executor::binary_operations = {
 	{"+", [](symbol arg1, symbol arg2)->symbol{
 		auto var1 = std::dynamic_pointer_cast<Variable>(arg1), var2 = std::dynamic_pointer_cast<Variable>(arg2);
@@ -445,7 +1478,7 @@ const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Exe
 			auto v1 = std::dynamic_pointer_cast<StringValue>(var1->value);
 			if (auto test = std::dynamic_pointer_cast<Lvalue>(var1->value); test) v1 = std::dynamic_pointer_cast<StringValue>(test->value);
 			auto v2 = std::dynamic_pointer_cast<StringValue>(var2->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var1->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
 			return std::make_shared<Variable>(std::make_shared<StringType>(), std::make_shared<StringValue>(v1->value + v2->value));
 		}
 		return nullptr;
@@ -788,7 +1821,7 @@ const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Exe
 			if (auto test = std::dynamic_pointer_cast<Lvalue>(var1->value); test) v1 = std::dynamic_pointer_cast<StringValue>(test->value);
 			auto v2 = std::dynamic_pointer_cast<StringValue>(var2->value);
 			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
-			return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(v1->value == v2->value));
+			return boolean(strings::equal(v1->value, v2->value));
 		}
 		return nullptr;
 	}},
@@ -874,6 +1907,12 @@ const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Exe
 				if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<BoolValue>(test->value);
 				return std::make_shared<Variable>(std::make_shared<BoolType>(), std::make_shared<BoolValue>(v1->value != v2->value));
 			}
+		} else if (checkFirst = std::dynamic_pointer_cast<StringType>(var1->type); checkFirst) {
+			auto v1 = std::dynamic_pointer_cast<StringValue>(var1->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var1->value); test) v1 = std::dynamic_pointer_cast<StringValue>(test->value);
+			auto v2 = std::dynamic_pointer_cast<StringValue>(var2->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
+			return boolean(!strings::equal(v1->value, v2->value));
 		}
 		return nullptr;
 	}},
@@ -1492,6 +2531,15 @@ const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Exe
 			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
 			v1->value = v2->value;
 			return var1;	
+		} else if (checkFirst = std::dynamic_pointer_cast<ArrayType>(var1->type); checkFirst) {
+			std::dynamic_pointer_cast<ArrayValue>(rvalue_of(var1))->elements = std::dynamic_pointer_cast<ArrayValue>(rvalue_of(var2))->elements;
+			return var1;
+		} else if (checkFirst = std::dynamic_pointer_cast<MapType>(var1->type); checkFirst) {
+			std::dynamic_pointer_cast<MapValue>(rvalue_of(var1))->table = std::dynamic_pointer_cast<MapValue>(rvalue_of(var2))->table;
+			return var1;
+		} else if (checkFirst = std::dynamic_pointer_cast<FutureType>(var1->type); checkFirst) {
+			std::dynamic_pointer_cast<FutureValue>(rvalue_of(var1))->task = std::dynamic_pointer_cast<FutureValue>(rvalue_of(var2))->task;
+			return var1;
 		}
 		return nullptr;
 	}},
@@ -1597,7 +2645,7 @@ const std::unordered_map<std::string, std::function<symbol(symbol, symbol)>> Exe
 			auto v1 = std::dynamic_pointer_cast<StringValue>(var1->value);
 			if (auto test = std::dynamic_pointer_cast<Lvalue>(var1->value); test) v1 = std::dynamic_pointer_cast<StringValue>(test->value);
 			auto v2 = std::dynamic_pointer_cast<StringValue>(var2->value);
-			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v1 = std::dynamic_pointer_cast<StringValue>(test->value);
+			if (auto test = std::dynamic_pointer_cast<Lvalue>(var2->value); test) v2 = std::dynamic_pointer_cast<StringValue>(test->value);
 			v1->value += v2->value;
 			return var1;	
 		}
@@ -0,0 +1,294 @@
+#include "files.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+	std::terminate_handler previous = nullptr;
+	// read_file and lines close writers from the iterations of a parallel for
+	std::mutex registry;
+
+	std::unordered_map<std::string, std::unique_ptr<files::Writer>>& writers() {
+		static std::unordered_map<std::string, std::unique_ptr<files::Writer>> open;
+		return open;
+	}
+
+	// like Output, whatever was appended is written out before an uncaught
+	// runtime error ends the program
+	void close_and_terminate() {
+		writers().clear();
+		if (previous) previous();
+		std::abort();
+	}
+
+	bool write_all(int fd, const char* data, std::size_t size) {
+		while (size) {
+			ssize_t n = ::write(fd, data, size);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			data += n;
+			size -= n;
+		}
+		return true;
+	}
+}
+
+// Live mappings, for the SIGBUS handler to find the one a fault is in and
+// for write_file to find those of the file it rewrites. The handler reads
+// the table without taking the lock.
+class files::Registry {
+public:
+	static constexpr int SLOTS = 64;
+
+	// false when the table is full
+	static bool add(Mapping& file) {
+		std::lock_guard lock(mutex);
+		if (!page) {
+			page = sysconf(_SC_PAGESIZE);
+			struct sigaction action = {};
+			action.sa_sigaction = &handler;
+			action.sa_flags = SA_SIGINFO;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGBUS, &action, &previous);
+		}
+		for (int i = 0; i < SLOTS; i++) {
+			Mapping* empty = nullptr;
+			if (slots[i].compare_exchange_strong(empty, &file)) {
+				file.slot = i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void remove(Mapping& file) {
+		if (file.slot < 0) return;
+		std::lock_guard lock(mutex);
+		slots[file.slot] = nullptr;
+		file.slot = -1;
+	}
+
+	// The pages of a mapping are swapped for an anonymous copy in place, so
+	// a thread reading it never sees them missing. A private mapping that
+	// was written to would not do, since truncation drops its copies too.
+	static void detach(const std::string& path) {
+		struct stat target;
+		if (stat(path.c_str(), &target) != 0) return;
+		std::lock_guard lock(mutex);
+		for (auto& slot : slots) {
+			Mapping* file = slot.load();
+			struct stat info;
+			if (!file || fstat(file->fd, &info) != 0 || info.st_dev != target.st_dev || info.st_ino != target.st_ino) continue;
+			std::size_t length = (file->size + page - 1) & ~(page - 1);
+			void* copy = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (copy == MAP_FAILED) continue;
+			std::memcpy(copy, file->data, file->size);
+			mprotect(copy, length, PROT_READ);
+			if (mremap(copy, length, length, MREMAP_MAYMOVE | MREMAP_FIXED, const_cast<char*>(file->data)) == MAP_FAILED) {
+				munmap(copy, length);
+				continue;
+			}
+			slot = nullptr;
+			file->slot = -1;
+		}
+	}
+private:
+	// Maps zero pages over the rest of the mapping the fault is in, which
+	// the access then reads, and marks the mapping cut short. A fault
+	// anywhere else goes to the handler there was before.
+	static void handler(int, siginfo_t* info, void*) {
+		auto address = static_cast<const char*>(info->si_addr);
+		for (auto& slot : slots) {
+			Mapping* file = slot.load(std::memory_order_acquire);
+			if (!file || address < file->data || address >= file->data + file->size) continue;
+			auto begin = reinterpret_cast<char*>(reinterpret_cast<std::uintptr_t>(address) & ~(page - 1));
+			mmap(begin, file->data + file->size - begin, PROT_READ, MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			file->cut.store(true, std::memory_order_release);
+			return;
+		}
+		sigaction(SIGBUS, &previous, nullptr);
+	}
+
+	static inline std::atomic<Mapping*> slots[SLOTS] = {};
+	static inline std::mutex mutex;
+	static inline std::uintptr_t page = 0;
+	static inline struct sigaction previous = {};
+};
+
+files::Mapping::Mapping(const std::string& path) {
+	close(path);
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			madvise(map, info.st_size, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(map);
+			size = info.st_size;
+			mapped = true;
+			// kept open to be read again if the file is cut short
+			this->fd = fd;
+			if (Registry::add(*this)) return;
+			munmap(map, size);
+			data = nullptr;
+			size = 0;
+			mapped = false;
+			this->fd = -1;
+		}
+	}
+	// pipes, devices and whatever cannot be mapped are read in full
+	buffer.resize(1 << 16);
+	while (true) {
+		if (size == buffer.size()) buffer.resize(buffer.size() * 2);
+		ssize_t n = ::read(fd, buffer.data() + size, buffer.size() - size);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		size += n;
+	}
+	::close(fd);
+	data = buffer.data();
+}
+
+files::Mapping::~Mapping() {
+	Registry::remove(*this);
+	if (mapped) munmap(const_cast<char*>(data), size);
+	if (fd >= 0) ::close(fd);
+}
+
+void files::Mapping::reload() {
+	Registry::remove(*this);
+	struct stat info;
+	std::size_t length = fstat(fd, &info) == 0 ? info.st_size : 0;
+	std::vector<char> text(length);
+	std::size_t got = 0;
+	while (got < length) {
+		ssize_t n = pread(fd, text.data() + got, length - got, got);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		got += n;
+	}
+	text.resize(got);
+	if (mapped) munmap(const_cast<char*>(data), size);
+	mapped = false;
+	buffer = std::move(text);
+	data = buffer.data();
+	size = got;
+	cut.store(false, std::memory_order_release);
+}
+
+// a line scanned while the file was cut short may hold zeros from past its
+// new end, so it is scanned again after the reload
+bool files::Lines::next(std::string_view& line) {
+	while (true) {
+		auto text = file.view();
+		if (position >= text.size()) return false;
+		text.remove_prefix(position);
+		auto end = static_cast<const char*>(std::memchr(text.data(), '\n', text.size()));
+		std::size_t length = end ? end - text.data() : text.size();
+		line = text.substr(0, length);
+		if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+		if (file.truncated()) {
+			file.reload();
+			continue;
+		}
+		position += end ? length + 1 : length;
+		return true;
+	}
+}
+
+files::Writer::Writer(const std::string& path, bool append) : buffer(CAPACITY) {
+	// what is being read of the file is kept as it was
+	if (!append) Registry::detach(path);
+	fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+	if (fd < 0) {
+		throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+	}
+}
+
+files::Writer::~Writer() {
+	flush();
+	::close(fd);
+}
+
+void files::Writer::write(std::string_view text) {
+	if (size + text.size() > CAPACITY) {
+		flush();
+		// a block at least as large as the buffer goes out directly
+		if (text.size() >= CAPACITY) {
+			failed |= !write_all(fd, text.data(), text.size());
+			return;
+		}
+	}
+	std::memcpy(buffer.data() + size, text.data(), text.size());
+	size += text.size();
+}
+
+bool files::Writer::flush() {
+	if (size) {
+		failed |= !write_all(fd, buffer.data(), size);
+		size = 0;
+	}
+	return !failed;
+}
+
+std::string files::read(const std::string& path) {
+	Mapping file(path);
+	std::string text(file.view());
+	if (file.truncated()) {
+		file.reload();
+		text = file.view();
+	}
+	return text;
+}
+
+bool files::write(const std::string& path, std::string_view text) {
+	close(path);
+	try {
+		Writer writer(path, false);
+		writer.write(text);
+		return writer.flush();
+	} catch (const std::runtime_error&) {
+		return false;
+	}
+}
+
+bool files::append(const std::string& path, std::string_view text) {
+	static bool installed = false;
+	if (!installed) {
+		installed = true;
+		previous = std::set_terminate(close_and_terminate);
+	}
+	std::lock_guard lock(registry);
+	auto& open = writers();
+	auto& writer = open[path];
+	if (!writer) {
+		try {
+			writer = std::make_unique<Writer>(path, true);
+		} catch (const std::runtime_error&) {
+			open.erase(path);
+			return false;
+		}
+	}
+	writer->write(text);
+	return writer->good();
+}
+
+void files::close(const std::string& path) {
+	std::lock_guard lock(registry);
+	writers().erase(path);
+}
@@ -0,0 +1,37 @@
+#include <cstdlib>
+#include <new>
+
+#include "budget.hpp"
+#include "stats.hpp"
+
+// The global operator new and delete of the interpreter program. They count
+// allocations for --stats and memory for budgets. This file is not part of
+// libinterpreter, so that the library does not replace them in the program
+// embedding it; a host that wants memory limits links build/lib/heap.o.
+
+static const bool installed = (Budget::install(), true);
+
+void* operator new(std::size_t size) {
+	Stats::counted(size);
+	void* ptr = std::malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	try {
+		Budget::allocated(ptr);
+	} catch (...) {
+		std::free(ptr);
+		throw;
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+	Budget::freed(ptr);
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	Budget::freed(ptr);
+	std::free(ptr);
+}
@@ -0,0 +1,192 @@
+#include "input.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+	inline bool is_space(char c) {
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	inline bool is_digit(char c) {
+		return static_cast<unsigned char>(c - '0') < 10;
+	}
+
+	// powers of ten that are exact in a double
+	constexpr double POW10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	bool parse_int(std::string_view s, int& out) {
+		const char* p = s.data();
+		const char* last = p + s.size();
+		bool negative = false;
+		if (p != last && (*p == '-' || *p == '+')) negative = *p++ == '-';
+		if (p == last) return false;
+		// leading zeros do not count towards the ten digits an int can have
+		std::uint64_t value = 0;
+		int digits = 0;
+		for (; p != last; p++) {
+			if (!is_digit(*p)) return false;
+			if (value || *p != '0') digits++;
+			if (digits > 10) return false;
+			value = value * 10 + (*p - '0');
+		}
+		if (value > static_cast<std::uint64_t>(std::numeric_limits<int>::max()) + negative) return false;
+		out = negative ? static_cast<int>(-static_cast<std::int64_t>(value)) : static_cast<int>(value);
+		return true;
+	}
+
+	bool parse_double(std::string_view s, double& out) {
+		const char* p = s.data();
+		const char* last = p + s.size();
+		bool negative = false;
+		if (p != last && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+		// fast path: at most 19 significant digits and a small exponent, where
+		// one multiplication or division by an exact power of ten is correctly
+		// rounded; everything else goes through from_chars
+		std::uint64_t mantissa = 0;
+		int digits = 0, exponent = 0;
+		bool any = false;
+		for (; p != last && is_digit(*p); p++, any = true) {
+			if (mantissa || *p != '0') digits++;
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+		if (p != last && *p == '.') {
+			for (p++; p != last && is_digit(*p); p++, any = true) {
+				if (mantissa || *p != '0') digits++;
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
+			}
+		}
+		if (any && p != last && (*p == 'e' || *p == 'E')) {
+			const char* q = p + 1;
+			bool negativeExp = false;
+			if (q != last && (*q == '-' || *q == '+')) negativeExp = *q++ == '-';
+			int e = 0;
+			bool expDigits = false;
+			for (; q != last && is_digit(*q) && e < 100000; q++, expDigits = true) e = e * 10 + (*q - '0');
+			if (expDigits) {
+				exponent += negativeExp ? -e : e;
+				p = q;
+			}
+		}
+		if (any && p == last && digits <= 19 && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+			double value = static_cast<double>(mantissa);
+			value = exponent < 0 ? value / POW10[-exponent] : value * POW10[exponent];
+			out = negative ? -value : value;
+			return true;
+		}
+
+		const char* first = s.data() + (!s.empty() && s[0] == '+');
+		auto result = std::from_chars(first, s.data() + s.size(), out);
+		return result.ec == std::errc() && result.ptr == s.data() + s.size();
+	}
+}
+
+Input::Input(int fd) : fd(fd) {
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			madvise(map, info.st_size, MADV_SEQUENTIAL);
+			off_t offset = lseek(fd, 0, SEEK_CUR);
+			data = static_cast<const char*>(map);
+			pos = offset > 0 ? std::min<std::size_t>(offset, info.st_size) : 0;
+			end = info.st_size;
+			mapped = true;
+			return;
+		}
+	}
+	buffer.resize(CAPACITY);
+	data = buffer.data();
+}
+
+Input::~Input() {
+	if (mapped) munmap(const_cast<char*>(data), end);
+}
+
+bool Input::refill() {
+	if (mapped || eof) return false;
+	std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+	end -= pos;
+	pos = 0;
+	if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+	data = buffer.data();
+	ssize_t n;
+	do {
+		n = ::read(fd, buffer.data() + end, buffer.size() - end);
+	} while (n < 0 && errno == EINTR);
+	if (n <= 0) {
+		eof = true;
+		return false;
+	}
+	end += n;
+	return true;
+}
+
+bool Input::skip_space() {
+	while (true) {
+		while (pos < end && is_space(data[pos])) pos++;
+		if (pos < end) return true;
+		if (!refill()) return false;
+	}
+}
+
+std::string_view Input::token() {
+	std::size_t length = 0;
+	while (true) {
+		while (pos + length < end && !is_space(data[pos + length])) length++;
+		if (pos + length < end || !refill()) break;
+	}
+	std::string_view result(data + pos, length);
+	pos += length;
+	return result;
+}
+
+bool Input::read(int& value) {
+	return skip_space() && parse_int(token(), value);
+}
+
+bool Input::read(double& value) {
+	return skip_space() && parse_double(token(), value);
+}
+
+bool Input::read(char& value) {
+	if (!skip_space()) return false;
+	value = data[pos++];
+	return true;
+}
+
+bool Input::read(bool& value) {
+	if (!skip_space()) return false;
+	auto s = token();
+	if (s == "1" || s == "true") value = true;
+	else if (s == "0" || s == "false") value = false;
+	else return false;
+	return true;
+}
+
+bool Input::read(std::string& value) {
+	if (!skip_space()) return false;
+	value = token();
+	return true;
+}
+
+bool Input::interactive() const {
+	return !mapped && isatty(fd);
+}
+
+Input& Input::standard() {
+	static Input in(STDIN_FILENO);
+	return in;
+}
@@ -5,29 +5,166 @@
 #include "parser.hpp"
 
 #include "visitor.hpp"
+#include "program.hpp"
+#include "batch.hpp"
+#include "optimizer.hpp"
+#include "pruner.hpp"
+#include "output.hpp"
 
-Interpreter::Interpreter(const char* input) {
-    readManager readmanager{std::string(input)};
-	auto buf = readmanager.get();
+Interpreter::Interpreter(Stats* stats, Profiler* profiler) : stats(stats), profiler(profiler) {}
 
-    Lexer l(buf);
-    auto tokens = l.tokenize();
+Interpreter::Interpreter(const char* input, Stats* stats, Profiler* profiler) : stats(stats), profiler(profiler) {
+    std::string buf;
+    {
+        Stats::Phase phase(stats, "read");
+        readManager readmanager{std::string(input)};
+        buf = readmanager.get();
+    }
+    parse(buf);
+}
+
+Interpreter Interpreter::source(const std::string& text, Stats* stats, Profiler* profiler) {
+    Interpreter interpreter(stats, profiler);
+    interpreter.parse(text);
+    return interpreter;
+}
+
+void Interpreter::parse(const std::string& buf) {
+    std::vector<Token> tokens;
+    {
+        Stats::Phase phase(stats, "lexer");
+        Lexer l(buf);
+        tokens = l.tokenize();
+    }
 
     Parser p(tokens);
-    nodes = p.parse();
+    {
+        Stats::Phase phase(stats, "parser");
+        nodes = p.parse();
+    }
+
+    if (stats) {
+        stats->count("tokens", tokens.size());
+        stats->count("ast_nodes", p.node_count());
+    }
+}
+
+void Interpreter::prune(const std::string& entry) {
+    Pruner pruner(stats);
+    {
+        Stats::Phase phase(stats, "pruner");
+        pruner.prune(nodes, entry);
+    }
+    if (stats) {
+        stats->count("removed_decls", pruner.declarations());
+        stats->count("removed_stmts", pruner.statements());
+    }
 }
 
 void Interpreter::print() {
+    Stats::Phase phase(stats, "printer");
     Printer printer;
     printer.print(nodes);
 }
 
 void Interpreter::analyze() {
     Analyzer analyzer;
-    analyzer.analyze(nodes);
+    {
+        Stats::Phase phase(stats, "analyzer");
+        analyzer.analyze(nodes);
+    }
+    if (stats) stats->count("symbols", analyzer.symbol_count());
+}
+
+void Interpreter::optimize() {
+    Optimizer optimizer(stats);
+    {
+        Stats::Phase phase(stats, "optimizer");
+        optimizer.optimize(nodes);
+    }
+    if (stats) {
+        stats->count("hoisted", optimizer.hoisted());
+        stats->count("reduced", optimizer.reduced());
+    }
+}
+
+void Interpreter::limit(std::uint64_t steps, std::chrono::milliseconds time, std::size_t bytes) {
+    maxSteps = steps;
+    timeout = time;
+    maxMemory = bytes;
+}
+
+// with stats a budget without limits counts the steps and memory of the run
+std::shared_ptr<Budget> Interpreter::budget() const {
+    if (!maxSteps && !timeout.count() && !maxMemory && !stats) return nullptr;
+    return std::make_shared<Budget>(maxSteps, timeout, maxMemory);
+}
+
+// what was run so far is flushed and counted also when the budget ran out
+void Interpreter::finish(const std::shared_ptr<Budget>& budget) {
+    if (profiler) profiler->stop();
+    Output::standard().flush();
+    if (stats && budget) {
+        stats->count("steps", budget->used());
+        stats->count("memory", budget->memory());
+        stats->count("peak_memory", budget->peak_memory());
+    }
 }
 
 void Interpreter::execute() {
-    Executor executor;
-    executor.execute(nodes);
+    Stats::Phase phase(stats, "executor");
+    auto budget = this->budget();
+    if (profiler) profiler->start();
+    try {
+        Program program(nodes, budget);
+        ExecutionContext context(program, profiler);
+        context.limit(budget);
+        try {
+            context.run();
+        } catch (...) {
+            // calls spawned in the context must not outlive it
+            context.wait();
+            throw;
+        }
+        // spawned calls that were never awaited still run to the end
+        context.wait();
+    } catch (BudgetExceeded& e) {
+        finish(budget);
+        // the executors have given back the steps they took and did not use
+        e.steps = budget->used();
+        throw;
+    } catch (const MemoryExceeded& e) {
+        finish(budget);
+        throw BudgetExceeded(e.what(), budget->used());
+    }
+    finish(budget);
+}
+
+std::vector<double> Interpreter::batch(const std::string& name, const std::vector<std::vector<double>>& columns) {
+    Stats::Phase phase(stats, "executor");
+    auto budget = this->budget();
+    std::vector<double> results;
+    try {
+        Program program(nodes, budget);
+        Batch batch(program, name, profiler, budget);
+        if (stats) stats->count("batch_vectorized", batch.vectorized());
+        if (profiler) profiler->start();
+        results = batch.run(columns);
+    } catch (BudgetExceeded& e) {
+        finish(budget);
+        // the executors have given back the steps they took and did not use
+        e.steps = budget->used();
+        throw;
+    } catch (const MemoryExceeded& e) {
+        finish(budget);
+        throw BudgetExceeded(e.what(), budget->used());
+    }
+    finish(budget);
+    return results;
+}
+
+std::shared_ptr<const Program> Interpreter::compile() {
+    analyze();
+    Stats::Phase phase(stats, "executor");
+    return std::make_shared<const Program>(nodes);
 }
@@ -0,0 +1,253 @@
+#include "kernels.hpp"
+#include "parallel.hpp"
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace {
+	template <typename V>
+	using element_t = std::decay_t<decltype(std::declval<V>()[0])>;
+
+	// The bodies are written once over GCC vector types and inlined into one
+	// wrapper per instruction set, so the same code is compiled for each
+	// target. Integer sums and products use unsigned lanes so that they wrap.
+
+	// Sums are added into PARTIALS partial sums whatever the vector width,
+	// x[i] into the one at i % PARTIALS, and those are added up in order, so
+	// that a double sum comes out the same with SSE2 and with AVX2.
+	constexpr std::size_t PARTIALS = 8;
+
+	template <typename V>
+	[[gnu::always_inline]] inline element_t<V> sum_body(const element_t<V>* x, std::size_t n) {
+		using T = element_t<V>;
+		constexpr std::size_t L = sizeof(V) / sizeof(T);
+		V a[PARTIALS / L] = {};
+		std::size_t i = 0;
+		for (; i + PARTIALS <= n; i += PARTIALS) {
+			for (std::size_t j = 0; j < PARTIALS / L; j++) {
+				V u;
+				__builtin_memcpy(&u, x + i + j * L, sizeof(V));
+				a[j] += u;
+			}
+		}
+		T p[PARTIALS];
+		__builtin_memcpy(p, a, sizeof(p));
+		T s = 0;
+		for (std::size_t k = 0; k < PARTIALS; k++) s += p[k];
+		for (; i < n; i++) s += x[i];
+		return s;
+	}
+
+	template <typename V>
+	[[gnu::always_inline]] inline element_t<V> dot_body(const element_t<V>* x, const element_t<V>* y, std::size_t n) {
+		using T = element_t<V>;
+		constexpr std::size_t L = sizeof(V) / sizeof(T);
+		V a[PARTIALS / L] = {};
+		std::size_t i = 0;
+		for (; i + PARTIALS <= n; i += PARTIALS) {
+			for (std::size_t j = 0; j < PARTIALS / L; j++) {
+				V u, v;
+				__builtin_memcpy(&u, x + i + j * L, sizeof(V));
+				__builtin_memcpy(&v, y + i + j * L, sizeof(V));
+				a[j] += u * v;
+			}
+		}
+		T p[PARTIALS];
+		__builtin_memcpy(p, a, sizeof(p));
+		T s = 0;
+		for (std::size_t k = 0; k < PARTIALS; k++) s += p[k];
+		for (; i < n; i++) s += x[i] * y[i];
+		return s;
+	}
+
+	template <typename V, bool Max>
+	[[gnu::always_inline]] inline element_t<V> extreme_body(const element_t<V>* x, std::size_t n) {
+		using T = element_t<V>;
+		constexpr std::size_t L = sizeof(V) / sizeof(T);
+		T m = x[0];
+		std::size_t i = 0;
+		if (n >= L) {
+			V a;
+			__builtin_memcpy(&a, x, sizeof(V));
+			for (i = L; i + L <= n; i += L) {
+				V u;
+				__builtin_memcpy(&u, x + i, sizeof(V));
+				a = Max ? (u > a ? u : a) : (u < a ? u : a);
+			}
+			m = a[0];
+			for (std::size_t k = 1; k < L; k++) m = Max ? (a[k] > m ? a[k] : m) : (a[k] < m ? a[k] : m);
+		}
+		for (; i < n; i++) m = Max ? (x[i] > m ? x[i] : m) : (x[i] < m ? x[i] : m);
+		return m;
+	}
+
+	template <typename V>
+	[[gnu::always_inline]] inline void scale_body(element_t<V>* x, element_t<V> a, std::size_t n) {
+		using T = element_t<V>;
+		constexpr std::size_t L = sizeof(V) / sizeof(T);
+		std::size_t i = 0;
+		for (; i + L <= n; i += L) {
+			V u;
+			__builtin_memcpy(&u, x + i, sizeof(V));
+			u *= a;
+			__builtin_memcpy(x + i, &u, sizeof(V));
+		}
+		for (; i < n; i++) x[i] *= a;
+	}
+
+	template <typename V>
+	[[gnu::always_inline]] inline void axpy_body(element_t<V> a, const element_t<V>* x, element_t<V>* y, std::size_t n) {
+		using T = element_t<V>;
+		constexpr std::size_t L = sizeof(V) / sizeof(T);
+		std::size_t i = 0;
+		for (; i + L <= n; i += L) {
+			V u, v;
+			__builtin_memcpy(&u, x + i, sizeof(V));
+			__builtin_memcpy(&v, y + i, sizeof(V));
+			v += a * u;
+			__builtin_memcpy(y + i, &v, sizeof(V));
+		}
+		for (; i < n; i++) y[i] += a * x[i];
+	}
+
+#define DEFINE_KERNELS(NAME, TARGET, BYTES) \
+	struct NAME { \
+		using vi = int __attribute__((vector_size(BYTES))); \
+		using vu = unsigned __attribute__((vector_size(BYTES))); \
+		using vd = double __attribute__((vector_size(BYTES))); \
+		TARGET static unsigned sum(const unsigned* x, std::size_t n) { return sum_body<vu>(x, n); } \
+		TARGET static double sum(const double* x, std::size_t n) { return sum_body<vd>(x, n); } \
+		TARGET static unsigned dot(const unsigned* x, const unsigned* y, std::size_t n) { return dot_body<vu>(x, y, n); } \
+		TARGET static double dot(const double* x, const double* y, std::size_t n) { return dot_body<vd>(x, y, n); } \
+		TARGET static int min(const int* x, std::size_t n) { return extreme_body<vi, false>(x, n); } \
+		TARGET static double min(const double* x, std::size_t n) { return extreme_body<vd, false>(x, n); } \
+		TARGET static int max(const int* x, std::size_t n) { return extreme_body<vi, true>(x, n); } \
+		TARGET static double max(const double* x, std::size_t n) { return extreme_body<vd, true>(x, n); } \
+		TARGET static void scale(unsigned* x, unsigned a, std::size_t n) { scale_body<vu>(x, a, n); } \
+		TARGET static void scale(double* x, double a, std::size_t n) { scale_body<vd>(x, a, n); } \
+		TARGET static void axpy(unsigned a, const unsigned* x, unsigned* y, std::size_t n) { axpy_body<vu>(a, x, y, n); } \
+		TARGET static void axpy(double a, const double* x, double* y, std::size_t n) { axpy_body<vd>(a, x, y, n); } \
+	};
+
+	// the baseline set is SSE2 on x86-64, whatever the target offers elsewhere
+	DEFINE_KERNELS(Base, , 16)
+#if defined(__x86_64__) || defined(__i386__)
+	DEFINE_KERNELS(Avx2, __attribute__((target("avx2"))), 32)
+
+	bool avx2() {
+		static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+		return supported;
+	}
+
+	template <typename F>
+	auto dispatch(F&& f) {
+		return avx2() ? f(Avx2{}) : f(Base{});
+	}
+#else
+	template <typename F>
+	auto dispatch(F&& f) {
+		return f(Base{});
+	}
+#endif
+#undef DEFINE_KERNELS
+
+	const unsigned* as_unsigned(const int* x) {
+		return reinterpret_cast<const unsigned*>(x);
+	}
+
+	unsigned* as_unsigned(int* x) {
+		return reinterpret_cast<unsigned*>(x);
+	}
+
+	template <typename T>
+	T reduce_sum(const T* x, std::size_t n) {
+		return parallel_reduce<T>(n, [x](std::size_t begin, std::size_t end) {
+			return dispatch([&](auto set) { return set.sum(x + begin, end - begin); });
+		}, std::plus<T>());
+	}
+
+	template <typename T>
+	T reduce_dot(const T* x, const T* y, std::size_t n) {
+		return parallel_reduce<T>(n, [x, y](std::size_t begin, std::size_t end) {
+			return dispatch([&](auto set) { return set.dot(x + begin, y + begin, end - begin); });
+		}, std::plus<T>());
+	}
+
+	template <bool Max, typename T>
+	T reduce_extreme(const T* x, std::size_t n) {
+		return parallel_reduce<T>(n, [x](std::size_t begin, std::size_t end) {
+			return dispatch([&](auto set) { return Max ? set.max(x + begin, end - begin) : set.min(x + begin, end - begin); });
+		}, [](T a, T b) { return Max ? (b > a ? b : a) : (b < a ? b : a); });
+	}
+
+	template <typename T>
+	void map_scale(T* x, T a, std::size_t n) {
+		parallel_for(n, parallel_chunks(n), [x, a](std::size_t begin, std::size_t end, std::size_t) {
+			dispatch([&](auto set) { set.scale(x + begin, a, end - begin); return 0; });
+		});
+	}
+
+	template <typename T>
+	void map_axpy(T a, const T* x, T* y, std::size_t n) {
+		parallel_for(n, parallel_chunks(n), [a, x, y](std::size_t begin, std::size_t end, std::size_t) {
+			dispatch([&](auto set) { set.axpy(a, x + begin, y + begin, end - begin); return 0; });
+		});
+	}
+}
+
+int kernels::sum(const int* x, std::size_t n) {
+	return static_cast<int>(reduce_sum(as_unsigned(x), n));
+}
+
+double kernels::sum(const double* x, std::size_t n) {
+	return reduce_sum(x, n);
+}
+
+int kernels::dot(const int* x, const int* y, std::size_t n) {
+	return static_cast<int>(reduce_dot(as_unsigned(x), as_unsigned(y), n));
+}
+
+double kernels::dot(const double* x, const double* y, std::size_t n) {
+	return reduce_dot(x, y, n);
+}
+
+int kernels::min(const int* x, std::size_t n) {
+	return reduce_extreme<false>(x, n);
+}
+
+double kernels::min(const double* x, std::size_t n) {
+	return reduce_extreme<false>(x, n);
+}
+
+int kernels::max(const int* x, std::size_t n) {
+	return reduce_extreme<true>(x, n);
+}
+
+double kernels::max(const double* x, std::size_t n) {
+	return reduce_extreme<true>(x, n);
+}
+
+void kernels::scale(int* x, int a, std::size_t n) {
+	map_scale(as_unsigned(x), static_cast<unsigned>(a), n);
+}
+
+void kernels::scale(double* x, double a, std::size_t n) {
+	map_scale(x, a, n);
+}
+
+void kernels::axpy(int a, const int* x, int* y, std::size_t n) {
+	map_axpy(static_cast<unsigned>(a), as_unsigned(x), as_unsigned(y), n);
+}
+
+void kernels::axpy(double a, const double* x, double* y, std::size_t n) {
+	map_axpy(a, x, y, n);
+}
+
+const char* kernels::isa() {
+#if defined(__x86_64__) || defined(__i386__)
+	return avx2() ? "avx2" : "sse2";
+#else
+	return "generic";
+#endif
+}
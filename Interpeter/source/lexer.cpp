@@ -1,12 +1,19 @@
 #include "lexer.hpp"
 
-Lexer::Lexer(const std::string& input) : input(input) {}
+#include <algorithm>
+
+Lexer::Lexer(const std::string& input) : input(input), offset(0) {}
 
 std::vector<Token> Lexer::tokenize() {
 	std::vector<Token> tokens;
 	for(; input[offset];) {
+		auto count = tokens.size();
 		if (std::isspace(input[offset])) {
+			if (input[offset] == '\n') ++line;
 			++offset;
+		} else if (input.compare(offset, 3, "...") == 0) {
+			offset += 3;
+			tokens.push_back(Token{TokenType::OPERATOR, "..."});
 		} else if (std::isdigit(input[offset]) || input[offset] == '.') {
 			tokens.push_back(extract_number());
 		} else if (std::isalpha(input[offset]) || input[offset] == '_') {
@@ -30,8 +37,9 @@ std::vector<Token> Lexer::tokenize() {
 		} else {
 			throw std::runtime_error("Unknown symbol");
 		}
+		if (tokens.size() != count) tokens.back().line = line;
 	}
-	tokens.push_back(Token{TokenType::END, ""});
+	tokens.push_back(Token{TokenType::END, "", line});
 	return tokens;
 }
 
@@ -46,6 +54,7 @@ Token Lexer::extract_string() {
 	}
 
 	Token token{TokenType::STRING, std::string(input, offset, i)};
+	line += std::count(token.value.begin(), token.value.end(), '\n');
 	offset += i + 1;
 	return token;
 }
@@ -64,10 +73,14 @@ Token Lexer::extract_identifier() {
 		token.type = TokenType::JUMP;
 	} else if (loops.contains(token.value)) {
 		token.type = TokenType::LOOP;
+	} else if (switches.contains(token.value)) {
+		token.type = TokenType::SWITCH;
 	} else if (bools.contains(token.value)) {
 		token.type = TokenType::BOOL;
 	} else if (modifications.contains(token.value)) {
 		token.type = TokenType::MOD;	
+	} else if (tasks.contains(token.value)) {
+		token.type = TokenType::OPERATOR;
 	}
 
 	return token;
@@ -108,7 +121,7 @@ Token Lexer::extract_operator() {
 	std::string op;
 	for(; metachars.contains(input[offset + i]); ++i) {
 		op += input[offset + i];
-		if (op == ":") continue;
+		if (op == ":" || op == "&" || op == "|") continue;
 		if (!operators.contains(op)) {
 			if (i == 0) {
 				throw std::runtime_error("Invalid operator " + op);
@@ -124,9 +137,11 @@ Token Lexer::extract_operator() {
 
 const std::string Lexer::metachars = "+-*/=!|&<>:?";
 const std::unordered_set<std::string> Lexer::operators = {"+", "-", "*", "/", "=", "+=", "-=", "*=", "/=", "==", "!","!=", "||", "&&", "++", "--", ">", ">=", "<", "<=", "::", ":", "?"};
-const std::unordered_set<std::string> Lexer::keyWords = {"int", "double", "char", "void", "bool", "string", "namespace"};
+const std::unordered_set<std::string> Lexer::keyWords = {"int", "double", "char", "void", "bool", "string", "map", "future", "namespace"};
 const std::unordered_set<std::string> Lexer::conditionals = {"if", "else"};
-const std::unordered_set<std::string> Lexer::loops = {"while", "for"};
+const std::unordered_set<std::string> Lexer::loops = {"while", "for", "parallel"};
+const std::unordered_set<std::string> Lexer::switches = {"switch", "case", "default"};
 const std::unordered_set<std::string> Lexer::jumps = {"return", "break", "continue"};
 const std::unordered_set<std::string> Lexer::bools = {"true", "false"};
-const std::unordered_set<std::string> Lexer::modifications = {"const"};
+const std::unordered_set<std::string> Lexer::modifications = {"const", "extern"};
+const std::unordered_set<std::string> Lexer::tasks = {"spawn", "await"};
@@ -1,11 +1,114 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "budget.hpp"
 #include "interpreter.hpp"
+#include "output.hpp"
+#include "parallel.hpp"
+
+// a number of bytes, with an optional K, M or G suffix
+static unsigned long long bytes(const char* text) {
+	char* end;
+	unsigned long long n = std::strtoull(text, &end, 10);
+	switch (*end) {
+		case 'K': case 'k': return n << 10;
+		case 'M': case 'm': return n << 20;
+		case 'G': case 'g': return n << 30;
+		default: return n;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	const char* file = nullptr;
+	const char* profilePath = nullptr;
+	const char* batchName = nullptr;
+	bool statsFlag = false, json = false, optimize = false;
+	unsigned long long maxSteps = 0, timeout = 0, maxMemory = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--stats")) {
+			statsFlag = true;
+		} else if (!std::strcmp(argv[i], "--stats=json")) {
+			statsFlag = json = true;
+		} else if (!std::strcmp(argv[i], "--profile")) {
+			profilePath = "profile.folded";
+		} else if (!std::strncmp(argv[i], "--profile=", 10)) {
+			profilePath = argv[i] + 10;
+		} else if (!std::strcmp(argv[i], "-O")) {
+			optimize = true;
+		} else if (!std::strcmp(argv[i], "--shortest")) {
+			Output::standard().shortest = true;
+		} else if (!std::strncmp(argv[i], "--batch=", 8)) {
+			batchName = argv[i] + 8;
+		} else if (!std::strncmp(argv[i], "--threads=", 10)) {
+			parallel_threads = std::strtoul(argv[i] + 10, nullptr, 10);
+		} else if (!std::strncmp(argv[i], "--max-steps=", 12)) {
+			maxSteps = std::strtoull(argv[i] + 12, nullptr, 10);
+		} else if (!std::strncmp(argv[i], "--timeout=", 10)) {
+			timeout = std::strtoull(argv[i] + 10, nullptr, 10);
+		} else if (!std::strncmp(argv[i], "--max-memory=", 13)) {
+			maxMemory = bytes(argv[i] + 13);
+		} else {
+			file = argv[i];
+		}
+	}
+	if (!file) {
+		std::cerr << "usage: " << argv[0] << " [--stats[=json]] [--profile[=file]] [--batch=function] [--threads=n] [--max-steps=n] [--timeout=ms] [--max-memory=bytes[K|M|G]] [--shortest] [-O] file" << std::endl;
+		return 1;
+	}
 
-int main(int, char* argv[]) {
-	Interpreter inpreteter(argv[1]);
+	Stats stats;
+	Profiler profiler;
+	int status = 0;
+	try {
+		Interpreter inpreteter(file, statsFlag ? &stats : nullptr, profilePath ? &profiler : nullptr);
+		inpreteter.limit(maxSteps, std::chrono::milliseconds(timeout), maxMemory);
 
-	inpreteter.print();
-	inpreteter.analyze();
-	inpreteter.execute();
+		if (batchName) {
+			// one call per line of stdin, arguments separated by whitespace
+			std::vector<std::vector<double>> columns;
+			std::string line;
+			while (std::getline(std::cin, line)) {
+				std::istringstream row(line);
+				std::size_t i = 0;
+				for (double x; row >> x; i++) {
+					if (columns.size() <= i) columns.resize(i + 1);
+					columns[i].push_back(x);
+				}
+			}
+			// pruned after the checks, so -O accepts the same programs
+			inpreteter.analyze();
+			if (optimize) inpreteter.prune(batchName);
+			if (optimize) inpreteter.optimize();
+			auto& out = Output::standard();
+			for (double x : inpreteter.batch(batchName, columns)) {
+				out.write(x);
+				out.newline();
+			}
+			out.flush();
+		} else {
+			inpreteter.print();
+			inpreteter.analyze();
+			if (optimize) inpreteter.prune();
+			if (optimize) inpreteter.optimize();
+			inpreteter.execute();
+		}
+	} catch (const BudgetExceeded& e) {
+		std::cerr << e.what() << " after " << e.steps << " steps" << std::endl;
+		status = 2;
+	}
+	std::cout.flush();
 
-	return 0;
+	if (profilePath) {
+		std::ofstream out(profilePath);
+		profiler.write_folded(out);
+		profiler.write_summary(std::cerr, 10);
+	}
+	if (statsFlag) {
+		stats.report(std::cerr, json);
+	}
+	return status;
 }
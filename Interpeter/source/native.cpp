@@ -0,0 +1,92 @@
+#include "native.hpp"
+
+#include <array>
+#include <dlfcn.h>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+	std::mutex registry;
+
+	// handles stay open until the program ends, since bound functions
+	// are never unbound
+	std::unordered_map<std::string, void*>& libraries() {
+		static std::unordered_map<std::string, void*> open;
+		return open;
+	}
+
+	template <std::size_t>
+	using Integer = long;
+	template <std::size_t>
+	using Double = double;
+
+	template <typename R, std::size_t... I, std::size_t... D>
+	R invoke(void* address, const native::Arguments& args, std::index_sequence<I...>, std::index_sequence<D...>) {
+		return reinterpret_cast<R (*)(Integer<I>..., Double<D>...)>(address)(args.integers[I]..., args.doubles[D]...);
+	}
+
+	template <native::Kind Returned, std::size_t Integers, std::size_t Doubles>
+	native::Result call(void* address, const native::Arguments& args) {
+		auto integers = std::make_index_sequence<Integers>();
+		auto doubles = std::make_index_sequence<Doubles>();
+		native::Result out{};
+		if constexpr (Returned == native::Kind::Void) invoke<void>(address, args, integers, doubles);
+		else if constexpr (Returned == native::Kind::Double) out.real = invoke<double>(address, args, integers, doubles);
+		else out.integer = invoke<long>(address, args, integers, doubles);
+		return out;
+	}
+
+	// thunks by number of integer parameters, then of double parameters
+	template <native::Kind Returned, std::size_t... I>
+	constexpr auto table(std::index_sequence<I...>) {
+		return std::array<native::Thunk, sizeof...(I)>{&call<Returned, I / (native::DOUBLES + 1), I % (native::DOUBLES + 1)>...};
+	}
+
+	template <native::Kind Returned>
+	constexpr auto thunks = table<Returned>(std::make_index_sequence<(native::INTEGERS + 1) * (native::DOUBLES + 1)>());
+}
+
+void* native::resolve(const std::string& library, const std::string& name) {
+	void* handle = RTLD_DEFAULT;
+	if (!library.empty()) {
+		std::lock_guard lock(registry);
+		auto& open = libraries()[library];
+		if (!open) {
+			open = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+			if (!open) {
+				libraries().erase(library);
+				throw std::runtime_error("cannot load " + library + ": " + dlerror());
+			}
+		}
+		handle = open;
+	}
+	void* address = dlsym(handle, name.c_str());
+	if (!address) {
+		throw std::runtime_error("extern function " + name + " not found" + (library.empty() ? "" : " in " + library));
+	}
+	return address;
+}
+
+native::Thunk native::thunk(const std::string& name, Kind result, const std::vector<Kind>& parameters) {
+#if (defined(__x86_64__) && !defined(_WIN64)) || defined(__aarch64__)
+	std::size_t integers = 0, doubles = 0;
+	for (auto kind : parameters) {
+		kind == Kind::Double ? doubles++ : integers++;
+	}
+	if (integers > INTEGERS || doubles > DOUBLES) {
+		throw std::runtime_error("extern function " + name + " takes more than " + std::to_string(INTEGERS) + " integer or " + std::to_string(DOUBLES) + " double parameters");
+	}
+	std::size_t i = integers * (DOUBLES + 1) + doubles;
+	switch (result) {
+		case Kind::Void: return thunks<Kind::Void>[i];
+		case Kind::Double: return thunks<Kind::Double>[i];
+		default: return thunks<Kind::Int>[i];
+	}
+#else
+	(void)result;
+	(void)parameters;
+	throw std::runtime_error("extern function " + name + ": extern functions need the System V x86-64 or AAPCS64 calling convention");
+#endif
+}
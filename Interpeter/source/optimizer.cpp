@@ -0,0 +1,593 @@
+#include "optimizer.hpp"
+
+#include <iostream>
+#include <sstream>
+
+#include "visitor.hpp"
+
+namespace {
+	const std::unordered_set<std::string> assignment_operators = {"=", "+=", "-=", "/=", "*="};
+
+	// A::B::x as "A::B::x", with last set to the x or the call at its end
+	std::string qualified(const expression& node, expression& last) {
+		auto binary = std::dynamic_pointer_cast<BinaryNode>(node);
+		if (!binary || binary->op != "::") {
+			last = node;
+			if (auto name = std::dynamic_pointer_cast<IdentifierNode>(node); name) return name->name;
+			if (auto call = std::dynamic_pointer_cast<FunctionNode>(node); call) return call->name;
+			return "";
+		}
+		auto space = std::dynamic_pointer_cast<IdentifierNode>(binary->left_branch);
+		auto rest = space ? qualified(binary->right_branch, last) : "";
+		return rest.empty() ? "" : space->name + "::" + rest;
+	}
+
+	// the variable an assignment to node writes, through parentheses and
+	// subscripts
+	expression target(expression node) {
+		while (true) {
+			if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) node = paren->expr;
+			else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) node = index->branch;
+			else return node;
+		}
+	}
+
+	// the text the printer gives node
+	std::string text(const expression& node) {
+		std::ostringstream out;
+		auto buffer = std::cout.rdbuf(out.rdbuf());
+		Printer printer;
+		node->accept(printer);
+		std::cout.rdbuf(buffer);
+		return out.str();
+	}
+
+	// a computation worth a slot, not a bare name or literal
+	bool worth(const expression& node) {
+		if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) return worth(paren->expr);
+		if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+			if (binary->op == "::") {
+				expression last;
+				qualified(node, last);
+				return std::dynamic_pointer_cast<FunctionNode>(last) != nullptr;
+			}
+			return !assignment_operators.contains(binary->op);
+		}
+		if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+			return prefix->op != "++" && prefix->op != "--" && !std::dynamic_pointer_cast<Literal>(prefix->branch);
+		}
+		return std::dynamic_pointer_cast<TernaryNode>(node) || std::dynamic_pointer_cast<FunctionNode>(node);
+	}
+}
+
+Optimizer::Optimizer(Stats* stats) : stats(stats) {}
+
+void Optimizer::optimize(std::vector<declaration>& nodes) {
+	for (auto& decl : nodes) {
+		declare(decl);
+	}
+}
+
+// A function is clean when the analyzer found it pure and it writes no
+// element of an array or map it was passed or that is global, which the
+// analyzer leaves to the caller. Only clean functions are hoisted.
+void Optimizer::declare(const declaration& decl) {
+	if (auto space = std::dynamic_pointer_cast<Namespace_decl>(decl); space) {
+		auto outer = nameSpace;
+		nameSpace += space->name + "::";
+		for (auto& inner : space->declarations) {
+			declare(inner);
+		}
+		nameSpace = outer;
+	} else if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl); vars) {
+		bool constant = std::dynamic_pointer_cast<ConstVariable>(decl) != nullptr;
+		for (auto& var : vars->vars) globals[nameSpace + var.first] = constant;
+	} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl); array) {
+		for (auto& var : array->vars) globals[nameSpace + var.first] = false;
+	} else if (auto external = std::dynamic_pointer_cast<Extern_decl>(decl); external) {
+		functions[nameSpace + external->name] = false;
+	} else if (auto func = std::dynamic_pointer_cast<Functions_decl>(decl); func) {
+		auto name = nameSpace + func->name;
+		// calls of the function to itself are taken to be clean meanwhile
+		functions[name] = func->pure;
+		locals.emplace_back();
+		for (auto& param : func->parameters) locals.back().insert(param.second);
+		Loop body;
+		body.scopes.emplace_back();
+		scan(func->block_statement, body);
+		bool clean = func->pure && !body.globals;
+		for (auto& written : body.written) {
+			if (body.declared.contains(written)) continue;
+			for (auto& param : func->parameters) {
+				if (param.second == written && (param.first.ends_with("[]") || param.first.starts_with("map<"))) clean = false;
+			}
+		}
+		functions[name] = clean;
+		walk(func->block_statement);
+		locals.pop_back();
+	}
+}
+
+// finds the loops of a function body, keeping track of its local names
+void Optimizer::walk(const statement& node) {
+	if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		locals.emplace_back();
+		for (auto& state : block->body) walk(state);
+		locals.pop_back();
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) locals.back().insert(var.first);
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) locals.back().insert(var.first);
+		}
+	} else if (auto loop = std::dynamic_pointer_cast<While_statement>(node); loop) {
+		this->loop(*loop);
+		locals.emplace_back();
+		walk(loop->body);
+		locals.pop_back();
+	} else if (auto loop = std::dynamic_pointer_cast<For_statement>(node); loop) {
+		this->loop(*loop);
+		locals.emplace_back();
+		if (loop->var) walk(loop->var);
+		for (auto& induction : loop->inductions) locals.back().insert(induction.name);
+		walk(loop->body);
+		locals.pop_back();
+	} else if (auto loop = std::dynamic_pointer_cast<ForEach_statement>(node); loop) {
+		locals.emplace_back();
+		locals.back().insert(loop->name);
+		walk(loop->body);
+		locals.pop_back();
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		locals.emplace_back();
+		for (auto& state : cases->body) walk(state);
+		locals.pop_back();
+	} else if (auto block = std::dynamic_pointer_cast<ConditionalBlock>(node); block) {
+		for (auto& branch : block->branches) walk(branch);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		locals.emplace_back();
+		walk(branch->body);
+		locals.pop_back();
+	}
+}
+
+void Optimizer::loop(While_statement& root) {
+	Loop loop;
+	loop.scopes.emplace_back();
+	loop.slots = &root.hoisted;
+	scan(root.cond, loop);
+	scan(root.body, loop);
+	hoist(root.cond, loop);
+	hoist(root.body, loop);
+}
+
+void Optimizer::loop(For_statement& root) {
+	if (root.parallel) return;
+	Loop loop;
+	loop.scopes.emplace_back();
+	loop.slots = &root.hoisted;
+	if (root.var) scan(root.var, loop);
+	scan(root.cond, loop);
+	scan(root.Expr, loop);
+	scan(root.body, loop);
+	hoist(root.cond, loop);
+	hoist(root.Expr, loop);
+	hoist(root.body, loop);
+	reduce(root);
+}
+
+// for (int i = a; ...; i += k) with i written nowhere else: i * c becomes
+// a value that starts at a * c and grows by k * c with every step
+void Optimizer::reduce(For_statement& root) {
+	auto decl = root.var ? std::dynamic_pointer_cast<Decl_statement>(root.var) : nullptr;
+	auto vars = decl ? std::dynamic_pointer_cast<Variables_decl>(decl->var) : nullptr;
+	if (!vars || vars->type != "int" || vars->vars.size() != 1 || !root.cond) return;
+	auto& counter = vars->vars[0].first;
+
+	auto update = std::dynamic_pointer_cast<Expression_statement>(root.Expr);
+	expression operand;
+	int step = 0;
+	if (!update) return;
+	if (auto postfix = std::dynamic_pointer_cast<PostfixNode>(update->expr); postfix) {
+		operand = postfix->branch;
+		step = postfix->op == "++" ? 1 : -1;
+	} else if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(update->expr); prefix && (prefix->op == "++" || prefix->op == "--")) {
+		operand = prefix->branch;
+		step = prefix->op == "++" ? 1 : -1;
+	} else if (auto binary = std::dynamic_pointer_cast<BinaryNode>(update->expr); binary && (binary->op == "+=" || binary->op == "-=")) {
+		auto amount = std::dynamic_pointer_cast<IntNode>(binary->right_branch);
+		if (!amount) return;
+		operand = binary->left_branch;
+		step = binary->op == "+=" ? amount->value : -amount->value;
+	}
+	auto name = std::dynamic_pointer_cast<IdentifierNode>(operand);
+	if (!name || name->name != counter) return;
+
+	Loop loop;
+	loop.scopes.emplace_back();
+	scan(root.cond, loop);
+	scan(root.body, loop);
+	if (loop.written.contains(counter) || loop.declared.contains(counter)) return;
+	replace(root.cond, counter, root.inductions, step);
+	replace(root.body, counter, root.inductions, step);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void Optimizer::scan(const statement& node, Loop& loop) {
+	if (auto expr = std::dynamic_pointer_cast<Expression_statement>(node); expr) {
+		scan(expr->expr, loop);
+	} else if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		loop.scopes.emplace_back();
+		for (auto& state : block->body) scan(state, loop);
+		loop.scopes.pop_back();
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) {
+				scan(var.second, loop);
+				loop.scopes.back().insert(var.first);
+				loop.declared.insert(var.first);
+			}
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) {
+				scan(var.second, loop);
+				loop.scopes.back().insert(var.first);
+				loop.declared.insert(var.first);
+			}
+		}
+	} else if (auto inner = std::dynamic_pointer_cast<While_statement>(node); inner) {
+		scan(inner->cond, loop);
+		loop.scopes.emplace_back();
+		scan(inner->body, loop);
+		loop.scopes.pop_back();
+	} else if (auto inner = std::dynamic_pointer_cast<For_statement>(node); inner) {
+		loop.scopes.emplace_back();
+		if (inner->var) scan(inner->var, loop);
+		scan(inner->cond, loop);
+		scan(inner->Expr, loop);
+		scan(inner->body, loop);
+		loop.scopes.pop_back();
+	} else if (auto inner = std::dynamic_pointer_cast<ForEach_statement>(node); inner) {
+		scan(inner->range, loop);
+		loop.scopes.emplace_back();
+		loop.scopes.back().insert(inner->name);
+		loop.declared.insert(inner->name);
+		scan(inner->body, loop);
+		loop.scopes.pop_back();
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		scan(cases->value, loop);
+		loop.scopes.emplace_back();
+		for (auto& state : cases->body) scan(state, loop);
+		loop.scopes.pop_back();
+	} else if (auto block = std::dynamic_pointer_cast<ConditionalBlock>(node); block) {
+		for (auto& branch : block->branches) scan(branch, loop);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		if (branch->key != "else") scan(branch->cond, loop);
+		loop.scopes.emplace_back();
+		scan(branch->body, loop);
+		loop.scopes.pop_back();
+	} else if (auto ret = std::dynamic_pointer_cast<Return_statement>(node); ret) {
+		scan(ret->expr, loop);
+	}
+}
+
+void Optimizer::scan(const expression& node, Loop& loop) {
+	if (!node) return;
+	if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+		if (binary->op == "::") {
+			expression last;
+			auto name = qualified(node, last);
+			if (auto called = std::dynamic_pointer_cast<FunctionNode>(last); called) call(name, called->branches, loop);
+			return;
+		}
+		if (assignment_operators.contains(binary->op)) write(binary->left_branch, loop);
+		scan(binary->left_branch, loop);
+		scan(binary->right_branch, loop);
+	} else if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+		if (prefix->op == "++" || prefix->op == "--") write(prefix->branch, loop);
+		scan(prefix->branch, loop);
+	} else if (auto postfix = std::dynamic_pointer_cast<PostfixNode>(node); postfix) {
+		write(postfix->branch, loop);
+		scan(postfix->branch, loop);
+	} else if (auto called = std::dynamic_pointer_cast<FunctionNode>(node); called) {
+		call(called->name, called->branches, loop);
+	} else if (auto spawn = std::dynamic_pointer_cast<SpawnNode>(node); spawn) {
+		scan(spawn->call, loop);
+	} else if (auto await = std::dynamic_pointer_cast<AwaitNode>(node); await) {
+		scan(await->handle, loop);
+	} else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) {
+		scan(index->branch, loop);
+		scan(index->index, loop);
+	} else if (auto ternary = std::dynamic_pointer_cast<TernaryNode>(node); ternary) {
+		scan(ternary->cond, loop);
+		scan(ternary->true_expression, loop);
+		scan(ternary->false_expression, loop);
+	} else if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) {
+		scan(paren->expr, loop);
+	}
+}
+
+// a function that is not clean may write any global and the arrays passed
+// to it, and builtins that are not read-only the variables passed to them
+void Optimizer::call(const std::string& name, const std::vector<expression>& args, Loop& loop) {
+	for (auto& arg : args) scan(arg, loop);
+	bool found;
+	auto clean = callee(name, found);
+	// batch(f, columns...) only reads the columns, but calls f
+	if (!found && name == "batch" && !args.empty()) {
+		expression last;
+		if (!callee(qualified(args[0], last), found)) loop.globals = true;
+		return;
+	}
+	if (found ? clean : readonly.contains(name)) return;
+	if (found) loop.globals = true;
+	for (auto& arg : args) {
+		if (std::dynamic_pointer_cast<IdentifierNode>(target(arg))) write(arg, loop);
+	}
+}
+
+void Optimizer::write(const expression& node, Loop& loop) {
+	auto name = std::dynamic_pointer_cast<IdentifierNode>(target(node));
+	if (!name) {
+		loop.globals = true;
+		return;
+	}
+	loop.written.insert(name->name);
+	for (auto& scope : loop.scopes) {
+		if (scope.contains(name->name)) return;
+	}
+	if (!local(name->name)) loop.globals = true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+void Optimizer::hoist(const statement& node, Loop& loop) {
+	if (auto expr = std::dynamic_pointer_cast<Expression_statement>(node); expr) {
+		hoist(expr->expr, loop);
+	} else if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		for (auto& state : block->body) hoist(state, loop);
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) hoist(var.second, loop);
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) hoist(var.second, loop);
+		}
+	} else if (auto inner = std::dynamic_pointer_cast<While_statement>(node); inner) {
+		hoist(inner->cond, loop);
+		hoist(inner->body, loop);
+	} else if (auto inner = std::dynamic_pointer_cast<For_statement>(node); inner) {
+		if (inner->parallel) return;
+		if (inner->var) hoist(inner->var, loop);
+		hoist(inner->cond, loop);
+		hoist(inner->Expr, loop);
+		hoist(inner->body, loop);
+	} else if (auto inner = std::dynamic_pointer_cast<ForEach_statement>(node); inner) {
+		hoist(inner->range, loop);
+		hoist(inner->body, loop);
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		hoist(cases->value, loop);
+		for (auto& state : cases->body) hoist(state, loop);
+	} else if (auto block = std::dynamic_pointer_cast<ConditionalBlock>(node); block) {
+		for (auto& branch : block->branches) hoist(branch, loop);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		if (branch->key != "else") hoist(branch->cond, loop);
+		hoist(branch->body, loop);
+	} else if (auto ret = std::dynamic_pointer_cast<Return_statement>(node); ret) {
+		hoist(ret->expr, loop);
+	}
+}
+
+void Optimizer::hoist(expression& node, Loop& loop) {
+	if (!node) return;
+	if (worth(node) && invariant(node, loop)) {
+		auto name = slot();
+		loop.slots->push_back(name);
+		note("hoisted", node);
+		hoistCount++;
+		auto line = node->line;
+		node = std::make_shared<HoistedNode>(name, node);
+		node->line = line;
+		return;
+	}
+	if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+		if (binary->op == "::") {
+			expression last;
+			qualified(node, last);
+			if (auto called = std::dynamic_pointer_cast<FunctionNode>(last); called) {
+				for (auto& arg : called->branches) hoist(arg, loop);
+			}
+			return;
+		}
+		if (!assignment_operators.contains(binary->op)) {
+			hoist(binary->left_branch, loop);
+		} else if (auto index = std::dynamic_pointer_cast<IndexNode>(binary->left_branch); index) {
+			hoist(index->index, loop);
+		}
+		hoist(binary->right_branch, loop);
+	} else if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+		if (prefix->op != "++" && prefix->op != "--") hoist(prefix->branch, loop);
+	} else if (auto called = std::dynamic_pointer_cast<FunctionNode>(node); called) {
+		for (auto& arg : called->branches) hoist(arg, loop);
+	} else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) {
+		hoist(index->branch, loop);
+		hoist(index->index, loop);
+	} else if (auto ternary = std::dynamic_pointer_cast<TernaryNode>(node); ternary) {
+		hoist(ternary->cond, loop);
+		hoist(ternary->true_expression, loop);
+		hoist(ternary->false_expression, loop);
+	} else if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) {
+		hoist(paren->expr, loop);
+	}
+}
+
+bool Optimizer::invariant(const expression& node, const Loop& loop) {
+	if (std::dynamic_pointer_cast<Literal>(node) || std::dynamic_pointer_cast<HoistedNode>(node)) return true;
+	if (auto name = std::dynamic_pointer_cast<IdentifierNode>(node); name) return readable(name->name, loop);
+	if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) return invariant(paren->expr, loop);
+	if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+		return prefix->op != "++" && prefix->op != "--" && invariant(prefix->branch, loop);
+	}
+	if (auto ternary = std::dynamic_pointer_cast<TernaryNode>(node); ternary) {
+		return invariant(ternary->cond, loop) && invariant(ternary->true_expression, loop) && invariant(ternary->false_expression, loop);
+	}
+	if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+		if (binary->op == "::") {
+			expression last;
+			auto name = qualified(node, last);
+			if (name.empty()) return false;
+			if (auto called = std::dynamic_pointer_cast<FunctionNode>(last); called) return callable(name, called->branches, loop);
+			return readable(name, loop);
+		}
+		return !assignment_operators.contains(binary->op) && invariant(binary->left_branch, loop) && invariant(binary->right_branch, loop);
+	}
+	if (auto called = std::dynamic_pointer_cast<FunctionNode>(node); called) return callable(called->name, called->branches, loop);
+	return false;
+}
+
+// locals of the function are changed only by the loop itself; globals also
+// by the functions it calls, unless they are const
+bool Optimizer::readable(const std::string& name, const Loop& loop) {
+	if (loop.declared.contains(name) || loop.written.contains(name)) return false;
+	if (name.find("::") == std::string::npos && local(name)) return true;
+	auto constant = global(name);
+	return constant && (*constant || !loop.globals);
+}
+
+bool Optimizer::callable(const std::string& name, const std::vector<expression>& args, const Loop& loop) {
+	if (loop.globals) return false;
+	bool found;
+	auto clean = callee(name, found);
+	if (!found || !clean) return false;
+	for (auto& arg : args) {
+		if (!invariant(arg, loop)) return false;
+	}
+	return true;
+}
+
+void Optimizer::replace(const statement& node, const std::string& counter, std::vector<Induction>& inductions, int step) {
+	if (auto expr = std::dynamic_pointer_cast<Expression_statement>(node); expr) {
+		replace(expr->expr, counter, inductions, step);
+	} else if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		for (auto& state : block->body) replace(state, counter, inductions, step);
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) replace(var.second, counter, inductions, step);
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) replace(var.second, counter, inductions, step);
+		}
+	} else if (auto inner = std::dynamic_pointer_cast<While_statement>(node); inner) {
+		replace(inner->cond, counter, inductions, step);
+		replace(inner->body, counter, inductions, step);
+	} else if (auto inner = std::dynamic_pointer_cast<For_statement>(node); inner) {
+		if (inner->parallel) return;
+		if (inner->var) replace(inner->var, counter, inductions, step);
+		replace(inner->cond, counter, inductions, step);
+		replace(inner->Expr, counter, inductions, step);
+		replace(inner->body, counter, inductions, step);
+	} else if (auto inner = std::dynamic_pointer_cast<ForEach_statement>(node); inner) {
+		replace(inner->range, counter, inductions, step);
+		replace(inner->body, counter, inductions, step);
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		replace(cases->value, counter, inductions, step);
+		for (auto& state : cases->body) replace(state, counter, inductions, step);
+	} else if (auto block = std::dynamic_pointer_cast<ConditionalBlock>(node); block) {
+		for (auto& branch : block->branches) replace(branch, counter, inductions, step);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		if (branch->key != "else") replace(branch->cond, counter, inductions, step);
+		replace(branch->body, counter, inductions, step);
+	} else if (auto ret = std::dynamic_pointer_cast<Return_statement>(node); ret) {
+		replace(ret->expr, counter, inductions, step);
+	}
+}
+
+void Optimizer::replace(expression& node, const std::string& counter, std::vector<Induction>& inductions, int step) {
+	if (!node) return;
+	if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+		if (binary->op == "::") return;
+		if (binary->op == "*") {
+			auto name = std::dynamic_pointer_cast<IdentifierNode>(binary->left_branch);
+			auto factor = std::dynamic_pointer_cast<IntNode>(binary->right_branch);
+			if (!name || !factor) {
+				name = std::dynamic_pointer_cast<IdentifierNode>(binary->right_branch);
+				factor = std::dynamic_pointer_cast<IntNode>(binary->left_branch);
+			}
+			if (name && factor && name->name == counter) {
+				auto induction = inductions.begin();
+				while (induction != inductions.end() && induction->factor != factor->value) induction++;
+				if (induction == inductions.end()) {
+					auto product = static_cast<int>(static_cast<unsigned>(factor->value) * static_cast<unsigned>(step));
+					induction = inductions.insert(inductions.end(), Induction{slot(), counter, factor->value, product});
+				}
+				note("reduced", node);
+				reduceCount++;
+				auto line = node->line;
+				node = std::make_shared<IdentifierNode>(induction->name);
+				node->line = line;
+				return;
+			}
+		}
+		replace(binary->left_branch, counter, inductions, step);
+		replace(binary->right_branch, counter, inductions, step);
+	} else if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+		replace(prefix->branch, counter, inductions, step);
+	} else if (auto called = std::dynamic_pointer_cast<FunctionNode>(node); called) {
+		for (auto& arg : called->branches) replace(arg, counter, inductions, step);
+	} else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) {
+		replace(index->branch, counter, inductions, step);
+		replace(index->index, counter, inductions, step);
+	} else if (auto ternary = std::dynamic_pointer_cast<TernaryNode>(node); ternary) {
+		replace(ternary->cond, counter, inductions, step);
+		replace(ternary->true_expression, counter, inductions, step);
+		replace(ternary->false_expression, counter, inductions, step);
+	} else if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) {
+		replace(paren->expr, counter, inductions, step);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+bool Optimizer::local(const std::string& name) const {
+	for (auto& scope : locals) {
+		if (scope.contains(name)) return true;
+	}
+	return false;
+}
+
+// looked up from the namespace being walked out to the global one
+const bool* Optimizer::global(const std::string& name) const {
+	for (auto space = nameSpace;;) {
+		if (auto found = globals.find(space + name); found != globals.end()) return &found->second;
+		if (space.empty()) return nullptr;
+		auto end = space.rfind("::", space.size() - 3);
+		space.erase(end == std::string::npos ? 0 : end + 2);
+	}
+}
+
+bool Optimizer::callee(const std::string& name, bool& found) const {
+	for (auto space = nameSpace;;) {
+		if (auto function = functions.find(space + name); function != functions.end()) {
+			found = true;
+			return function->second;
+		}
+		if (space.empty()) {
+			found = false;
+			return false;
+		}
+		auto end = space.rfind("::", space.size() - 3);
+		space.erase(end == std::string::npos ? 0 : end + 2);
+	}
+}
+
+// $ cannot start a name in a script
+std::string Optimizer::slot() {
+	return "$" + std::to_string(slots++);
+}
+
+void Optimizer::note(const std::string& kind, const expression& node) {
+	if (stats) stats->note(kind, node->line, text(node));
+}
+
+const std::unordered_set<std::string> Optimizer::readonly = {
+	"print", "println", "len", "sum", "dot", "min", "max", "contains", "lower_bound", "binary_search",
+	"find", "count", "replace", "split", "starts_with", "ends_with", "concat", "join",
+	"read_file", "lines", "write_file", "append_file"
+};
@@ -0,0 +1,70 @@
+#include "output.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <unistd.h>
+
+namespace {
+	std::terminate_handler previous = nullptr;
+
+	// uncaught runtime errors end in std::terminate without running static
+	// destructors, so whatever the script printed so far is written out here
+	void flush_and_terminate() {
+		Output::standard().flush();
+		if (previous) previous();
+		std::abort();
+	}
+}
+
+Output::Output(std::FILE* file) : file(file), lineBuffered(isatty(fileno(file))) {}
+
+Output::~Output() {
+	flush();
+}
+
+void Output::write(std::string_view text) {
+	while (!text.empty()) {
+		if (size == CAPACITY) flush();
+		std::size_t n = std::min(text.size(), CAPACITY - size);
+		std::memcpy(buffer + size, text.data(), n);
+		size += n;
+		text.remove_prefix(n);
+	}
+}
+
+void Output::write(int value) {
+	if (CAPACITY - size < 16) flush();
+	size = std::to_chars(buffer + size, buffer + CAPACITY, value).ptr - buffer;
+}
+
+void Output::write(double value) {
+	if (CAPACITY - size < 32) flush();
+	auto result = shortest ? std::to_chars(buffer + size, buffer + CAPACITY, value)
+		: std::to_chars(buffer + size, buffer + CAPACITY, value, std::chars_format::general, 6);
+	size = result.ptr - buffer;
+}
+
+void Output::newline() {
+	put('\n');
+	if (lineBuffered) flush();
+}
+
+void Output::flush() {
+	if (size) {
+		std::fwrite(buffer, 1, size, file);
+		size = 0;
+	}
+	std::fflush(file);
+}
+
+Output& Output::standard() {
+	static Output out(stdout);
+	static bool installed = false;
+	if (!installed) {
+		installed = true;
+		previous = std::set_terminate(flush_and_terminate);
+	}
+	return out;
+}
@@ -1,4 +1,6 @@
 #include "parser.hpp"
+#include <charconv>
+#include <climits>
 #include <stdexcept>
 
 #define MIN_PRECEDENCE 0
@@ -9,6 +11,10 @@ std::vector<declaration> Parser::parse() {
 	return parse_declaration_list();
 }
 
+std::size_t Parser::node_count() const {
+	return nodeCount;
+}
+
 std::vector<declaration> Parser::parse_declaration_list() {
 	std::vector<declaration> decl_list;
 	while (!match(TokenType::END)) {
@@ -18,6 +24,10 @@ std::vector<declaration> Parser::parse_declaration_list() {
 }
 
 declaration Parser::parse_declaration() {
+	auto start = offset;
+	if (match("extern")) {
+		return parse_extern_declaration();
+	}
 	bool const_var = false;
 	if (match(TokenType::MOD)) {
 		const_var = true;
@@ -26,8 +36,10 @@ declaration Parser::parse_declaration() {
 	
 	auto type = extract(TokenType::KEYWORD);
 	if (type == "namespace") {
-		return parse_namespace_declaration();
+		return parse_namespace_declaration(start);
 	} else {
+		type += parse_map_arguments(type);
+		type += parse_array_suffix();
 		++offset;
 		if (match("(")) {
 			--offset;
@@ -36,7 +48,10 @@ declaration Parser::parse_declaration() {
 			extract(TokenType::LPAREN);
 			while (!match(")")) {
 				auto param_type = extract(TokenType::KEYWORD);
+				param_type += parse_map_arguments(param_type);
+				param_type += parse_array_suffix();
 				auto param_name = extract(TokenType::IDENTIFIER);
+				param_type += parse_array_suffix();
 				parameters.push_back(std::make_pair(param_type, param_name));
 				if (match(TokenType::COMMA)) {
 					extract(TokenType::COMMA);
@@ -48,9 +63,14 @@ declaration Parser::parse_declaration() {
 				throw std::runtime_error("incorrect declaration function " + name);
 			}
 			auto block_statement = parse_statement();
-			return std::make_shared<Functions_decl>(type, name, parameters, block_statement);		
+			return make_node<Functions_decl>(start, type, name, parameters, block_statement);		
 		} else {
 			--offset;
+			if (tokens[offset + 1] == "[") {
+				if (const_var) throw std::runtime_error("const arrays are not supported");
+				return parse_array_declaration(type, start);
+			}
+			if (const_var && type.starts_with("map<")) throw std::runtime_error("const maps are not supported");
 			std::vector<std::pair<std::string, expression>> vars;
 			while (!match(TokenType::SEMICOLON)) {
 				auto name = extract(TokenType::IDENTIFIER);
@@ -64,13 +84,83 @@ declaration Parser::parse_declaration() {
 				if (match(TokenType::COMMA)) extract(TokenType::COMMA);								
 			}
 			extract(TokenType::SEMICOLON);
-			if (const_var) return std::make_shared<ConstVariable>(type, vars); 
-			else return std::make_shared<Variables_decl>(type, vars);
+			if (const_var) return make_node<ConstVariable>(start, type, vars); 
+			else return make_node<Variables_decl>(start, type, vars);
 		}
 	} 
 }
 
-declaration Parser::parse_namespace_declaration() {
+// extern "C" ["library"] type name(type [name], ...);
+declaration Parser::parse_extern_declaration() {
+	auto start = offset;
+	extract("extern");
+	if (extract(TokenType::STRING) != "C") {
+		throw std::runtime_error("only extern \"C\" functions are supported");
+	}
+	std::string library = match(TokenType::STRING) ? extract(TokenType::STRING) : "";
+	auto type = extract(TokenType::KEYWORD);
+	auto name = extract(TokenType::IDENTIFIER);
+	std::vector<std::pair<std::string, std::string>> parameters;
+	extract(TokenType::LPAREN);
+	while (!match(")")) {
+		if (match("...")) {
+			throw std::runtime_error("variadic extern function " + name + " is not supported");
+		}
+		auto param_type = extract(TokenType::KEYWORD);
+		auto param_name = match(TokenType::IDENTIFIER) ? extract(TokenType::IDENTIFIER) : "";
+		parameters.push_back(std::make_pair(param_type, param_name));
+		if (match(TokenType::COMMA)) {
+			extract(TokenType::COMMA);
+		}
+	}
+	extract(TokenType::RPAREN);
+	extract(TokenType::SEMICOLON);
+	return make_node<Extern_decl>(start, library, type, name, parameters);
+}
+
+declaration Parser::parse_array_declaration(const std::string& type, std::size_t start) {
+	std::vector<std::pair<std::string, expression>> vars;
+	while (true) {
+		auto name = extract(TokenType::IDENTIFIER);
+		extract("[");
+		expression size = match("]") ? nullptr : parse_binary_expression(MIN_PRECEDENCE);
+		extract("]");
+		vars.push_back(std::make_pair(name, size));
+		if (!match(TokenType::COMMA)) break;
+		extract(TokenType::COMMA);
+	}
+	extract(TokenType::SEMICOLON);
+	return make_node<Array_decl>(start, type, vars);
+}
+
+std::string Parser::parse_array_suffix() {
+	if (!match("[")) return "";
+	extract("[");
+	extract("]");
+	return "[]";
+}
+
+// map<key, value> and future<value>, kept in the type name as
+// "map<key,value>" and "future<value>"
+std::string Parser::parse_map_arguments(const std::string& type) {
+	if (type == "future") {
+		extract("<");
+		auto value = extract(TokenType::KEYWORD);
+		value += parse_map_arguments(value);
+		value += parse_array_suffix();
+		extract(">");
+		return "<" + value + ">";
+	}
+	if (type != "map") return "";
+	extract("<");
+	auto key = extract(TokenType::KEYWORD);
+	extract(TokenType::COMMA);
+	auto value = extract(TokenType::KEYWORD);
+	extract(">");
+	return "<" + key + "," + value + ">";
+}
+
+declaration Parser::parse_namespace_declaration(std::size_t start) {
 	auto name = extract(TokenType::IDENTIFIER);
 	extract("{");
 	std::vector<declaration> declarations;
@@ -78,11 +168,19 @@ declaration Parser::parse_namespace_declaration() {
 		declarations.push_back(parse_declaration());
 	}
 	extract(TokenType::RPAREN);
-	return std::make_shared<Namespace_decl>(name, declarations);
+	return make_node<Namespace_decl>(start, name, declarations);
 }
 
 
 statement Parser::parse_statement() {
+	auto line = tokens[offset].line;
+	auto node = parse_statement_body();
+	if (node) node->line = line;
+	return node;
+}
+
+statement Parser::parse_statement_body() {
+	auto start = offset;
 	if (match("{")) {
 		extract(TokenType::LPAREN);
 		std::vector<statement> body;
@@ -91,7 +189,7 @@ statement Parser::parse_statement() {
 			if (match(TokenType::SEMICOLON)) extract(TokenType::SEMICOLON);
 		}
 		extract(TokenType::RPAREN);
-		return std::make_shared<Block_statement>(body);
+		return make_node<Block_statement>(start, body);
 	} else if (match(TokenType::KEYWORD) || match(TokenType::MOD)) {
 		if (match("namespace")) throw std::runtime_error("'namespace' definition is not allowed here");
 		return parse_declaration_statement();
@@ -99,6 +197,8 @@ statement Parser::parse_statement() {
 		return parse_condition_statements();
 	} else if (match(TokenType::LOOP)) {
 		return parse_loop_statement();
+	} else if (match(TokenType::SWITCH)) {
+		return parse_switch_statement();
 	} else if (match(TokenType::JUMP)) {
 		return parse_jump_statement();
 	} else {
@@ -107,19 +207,22 @@ statement Parser::parse_statement() {
 }
 
 statement Parser::parse_declaration_statement() {
-	return std::make_shared<Decl_statement>(parse_declaration());
+	auto start = offset;
+	return make_node<Decl_statement>(start, parse_declaration());
 }
 
 statement Parser::parse_condition_statements() {
+	auto start = offset;
 	std::vector<statement> branches;
 	while(match(TokenType::CONDITION)) {
 		branches.push_back(parse_condition_statement(std::string("")));
 	}
-	return std::make_shared<ConditionalBlock>(branches);
+	return make_node<ConditionalBlock>(start, branches);
 }
 
 
 statement Parser::parse_condition_statement(std::string key) {
+	auto start = offset;
 	auto tmp = extract(TokenType::CONDITION);
 	if (tmp == "if") {
 		extract(TokenType::LPAREN);
@@ -131,23 +234,43 @@ statement Parser::parse_condition_statement(std::string key) {
 		
 		auto body = parse_statement();
 		if (match(TokenType::SEMICOLON)) extract(TokenType::SEMICOLON);
-		return std::make_shared<ConditionalBranches>(key + "if", cond, body);
+		return make_node<ConditionalBranches>(start, key + "if", cond, body);
 	} else if (tmp == "else") {
 		if (key == "else ") throw std::runtime_error("invalid notation of conditional operator");
 		if (match("if")) return parse_condition_statement("else ");
 		auto body = parse_statement();
-		return std::make_shared<ConditionalBranches>("else", nullptr, body);	
+		return make_node<ConditionalBranches>(start, "else", nullptr, body);	
 	} else {
 		throw std::runtime_error("");
 	}
 }
 
 statement Parser::parse_loop_statement() {
-	return extract(TokenType::LOOP) == "for" ? parse_for_statement() : parse_while_statement();
+	auto loop = extract(TokenType::LOOP);
+	if (loop == "parallel") {
+		extract("for");
+		auto node = std::dynamic_pointer_cast<For_statement>(parse_for_statement());
+		if (!node) {
+			throw std::runtime_error("range-based parallel for is not supported");
+		}
+		node->parallel = true;
+		return node;
+	}
+	return loop == "for" ? parse_for_statement() : parse_while_statement();
 }
 
 statement Parser::parse_for_statement() {
+	auto start = offset;
 	extract("(");
+	if (match(TokenType::KEYWORD) && tokens[offset + 1] == TokenType::IDENTIFIER && tokens[offset + 2] == ":") {
+		auto type = extract(TokenType::KEYWORD);
+		auto name = extract(TokenType::IDENTIFIER);
+		extract(":");
+		auto range = parse_binary_expression(MIN_PRECEDENCE);
+		extract(")");
+		auto body = parse_statement();
+		return make_node<ForEach_statement>(start, type, name, range, body);
+	}
 	auto var = parse_statement();
 	if (match(TokenType::SEMICOLON)) extract(TokenType::SEMICOLON);
 	auto cond = parse_statement();
@@ -155,35 +278,91 @@ statement Parser::parse_for_statement() {
 	auto Expr = parse_statement();
 	extract(")");
 	auto body = parse_statement();
-	return std::make_shared<For_statement>(var, cond, Expr, body);
+	return make_node<For_statement>(start, var, cond, Expr, body);
 }
 
 statement Parser::parse_while_statement() {
+	auto start = offset;
 	extract("(");
 	auto cond = parse_statement();
 	extract(")");
 	auto body = parse_statement();
-	return std::make_shared<While_statement>(cond, body);
+	return make_node<While_statement>(start, cond, body);
+}
+
+// The statements of all cases go into one list, in which each label keeps
+// the index its case starts at.
+statement Parser::parse_switch_statement() {
+	auto start = offset;
+	auto key = extract(TokenType::SWITCH);
+	if (key != "switch") throw std::runtime_error("'" + key + "' not within a switch statement");
+	extract("(");
+	auto value = parse_binary_expression(MIN_PRECEDENCE);
+	extract(")");
+	extract("{");
+	std::vector<statement> body;
+	std::vector<std::pair<int, std::size_t>> cases;
+	std::vector<int> chars;
+	std::size_t fallback = 0;
+	bool defaulted = false;
+	while (!match("}")) {
+		if (match("case")) {
+			extract("case");
+			bool negative = match("-");
+			if (negative) extract("-");
+			long long label;
+			if (match(TokenType::INT)) {
+				auto digits = extract(TokenType::INT);
+				// read wider than int, since -2147483648 is in range and its digits are not
+				bool fits = std::from_chars(digits.data(), digits.data() + digits.size(), label).ec == std::errc();
+				if (negative) label = -label;
+				if (!fits || label < INT_MIN || label > INT_MAX) {
+					throw std::runtime_error("case label " + std::string(negative ? "-" : "") + digits + " is out of range for int");
+				}
+			} else if (!negative && match(TokenType::CHAR)) {
+				label = extract(TokenType::CHAR)[0];
+				chars.push_back(label);
+			} else {
+				throw std::runtime_error("case label is not an int or char constant");
+			}
+			extract(":");
+			cases.push_back(std::make_pair(static_cast<int>(label), body.size()));
+		} else if (match("default")) {
+			extract("default");
+			extract(":");
+			if (defaulted) throw std::runtime_error("multiple default labels in one switch");
+			defaulted = true;
+			fallback = body.size();
+		} else {
+			body.push_back(parse_statement());
+			if (match(TokenType::SEMICOLON)) extract(TokenType::SEMICOLON);
+		}
+	}
+	extract(TokenType::RPAREN);
+	return make_node<Switch_statement>(start, value, body, cases, chars, defaulted ? fallback : body.size());
 }
 
 statement Parser::parse_jump_statement() {
+	auto start = offset;
 	auto jump = extract(TokenType::JUMP);
 	if (jump == "break")
-		return std::make_shared<Break_statement>();
+		return make_node<Break_statement>(start);
 	else if (jump == "continue")
-		return std::make_shared<Continue_statement>();
+		return make_node<Continue_statement>(start);
 	else
-		return std::make_shared<Return_statement>(parse_binary_expression(MIN_PRECEDENCE));
+		return make_node<Return_statement>(start, parse_binary_expression(MIN_PRECEDENCE));
 }
 
 statement Parser::parse_expression_statement() {
-	return std::make_shared<Expression_statement>(parse_binary_expression(MIN_PRECEDENCE));
+	auto start = offset;
+	return make_node<Expression_statement>(start, parse_binary_expression(MIN_PRECEDENCE));
 }
 
 expression Parser::parse_binary_expression(int min_precedence) {
+	auto start = offset;
 	auto lhs = parse_base_expression();
 	if (match("++") || match("--")) {
-		lhs = std::make_shared<PostfixNode>(extract(TokenType::OPERATOR), lhs);
+		lhs = make_node<PostfixNode>(start, extract(TokenType::OPERATOR), lhs);
 	}
 
 	auto op = tokens[offset].value;
@@ -193,7 +372,7 @@ expression Parser::parse_binary_expression(int min_precedence) {
 		}
 		++offset;
 		auto rhs = parse_binary_expression(operators.at(op));
-		lhs = std::make_shared<BinaryNode>(op, lhs, rhs);
+		lhs = make_node<BinaryNode>(start, op, lhs, rhs);
 		if (tokens[offset] == "?") {
 			op = tokens[offset].value;
 			break;
@@ -205,24 +384,39 @@ expression Parser::parse_binary_expression(int min_precedence) {
 		auto true_expr = parse_binary_expression(MIN_PRECEDENCE);
 		extract(":");
 		auto false_expr = parse_binary_expression(MIN_PRECEDENCE);
-		lhs = std::make_shared<TernaryNode>(lhs, true_expr, false_expr);
+		lhs = make_node<TernaryNode>(start, lhs, true_expr, false_expr);
 	}
 
 	return lhs;
 }
 
 expression Parser::parse_base_expression() {
+	auto start = offset;
 	if (match(TokenType::CHAR) || match(TokenType::BOOL) || match(TokenType::DOUBLE) || match(TokenType::INT) || match(TokenType::STRING)) {
 		return parse_literal();
 	} else if (match(TokenType::IDENTIFIER)) {
-		if (auto identifier = extract(TokenType::IDENTIFIER); match(TokenType::LPAREN)) {
-			return std::make_shared<FunctionNode>(identifier, parse_function_expression());
+		expression node;
+		if (auto identifier = extract(TokenType::IDENTIFIER); match("(")) {
+			node = make_node<FunctionNode>(start, identifier, parse_function_expression());
 		} else {
-			return std::make_shared<IdentifierNode>(identifier);
+			node = make_node<IdentifierNode>(start, identifier);
+		}
+		while (match("[")) {
+			extract("[");
+			auto index = parse_binary_expression(MIN_PRECEDENCE);
+			extract("]");
+			node = make_node<IndexNode>(start, node, index);
 		}
+		return node;
+	} else if (match("spawn") || match("await")) {
+		// binds like a prefix operator, but takes a qualified name whole
+		auto op = extract(TokenType::OPERATOR);
+		auto operand = parse_binary_expression(operators.at("::"));
+		if (op == "spawn") return make_node<SpawnNode>(start, operand);
+		return make_node<AwaitNode>(start, operand);
 	} else if (unary.contains(tokens[offset].value)) {
 		std::string op = extract(TokenType::OPERATOR);
-		return std::make_shared<PrefixNode>(op, parse_base_expression());
+		return make_node<PrefixNode>(start, op, parse_base_expression());
 	} else if (match(TokenType::LPAREN)) {
 		return parse_parenthesized_expression();
 	} else if (match(TokenType::SEMICOLON)) {
@@ -236,21 +430,22 @@ expression Parser::parse_base_expression() {
 }
 
 expression Parser::parse_literal() {
+	auto start = offset;
 	auto literal = tokens[offset++];
 	switch (literal.type) {
 		case TokenType::CHAR:
-			return std::make_shared<CharNode>(literal.value[0]);
+			return make_node<CharNode>(start, literal.value[0]);
 		case TokenType::DOUBLE:
-			return std::make_shared<DoubleNode>(std::stod(literal.value));
+			return make_node<DoubleNode>(start, std::stod(literal.value));
 		case TokenType::INT:
-			return std::make_shared<IntNode>(std::stoi(literal.value));
+			return make_node<IntNode>(start, std::stoi(literal.value));
 		case TokenType::BOOL:
 			if (literal.value == "true")
-				return std::make_shared<BoolNode>(true);
+				return make_node<BoolNode>(start, true);
 			else
-				return std::make_shared<BoolNode>(false);
+				return make_node<BoolNode>(start, false);
 		case TokenType::STRING:
-			return std::make_shared<StringNode>(literal.value);
+			return make_node<StringNode>(start, literal.value);
 		default:
 			return nullptr;
 	}
@@ -274,10 +469,11 @@ std::vector<expression> Parser::parse_function_expression() {
 }
 
 expression Parser::parse_parenthesized_expression() {
+	auto start = offset;
 	extract(TokenType::LPAREN);
 	auto node = parse_binary_expression(MIN_PRECEDENCE);
 	extract(TokenType::RPAREN);
-	return std::make_shared<ParenthesizedNode>(node);	
+	return make_node<ParenthesizedNode>(start, node);	
 }
 
 //////////////////////////////////////////////////////////////
@@ -0,0 +1,200 @@
+#include "pool.hpp"
+
+#include <algorithm>
+
+#include "parallel.hpp"
+
+namespace {
+	// set on pool threads, and on a caller while it runs a job
+	thread_local bool inside = false;
+}
+
+ThreadPool::ThreadPool(std::size_t threads) {
+	threads = std::max<std::size_t>(1, threads);
+	for (std::size_t i = 0; i < threads; i++) {
+		queues.push_back(std::make_unique<Queue>());
+	}
+	for (std::size_t i = 1; i < threads; i++) {
+		this->threads.emplace_back([this, i] { loop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+void ThreadPool::run(std::size_t tasks, const std::function<void(std::size_t, std::size_t)>& task) {
+	if (tasks == 0) return;
+	if (inside || queues.size() == 1 || tasks == 1 || !busy.try_lock()) {
+		for (std::size_t i = 0; i < tasks; i++) {
+			task(i, 0);
+		}
+		return;
+	}
+	// the job is in place before any of its tasks can be taken, so a thread
+	// still looking for work of the previous job runs these correctly
+	{
+		std::lock_guard lock(mutex);
+		job = &task;
+		error = nullptr;
+		cancelled = false;
+		remaining = tasks;
+		generation++;
+	}
+	// neighbouring tasks start out on the same thread
+	for (std::size_t i = 0; i < queues.size(); i++) {
+		auto& queue = *queues[i];
+		std::lock_guard lock(queue.mutex);
+		for (std::size_t t = tasks * i / queues.size(); t < tasks * (i + 1) / queues.size(); t++) {
+			queue.tasks.push_back(t);
+		}
+	}
+	wake.notify_all();
+
+	inside = true;
+	work(0);
+	inside = false;
+
+	// threads busy with submitted tasks are not waited for, only the
+	// tasks of this job that others took
+	std::exception_ptr failure;
+	{
+		std::unique_lock lock(mutex);
+		finished.wait(lock, [this] { return remaining == 0; });
+		job = nullptr;
+		failure = error;
+	}
+	busy.unlock();
+	if (failure) std::rethrow_exception(failure);
+}
+
+bool ThreadPool::take(std::size_t thread, std::size_t& task) {
+	for (std::size_t k = 0; k < queues.size(); k++) {
+		auto& queue = *queues[(thread + k) % queues.size()];
+		std::lock_guard lock(queue.mutex);
+		if (queue.tasks.empty()) continue;
+		if (k == 0) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		} else {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::work(std::size_t thread) {
+	std::size_t task;
+	while (take(thread, task)) {
+		const std::function<void(std::size_t, std::size_t)>* current;
+		{
+			std::lock_guard lock(mutex);
+			current = cancelled ? nullptr : job;
+		}
+		if (current) {
+			try {
+				(*current)(task, thread);
+			} catch (...) {
+				std::lock_guard lock(mutex);
+				if (!error) error = std::current_exception();
+				cancelled = true;
+			}
+		}
+		std::lock_guard lock(mutex);
+		if (--remaining == 0) finished.notify_all();
+	}
+}
+
+void ThreadPool::loop(std::size_t thread) {
+	inside = true;
+	std::size_t seen = 0;
+	while (true) {
+		Submitted task;
+		{
+			std::unique_lock lock(mutex);
+			wake.wait(lock, [this, &seen] { return stopping || generation != seen || !submitted.empty(); });
+			if (stopping) return;
+			if (generation != seen) {
+				seen = generation;
+			} else {
+				task = std::move(submitted.front());
+				submitted.pop_front();
+			}
+		}
+		if (task.task) {
+			task.task();
+			finish(task.group.get());
+		} else {
+			work(thread);
+		}
+	}
+}
+
+void ThreadPool::submit(std::function<void()> task, const std::shared_ptr<TaskGroup>& group) {
+	{
+		std::lock_guard lock(mutex);
+		submitted.push_back(Submitted{std::move(task), group});
+		outstanding++;
+		if (group) group->outstanding++;
+	}
+	wake.notify_one();
+	idle.notify_all();
+}
+
+bool ThreadPool::run_one(const TaskGroup* group) {
+	Submitted task;
+	{
+		std::lock_guard lock(mutex);
+		auto it = submitted.rbegin();
+		while (group && it != submitted.rend() && it->group.get() != group) ++it;
+		if (it == submitted.rend()) return false;
+		task = std::move(*it);
+		submitted.erase(std::next(it).base());
+	}
+	task.task();
+	finish(task.group.get());
+	return true;
+}
+
+void ThreadPool::wait() {
+	while (true) {
+		while (run_one());
+		std::unique_lock lock(mutex);
+		idle.wait(lock, [this] { return outstanding == 0 || !submitted.empty(); });
+		if (outstanding == 0) return;
+	}
+}
+
+// tasks of the group taken by pool threads are waited for, not run here
+void ThreadPool::wait(const TaskGroup& group) {
+	while (true) {
+		while (run_one(&group));
+		std::unique_lock lock(mutex);
+		auto queued = [this, &group] {
+			return std::any_of(submitted.begin(), submitted.end(), [&group](const Submitted& s) { return s.group.get() == &group; });
+		};
+		idle.wait(lock, [&] { return group.outstanding == 0 || queued(); });
+		if (group.outstanding == 0) return;
+	}
+}
+
+void ThreadPool::finish(TaskGroup* group) {
+	std::lock_guard lock(mutex);
+	bool done = --outstanding == 0;
+	if (group && --group->outstanding == 0) done = true;
+	if (done) idle.notify_all();
+}
+
+ThreadPool& ThreadPool::shared() {
+	static ThreadPool pool(parallel_threads ? parallel_threads : std::thread::hardware_concurrency());
+	return pool;
+}
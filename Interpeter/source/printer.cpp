@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include "visitor.hpp"
 
@@ -20,8 +21,11 @@ void Printer::visit(Namespace_decl& root) {
 void Printer::visit(Variables_decl& root) {
 	std::cout << root.type << " ";
 	for (auto& var : root.vars) {
-		std::cout << var.first + " = ";
-		var.second->accept(*this);	
+		std::cout << var.first;
+		if (var.second) {
+			std::cout << " = ";
+			var.second->accept(*this);
+		}
 	}
 	std::cout << ";\n";
 }
@@ -31,6 +35,20 @@ void Printer::visit(ConstVariable& root) {
 	root.Variables_decl::accept(*this);
 }
 
+void Printer::visit(Array_decl& root) {
+	std::cout << root.type << " ";
+	for (auto it = root.vars.begin(); it != root.vars.end();) {
+		std::cout << it->first + "[";
+		if (it->second) it->second->accept(*this);
+		std::cout << "]";
+		it++;
+		if (it != root.vars.end()) {
+			std::cout << ", ";
+		}
+	}
+	std::cout << ";\n";
+}
+
 void Printer::visit(Functions_decl& root) {
 	std::cout << root.type + " " + root.name + "(";
 	for (auto it = root.parameters.begin(); it != root.parameters.end();) {
@@ -44,6 +62,21 @@ void Printer::visit(Functions_decl& root) {
 	root.block_statement->accept(*this);
 }
 
+void Printer::visit(Extern_decl& root) {
+	std::cout << "extern \"C\" ";
+	if (!root.library.empty()) std::cout << "\"" + root.library + "\" ";
+	std::cout << root.type + " " + root.name + "(";
+	for (auto it = root.parameters.begin(); it != root.parameters.end();) {
+		std::cout << it->first;
+		if (!it->second.empty()) std::cout << " " + it->second;
+		it++;
+		if (it != root.parameters.end()) {
+			std::cout << ", ";
+		}
+	}
+	std::cout << ");\n";
+}
+
 void Printer::visit(Expression_statement& root) {
 	root.expr->accept(*this);
 }
@@ -70,7 +103,7 @@ void Printer::visit(While_statement& root) {
 }
 
 void Printer::visit(For_statement& root) {
-	std::cout << "for(";
+	std::cout << (root.parallel ? "parallel for(" : "for(");
 	root.var->accept(*this);
 	root.cond->accept(*this);
 	std::cout << "; ";
@@ -80,6 +113,33 @@ void Printer::visit(For_statement& root) {
 	std::cout << "\n";
 }
 
+void Printer::visit(ForEach_statement& root) {
+	std::cout << "for(" + root.type + " " + root.name + " : ";
+	root.range->accept(*this);
+	std::cout << ") ";
+	root.body->accept(*this);
+	std::cout << "\n";
+}
+
+void Printer::visit(Switch_statement& root) {
+	std::cout << "switch(";
+	root.value->accept(*this);
+	std::cout << ") {\n";
+	for (std::size_t i = 0; i <= root.body.size(); i++) {
+		for (auto& [label, start] : root.cases) {
+			if (start != i) continue;
+			if (std::find(root.chars.begin(), root.chars.end(), label) != root.chars.end()) std::cout << "case '" << static_cast<char>(label) << "':\n";
+			else std::cout << "case " << label << ":\n";
+		}
+		if (root.fallback == i && i < root.body.size()) std::cout << "default:\n";
+		if (i < root.body.size()) {
+			root.body[i]->accept(*this);
+			std::cout << std::endl;
+		}
+	}
+	std::cout << "}\n";
+}
+
 void Printer::visit(ConditionalBlock& root) {
 	for (auto& branch : root.branches) {
 		branch->accept(*this);
@@ -136,6 +196,16 @@ void Printer::visit(PostfixNode& root) {
 	std::cout << root.op;
 }
 
+void Printer::visit(SpawnNode& root) {
+	std::cout << "spawn ";
+	root.call->accept(*this);
+}
+
+void Printer::visit(AwaitNode& root) {
+	std::cout << "await ";
+	root.handle->accept(*this);
+}
+
 void Printer::visit(FunctionNode& root) {
 	std::cout << root.name + "(";
 	for (auto it = root.branches.begin(); it != root.branches.end();) {
@@ -148,10 +218,21 @@ void Printer::visit(FunctionNode& root) {
 	std::cout << ")";
 }
 
+void Printer::visit(IndexNode& root) {
+	root.branch->accept(*this);
+	std::cout << "[";
+	root.index->accept(*this);
+	std::cout << "]";
+}
+
 void Printer::visit(IdentifierNode& root) {
 	std::cout << root.name;
 }
 
+void Printer::visit(HoistedNode& root) {
+	root.expr->accept(*this);
+}
+
 void Printer::visit(ParenthesizedNode& root) {
 	std::cout << "(";
 	root.expr->accept(*this);
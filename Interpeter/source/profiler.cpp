@@ -0,0 +1,128 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <sys/time.h>
+
+Profiler* Profiler::active = nullptr;
+
+Profiler::Profiler(std::size_t frequency) : frequency(frequency ? frequency : 1) {}
+
+Profiler::~Profiler() {
+	if (active == this) stop();
+}
+
+void Profiler::start() {
+	if (active) {
+		throw std::runtime_error("profiler is already running");
+	}
+	// allocated here, so that a profiler that never runs costs nothing
+	if (buffer.empty()) buffer.resize(BUFFER_FRAMES);
+	active = this;
+
+	struct sigaction action = {};
+	action.sa_handler = &Profiler::handler;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGPROF, &action, nullptr);
+
+	itimerval timer = {};
+	timer.it_interval.tv_usec = 1000000 / frequency;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void Profiler::stop() {
+	if (active != this) return;
+	itimerval timer = {};
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	signal(SIGPROF, SIG_IGN);
+	active = nullptr;
+	aggregate();
+}
+
+void Profiler::handler(int) {
+	if (active) active->sample();
+}
+
+void Profiler::sample() {
+	std::atomic_signal_fence(std::memory_order_acquire);
+	std::size_t n = depth;
+	if (n > MAX_DEPTH) n = MAX_DEPTH;
+	if (used + n + 1 > buffer.size()) {
+		dropped = dropped + 1;
+		return;
+	}
+	std::size_t pos = used;
+	buffer[pos++] = Frame{nullptr, n};
+	for (std::size_t i = 0; i < n; i++) {
+		buffer[pos++] = stack[i];
+	}
+	used = pos;
+}
+
+// Frame names point into the running program, so samples are resolved
+// into strings while it is still alive.
+void Profiler::aggregate() {
+	static const std::string global = "[global]";
+	for (std::size_t pos = 0; pos < used;) {
+		std::size_t n = buffer[pos++].line;
+		std::string key, leaf = global, leafLine = global;
+		std::set<std::string> seen;
+		if (!n) {
+			key = global;
+			seen.insert(global);
+		}
+		for (std::size_t i = 0; i < n; i++, pos++) {
+			auto& frame = buffer[pos];
+			leaf = frame.name ? *frame.name : global;
+			leafLine = leaf + ":" + std::to_string(frame.line);
+			if (i) key += ";";
+			key += leafLine;
+			seen.insert(leaf);
+		}
+		folded[key]++;
+		selfFunctions[leaf]++;
+		selfLines[leafLine]++;
+		for (auto& name : seen) {
+			totalFunctions[name]++;
+		}
+		total++;
+	}
+	used = 0;
+}
+
+void Profiler::write_folded(std::ostream& out) const {
+	for (auto& [stack, count] : folded) {
+		out << stack << " " << count << "\n";
+	}
+}
+
+static void write_top(std::ostream& out, const char* title, const std::map<std::string, std::size_t>& table, std::size_t top, std::size_t total) {
+	std::vector<std::pair<std::size_t, std::string>> rows;
+	for (auto& [name, count] : table) {
+		rows.push_back(std::make_pair(count, name));
+	}
+	std::sort(rows.begin(), rows.end(), [](auto& a, auto& b) { return a.first > b.first; });
+	if (rows.size() > top) rows.resize(top);
+
+	out << title << "\n";
+	char line[256];
+	for (auto& [count, name] : rows) {
+		std::snprintf(line, sizeof(line), "%10zu %6.2f%%  %s\n", count, 100.0 * count / total, name.c_str());
+		out << line;
+	}
+}
+
+void Profiler::write_summary(std::ostream& out, std::size_t top) const {
+	out << "profile: " << total << " samples";
+	if (dropped) out << ", " << dropped << " dropped";
+	out << "\n";
+	if (!total) return;
+	write_top(out, "self (function):", selfFunctions, top, total);
+	write_top(out, "total (function):", totalFunctions, top, total);
+	write_top(out, "self (line):", selfLines, top, total);
+}
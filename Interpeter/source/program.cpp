@@ -0,0 +1,108 @@
+#include "program.hpp"
+
+#include "batch.hpp"
+#include "pool.hpp"
+
+namespace {
+	std::shared_ptr<Rvalue> copy_value(const std::shared_ptr<Rvalue>& value) {
+		if (auto v = std::dynamic_pointer_cast<IntValue>(value); v) return std::make_shared<IntValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<DoubleValue>(value); v) return std::make_shared<DoubleValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<CharValue>(value); v) return std::make_shared<CharValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<BoolValue>(value); v) return std::make_shared<BoolValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<StringValue>(value); v) return std::make_shared<StringValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<ArrayValue>(value); v) return std::make_shared<ArrayValue>(*v);
+		if (auto v = std::dynamic_pointer_cast<MapValue>(value); v) return std::make_shared<MapValue>(*v);
+		// futures share their task, like after "="
+		if (auto v = std::dynamic_pointer_cast<FutureValue>(value); v) return std::make_shared<FutureValue>(*v);
+		return value;
+	}
+
+	// constants are never written and C functions refer to no scope, so only
+	// they are shared with the program
+	std::shared_ptr<Scope> copy_scope(const Scope& scope, const std::shared_ptr<Scope>& parent) {
+		auto copy = std::make_shared<Scope>(parent);
+		for (auto& [name, symbol] : scope.table) {
+			if (auto space = std::dynamic_pointer_cast<Namespace>(symbol); space) {
+				auto inner = copy_scope(*space->scope, copy);
+				copy->table[name] = std::make_shared<Namespace>(inner);
+			} else if (std::dynamic_pointer_cast<NativeFunction>(symbol)) {
+				copy->table[name] = symbol;
+			} else if (auto func = std::dynamic_pointer_cast<Function>(symbol); func) {
+				auto function = std::make_shared<Function>(*func);
+				function->scope = copy;
+				copy->table[name] = function;
+			} else if (std::dynamic_pointer_cast<ConstVar>(symbol)) {
+				copy->table[name] = symbol;
+			} else if (auto var = std::dynamic_pointer_cast<Variable>(symbol); var) {
+				auto lvalue = std::dynamic_pointer_cast<Lvalue>(var->value);
+				copy->table[name] = std::make_shared<Variable>(var->type, std::make_shared<Lvalue>(copy_value(lvalue->value)));
+			}
+		}
+		return copy;
+	}
+
+	// a namespace scope and the scope it is declared in refer to each other
+	void release(Scope& scope) {
+		for (auto& [name, symbol] : scope.table) {
+			if (auto space = std::dynamic_pointer_cast<Namespace>(symbol); space) release(*space->scope);
+		}
+		scope.table.clear();
+	}
+}
+
+Program::Program(const std::vector<declaration>& nodes, const std::shared_ptr<Budget>& budget) : nodes(nodes) {
+	Executor executor;
+	executor.limit(budget);
+	executor.execute(this->nodes);
+	global = executor.globals();
+}
+
+Program::~Program() {
+	release(*global);
+}
+
+ExecutionContext::ExecutionContext(const Program& program, Profiler* profiler) : executor(copy_scope(*program.global, nullptr), profiler) {}
+
+ExecutionContext::~ExecutionContext() {
+	release(*executor.globals());
+}
+
+void ExecutionContext::run() {
+	auto& table = executor.globals()->table;
+	auto main = table.find("main");
+	if (main == table.end()) return;
+	if (auto func = std::dynamic_pointer_cast<Function>(main->second); func) {
+		call(func, {});
+	}
+}
+
+std::shared_ptr<Function> ExecutionContext::function(const std::string& name) {
+	return executor.function(name);
+}
+
+// a context stays usable after a call failed
+symbol ExecutionContext::call(const std::shared_ptr<Function>& func, const std::vector<symbol>& args) {
+	try {
+		return executor.call(func, args);
+	} catch (...) {
+		executor.reset();
+		throw;
+	}
+}
+
+std::vector<double> ExecutionContext::batch(const std::shared_ptr<Function>& func, const std::vector<std::vector<double>>& columns) {
+	try {
+		return Batch(executor, func).run(columns);
+	} catch (...) {
+		executor.reset();
+		throw;
+	}
+}
+
+void ExecutionContext::limit(const std::shared_ptr<Budget>& budget) {
+	executor.limit(budget);
+}
+
+void ExecutionContext::wait() {
+	ThreadPool::shared().wait(*executor.spawned());
+}
@@ -0,0 +1,378 @@
+#include "pruner.hpp"
+
+namespace {
+	// A::B::x as "A::B::x", with last set to the x or the call at its end
+	std::string qualified(const expression& node, expression& last) {
+		auto binary = std::dynamic_pointer_cast<BinaryNode>(node);
+		if (!binary || binary->op != "::") {
+			last = node;
+			if (auto name = std::dynamic_pointer_cast<IdentifierNode>(node); name) return name->name;
+			if (auto call = std::dynamic_pointer_cast<FunctionNode>(node); call) return call->name;
+			return "";
+		}
+		auto space = std::dynamic_pointer_cast<IdentifierNode>(binary->left_branch);
+		auto rest = space ? qualified(binary->right_branch, last) : "";
+		return rest.empty() ? "" : space->name + "::" + rest;
+	}
+
+	// an initializer that cannot have effects, so its global may go unused
+	bool trivial(const expression& node) {
+		if (!node || std::dynamic_pointer_cast<Literal>(node)) return true;
+		auto prefix = std::dynamic_pointer_cast<PrefixNode>(node);
+		return prefix && prefix->op == "-" && std::dynamic_pointer_cast<Literal>(prefix->branch);
+	}
+
+	bool jump(const statement& node) {
+		return std::dynamic_pointer_cast<Jump_statement>(node) != nullptr;
+	}
+
+	statement empty(std::size_t line) {
+		statement block = std::make_shared<Block_statement>(std::vector<statement>());
+		block->line = line;
+		return block;
+	}
+
+	// "A::B::" followed by "A::", then ""
+	bool outer(std::string& space) {
+		if (space.empty()) return false;
+		auto end = space.rfind("::", space.size() - 3);
+		space.erase(end == std::string::npos ? 0 : end + 2);
+		return true;
+	}
+}
+
+Pruner::Pruner(Stats* stats) : stats(stats) {}
+
+void Pruner::prune(std::vector<declaration>& nodes, const std::string& entry) {
+	index(nodes, "");
+	simplify(nodes, "");
+	if (names.contains(entry) && used.insert(entry).second) pending.push_back(entry);
+	while (!pending.empty()) {
+		auto name = pending.back();
+		pending.pop_back();
+		for (auto& [decl, space] : names[name]) {
+			if (auto func = std::dynamic_pointer_cast<Functions_decl>(decl); func) {
+				mark(func->block_statement, space);
+			} else if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl); vars) {
+				for (auto& var : vars->vars) {
+					if (space + var.first == name) mark(var.second, space);
+				}
+			} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl); array) {
+				for (auto& var : array->vars) {
+					if (space + var.first == name) mark(var.second, space);
+				}
+			}
+		}
+	}
+	sweep(nodes, "");
+}
+
+// globals with an initializer that may have effects are reached from the start
+void Pruner::index(const std::vector<declaration>& nodes, const std::string& space) {
+	for (auto& decl : nodes) {
+		if (auto inner = std::dynamic_pointer_cast<Namespace_decl>(decl); inner) {
+			index(inner->declarations, space + inner->name + "::");
+		} else if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl); vars) {
+			for (auto& var : vars->vars) {
+				names[space + var.first].push_back({decl, space});
+				if (!trivial(var.second) && used.insert(space + var.first).second) pending.push_back(space + var.first);
+			}
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl); array) {
+			for (auto& var : array->vars) {
+				names[space + var.first].push_back({decl, space});
+				if (!trivial(var.second) && used.insert(space + var.first).second) pending.push_back(space + var.first);
+			}
+		} else if (auto func = std::dynamic_pointer_cast<Functions_decl>(decl); func) {
+			names[space + func->name].push_back({decl, space});
+		} else if (auto external = std::dynamic_pointer_cast<Extern_decl>(decl); external) {
+			names[space + external->name].push_back({decl, space});
+		}
+	}
+}
+
+void Pruner::simplify(std::vector<declaration>& nodes, const std::string& space) {
+	for (auto& decl : nodes) {
+		if (auto inner = std::dynamic_pointer_cast<Namespace_decl>(decl); inner) {
+			simplify(inner->declarations, space + inner->name + "::");
+		} else if (auto func = std::dynamic_pointer_cast<Functions_decl>(decl); func) {
+			this->space = space;
+			locals.clear();
+			for (auto& param : func->parameters) locals.insert(param.second);
+			declared(func->block_statement);
+			func->block_statement = simplify(func->block_statement);
+		}
+	}
+}
+
+// null when nothing of node is left
+statement Pruner::simplify(const statement& node) {
+	if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		std::vector<statement> body;
+		for (std::size_t i = 0; i < block->body.size(); i++) {
+			auto state = simplify(block->body[i]);
+			if (!state) continue;
+			body.push_back(state);
+			if (jump(state) && i + 1 < block->body.size()) {
+				auto rest = block->body.size() - i - 1;
+				removed(block->body[i + 1]->line, std::to_string(rest) + (rest == 1 ? " statement" : " statements") + " after a jump");
+				stmtCount += rest;
+				break;
+			}
+		}
+		block->body = std::move(body);
+	} else if (auto cond = std::dynamic_pointer_cast<ConditionalBlock>(node); cond) {
+		std::vector<statement> branches;
+		for (std::size_t i = 0; i < cond->branches.size(); i++) {
+			auto branch = std::static_pointer_cast<ConditionalBranches>(cond->branches[i]);
+			bool value;
+			if (branch->key != "else" && constant(branch->cond, value)) {
+				if (!value) {
+					removed(branch->line, branch->key + " never taken");
+					stmtCount++;
+					continue;
+				}
+				// always taken, so the branches after it never are
+				branch->key = "else";
+				branch->cond = nullptr;
+				if (i + 1 < cond->branches.size()) {
+					removed(cond->branches[i + 1]->line, "branches after one always taken");
+					stmtCount += cond->branches.size() - i - 1;
+				}
+				branch->body = simplify(branch->body);
+				if (!branch->body) branch->body = empty(branch->line);
+				branches.push_back(branch);
+				break;
+			}
+			branch->body = simplify(branch->body);
+			if (!branch->body) branch->body = empty(branch->line);
+			branches.push_back(branch);
+		}
+		if (branches.empty()) return nullptr;
+		auto first = std::static_pointer_cast<ConditionalBranches>(branches[0]);
+		if (first->key == "else") {
+			if (std::dynamic_pointer_cast<Block_statement>(first->body)) return first->body;
+			statement block = std::make_shared<Block_statement>(std::vector<statement>{first->body});
+			block->line = first->line;
+			return block;
+		}
+		first->key = "if";
+		cond->branches = std::move(branches);
+	} else if (auto loop = std::dynamic_pointer_cast<While_statement>(node); loop) {
+		bool value;
+		if (constant(loop->cond, value) && !value) {
+			removed(loop->line, "while never entered");
+			stmtCount++;
+			return nullptr;
+		}
+		loop->body = simplify(loop->body);
+		if (!loop->body) loop->body = empty(loop->line);
+	} else if (auto loop = std::dynamic_pointer_cast<For_statement>(node); loop) {
+		loop->body = simplify(loop->body);
+		if (!loop->body) loop->body = empty(loop->line);
+	} else if (auto loop = std::dynamic_pointer_cast<ForEach_statement>(node); loop) {
+		loop->body = simplify(loop->body);
+		if (!loop->body) loop->body = empty(loop->line);
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		// cases refer to statements by index, so none may go away
+		for (auto& state : cases->body) {
+			auto line = state->line;
+			state = simplify(state);
+			if (!state) state = empty(line);
+		}
+	}
+	return node;
+}
+
+// every declaration name could refer to from space
+void Pruner::reach(const std::string& name, const std::string& space) {
+	auto scope = space;
+	do {
+		if (names.contains(scope + name) && used.insert(scope + name).second) pending.push_back(scope + name);
+	} while (outer(scope));
+}
+
+void Pruner::mark(const statement& node, const std::string& space) {
+	if (auto expr = std::dynamic_pointer_cast<Expression_statement>(node); expr) {
+		mark(expr->expr, space);
+	} else if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		for (auto& state : block->body) mark(state, space);
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) mark(var.second, space);
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) mark(var.second, space);
+		}
+	} else if (auto loop = std::dynamic_pointer_cast<While_statement>(node); loop) {
+		mark(loop->cond, space);
+		mark(loop->body, space);
+	} else if (auto loop = std::dynamic_pointer_cast<For_statement>(node); loop) {
+		if (loop->var) mark(loop->var, space);
+		mark(loop->cond, space);
+		mark(loop->Expr, space);
+		mark(loop->body, space);
+	} else if (auto loop = std::dynamic_pointer_cast<ForEach_statement>(node); loop) {
+		mark(loop->range, space);
+		mark(loop->body, space);
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		mark(cases->value, space);
+		for (auto& state : cases->body) mark(state, space);
+	} else if (auto cond = std::dynamic_pointer_cast<ConditionalBlock>(node); cond) {
+		for (auto& branch : cond->branches) mark(branch, space);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		if (branch->cond) mark(branch->cond, space);
+		mark(branch->body, space);
+	} else if (auto ret = std::dynamic_pointer_cast<Return_statement>(node); ret) {
+		mark(ret->expr, space);
+	}
+}
+
+void Pruner::mark(const expression& node, const std::string& space) {
+	if (!node) return;
+	if (auto binary = std::dynamic_pointer_cast<BinaryNode>(node); binary) {
+		if (binary->op == "::") {
+			expression last;
+			auto name = qualified(node, last);
+			if (!name.empty()) reach(name, space);
+			if (auto call = std::dynamic_pointer_cast<FunctionNode>(last); call) {
+				for (auto& arg : call->branches) mark(arg, space);
+			}
+			return;
+		}
+		mark(binary->left_branch, space);
+		mark(binary->right_branch, space);
+	} else if (auto name = std::dynamic_pointer_cast<IdentifierNode>(node); name) {
+		reach(name->name, space);
+	} else if (auto call = std::dynamic_pointer_cast<FunctionNode>(node); call) {
+		reach(call->name, space);
+		for (auto& arg : call->branches) mark(arg, space);
+	} else if (auto ternary = std::dynamic_pointer_cast<TernaryNode>(node); ternary) {
+		mark(ternary->cond, space);
+		mark(ternary->true_expression, space);
+		mark(ternary->false_expression, space);
+	} else if (auto prefix = std::dynamic_pointer_cast<PrefixNode>(node); prefix) {
+		mark(prefix->branch, space);
+	} else if (auto postfix = std::dynamic_pointer_cast<PostfixNode>(node); postfix) {
+		mark(postfix->branch, space);
+	} else if (auto spawn = std::dynamic_pointer_cast<SpawnNode>(node); spawn) {
+		mark(spawn->call, space);
+	} else if (auto await = std::dynamic_pointer_cast<AwaitNode>(node); await) {
+		mark(await->handle, space);
+	} else if (auto index = std::dynamic_pointer_cast<IndexNode>(node); index) {
+		mark(index->branch, space);
+		mark(index->index, space);
+	} else if (auto hoisted = std::dynamic_pointer_cast<HoistedNode>(node); hoisted) {
+		mark(hoisted->expr, space);
+	} else if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) {
+		mark(paren->expr, space);
+	}
+}
+
+void Pruner::sweep(std::vector<declaration>& nodes, const std::string& space) {
+	std::vector<declaration> kept;
+	for (auto& decl : nodes) {
+		if (auto inner = std::dynamic_pointer_cast<Namespace_decl>(decl); inner) {
+			sweep(inner->declarations, space + inner->name + "::");
+			if (inner->declarations.empty()) continue;
+		} else if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl); vars) {
+			std::erase_if(vars->vars, [&](auto& var) {
+				if (used.contains(space + var.first)) return false;
+				removed(decl->line, "variable " + space + var.first);
+				declCount++;
+				return true;
+			});
+			if (vars->vars.empty()) continue;
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl); array) {
+			std::erase_if(array->vars, [&](auto& var) {
+				if (used.contains(space + var.first)) return false;
+				removed(decl->line, "variable " + space + var.first);
+				declCount++;
+				return true;
+			});
+			if (array->vars.empty()) continue;
+		} else if (auto func = std::dynamic_pointer_cast<Functions_decl>(decl); func) {
+			if (!used.contains(space + func->name)) {
+				removed(decl->line, "function " + space + func->name);
+				declCount++;
+				continue;
+			}
+		} else if (auto external = std::dynamic_pointer_cast<Extern_decl>(decl); external) {
+			if (!used.contains(space + external->name)) {
+				removed(decl->line, "function " + space + external->name);
+				declCount++;
+				continue;
+			}
+		}
+		kept.push_back(decl);
+	}
+	nodes = std::move(kept);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+bool Pruner::constant(const statement& node, bool& value) const {
+	auto expr = std::dynamic_pointer_cast<Expression_statement>(node);
+	return expr && constant(expr->expr, value);
+}
+
+// literals and const globals initialized with one, looked up the way the
+// executor would; a local of the same name anywhere in the function hides
+// the global, so then the condition is not taken to be constant
+bool Pruner::constant(const expression& node, bool& value) const {
+	if (auto literal = std::dynamic_pointer_cast<BoolNode>(node); literal) {
+		value = literal->value;
+		return true;
+	}
+	if (auto literal = std::dynamic_pointer_cast<IntNode>(node); literal) {
+		value = literal->value != 0;
+		return true;
+	}
+	if (auto paren = std::dynamic_pointer_cast<ParenthesizedNode>(node); paren) return constant(paren->expr, value);
+	expression last;
+	auto name = qualified(node, last);
+	if (name.empty() || !std::dynamic_pointer_cast<IdentifierNode>(last)) return false;
+	if (name == std::static_pointer_cast<IdentifierNode>(last)->name && locals.contains(name)) return false;
+	auto scope = space;
+	do {
+		auto found = names.find(scope + name);
+		if (found == names.end()) continue;
+		if (found->second.size() != 1 || !std::dynamic_pointer_cast<ConstVariable>(found->second[0].decl)) return false;
+		for (auto& var : std::static_pointer_cast<ConstVariable>(found->second[0].decl)->vars) {
+			if (scope + var.first != found->first) continue;
+			if (!std::dynamic_pointer_cast<BoolNode>(var.second) && !std::dynamic_pointer_cast<IntNode>(var.second)) return false;
+			return constant(var.second, value);
+		}
+		return false;
+	} while (outer(scope));
+	return false;
+}
+
+// the names a function body declares, which hide globals of the same name
+void Pruner::declared(const statement& node) {
+	if (auto block = std::dynamic_pointer_cast<Block_statement>(node); block) {
+		for (auto& state : block->body) declared(state);
+	} else if (auto decl = std::dynamic_pointer_cast<Decl_statement>(node); decl) {
+		if (auto vars = std::dynamic_pointer_cast<Variables_decl>(decl->var); vars) {
+			for (auto& var : vars->vars) locals.insert(var.first);
+		} else if (auto array = std::dynamic_pointer_cast<Array_decl>(decl->var); array) {
+			for (auto& var : array->vars) locals.insert(var.first);
+		}
+	} else if (auto loop = std::dynamic_pointer_cast<While_statement>(node); loop) {
+		declared(loop->body);
+	} else if (auto loop = std::dynamic_pointer_cast<For_statement>(node); loop) {
+		if (loop->var) declared(loop->var);
+		declared(loop->body);
+	} else if (auto loop = std::dynamic_pointer_cast<ForEach_statement>(node); loop) {
+		locals.insert(loop->name);
+		declared(loop->body);
+	} else if (auto cases = std::dynamic_pointer_cast<Switch_statement>(node); cases) {
+		for (auto& state : cases->body) declared(state);
+	} else if (auto cond = std::dynamic_pointer_cast<ConditionalBlock>(node); cond) {
+		for (auto& branch : cond->branches) declared(branch);
+	} else if (auto branch = std::dynamic_pointer_cast<ConditionalBranches>(node); branch) {
+		declared(branch->body);
+	}
+}
+
+void Pruner::removed(std::size_t line, const std::string& text) {
+	if (stats) stats->note("removed", line, text);
+}
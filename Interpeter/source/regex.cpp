@@ -0,0 +1,557 @@
+#include "regex.hpp"
+#include "hashmap.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace regex {
+	// Parses a pattern into a tree and emits the NFA program from it. The
+	// whole pattern is wrapped in group 0: Save 0, body, Save 1, Match.
+	class Compiler {
+	public:
+		Compiler(Regex& re, std::string_view pattern) : re(re), pattern(pattern) {}
+
+		void compile() {
+			auto root = parse_alternation();
+			if (i < pattern.size()) fail("unmatched )");
+			emit({Regex::Instruction::Save, 0});
+			emit(*root);
+			emit({Regex::Instruction::Save, 1});
+			emit({Regex::Instruction::Match});
+		}
+
+	private:
+		struct Node {
+			enum Kind { Set, Concat, Alternate, Repeat, Group, Begin, End } kind;
+			// a repetition also keeps the range of groups inside it
+			int set = 0, min = 0, max = -1, group = 0, first = 0, last = 0;
+			bool greedy = true;
+			std::vector<std::unique_ptr<Node>> children;
+		};
+		using node = std::unique_ptr<Node>;
+
+		static constexpr std::size_t MAX_PROGRAM = 1 << 16;
+		static constexpr int MAX_REPEAT = 1000;
+
+		[[noreturn]] void fail(const std::string& what) {
+			throw std::runtime_error("invalid regular expression \"" + std::string(pattern) + "\": " + what);
+		}
+
+		static node make(Node::Kind kind) {
+			auto n = std::make_unique<Node>();
+			n->kind = kind;
+			return n;
+		}
+
+		bool more() const { return i < pattern.size(); }
+		char peek() const { return pattern[i]; }
+
+		node parse_alternation() {
+			auto first = parse_concat();
+			if (!more() || peek() != '|') return first;
+			auto n = make(Node::Alternate);
+			n->children.push_back(std::move(first));
+			while (more() && peek() == '|') {
+				i++;
+				n->children.push_back(parse_concat());
+			}
+			return n;
+		}
+
+		node parse_concat() {
+			auto n = make(Node::Concat);
+			while (more() && peek() != '|' && peek() != ')') {
+				n->children.push_back(parse_repeat());
+			}
+			return n;
+		}
+
+		node parse_repeat() {
+			int first = static_cast<int>(re.captures) + 1;
+			auto atom = parse_atom();
+			if (!more()) return atom;
+			int min, max;
+			switch (peek()) {
+				case '*': min = 0; max = -1; i++; break;
+				case '+': min = 1; max = -1; i++; break;
+				case '?': min = 0; max = 1; i++; break;
+				case '{': i++; parse_bounds(min, max); break;
+				default: return atom;
+			}
+			if (atom->kind == Node::Begin || atom->kind == Node::End) fail("nothing to repeat");
+			auto n = make(Node::Repeat);
+			n->min = min;
+			n->max = max;
+			n->first = first;
+			n->last = static_cast<int>(re.captures) + 1;
+			if (more() && peek() == '?') {
+				n->greedy = false;
+				i++;
+			}
+			if (more() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{')) fail("nothing to repeat");
+			n->children.push_back(std::move(atom));
+			return n;
+		}
+
+		int parse_number() {
+			if (!more() || peek() < '0' || peek() > '9') fail("invalid repetition count");
+			int value = 0;
+			while (more() && peek() >= '0' && peek() <= '9') {
+				value = value * 10 + (pattern[i++] - '0');
+				if (value > MAX_REPEAT) fail("repetition count is too large");
+			}
+			return value;
+		}
+
+		void parse_bounds(int& min, int& max) {
+			min = max = parse_number();
+			if (more() && peek() == ',') {
+				i++;
+				max = more() && peek() == '}' ? -1 : parse_number();
+			}
+			if (!more() || peek() != '}') fail("missing }");
+			i++;
+			if (max != -1 && max < min) fail("invalid repetition range");
+		}
+
+		node parse_atom() {
+			char c = pattern[i++];
+			switch (c) {
+				case '(': {
+					auto n = make(Node::Group);
+					if (pattern.substr(i).starts_with("?:")) {
+						i += 2;
+						n->group = -1;
+					} else if (more() && peek() == '?') {
+						fail("unsupported group");
+					} else {
+						n->group = static_cast<int>(++re.captures);
+					}
+					n->children.push_back(parse_alternation());
+					if (!more() || peek() != ')') fail("missing )");
+					i++;
+					return n;
+				}
+				case '[': return parse_class();
+				case '.': {
+					std::bitset<256> set;
+					set.set();
+					set.reset('\n');
+					set.reset('\r');
+					return make_set(set);
+				}
+				case '^': return make(Node::Begin);
+				case '$': return make(Node::End);
+				case '\\': {
+					std::bitset<256> set;
+					unsigned char single;
+					parse_escape(set, single);
+					return make_set(set);
+				}
+				case '*': case '+': case '?': case '{':
+					fail("nothing to repeat");
+				default: {
+					std::bitset<256> set;
+					set.set(static_cast<unsigned char>(c));
+					return make_set(set);
+				}
+			}
+		}
+
+		// Reads the escape after a backslash into set. Returns false when it
+		// was the single character c, which may then bound a range in a class.
+		bool parse_escape(std::bitset<256>& set, unsigned char& c) {
+			if (!more()) fail("trailing \\");
+			c = pattern[i++];
+			bool negate = c == 'D' || c == 'W' || c == 'S';
+			switch (c) {
+				case 'd': case 'D':
+					for (int k = '0'; k <= '9'; k++) set.set(k);
+					break;
+				case 'w': case 'W':
+					for (int k = 0; k < 256; k++) {
+						if ((k >= 'a' && k <= 'z') || (k >= 'A' && k <= 'Z') || (k >= '0' && k <= '9') || k == '_') set.set(k);
+					}
+					break;
+				case 's': case 'S':
+					for (char k : {' ', '\t', '\n', '\v', '\f', '\r'}) set.set(static_cast<unsigned char>(k));
+					break;
+				case 'n': c = '\n'; set.set(c); return false;
+				case 't': c = '\t'; set.set(c); return false;
+				case 'r': c = '\r'; set.set(c); return false;
+				case 'f': c = '\f'; set.set(c); return false;
+				case 'v': c = '\v'; set.set(c); return false;
+				case 'b': case 'B':
+					fail("word boundaries are not supported");
+				default:
+					if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) fail(std::string("unknown escape \\") + static_cast<char>(c));
+					set.set(c);
+					return false;
+			}
+			if (negate) set.flip();
+			return true;
+		}
+
+		node parse_class() {
+			std::bitset<256> set;
+			bool negate = more() && peek() == '^';
+			if (negate) i++;
+			while (true) {
+				if (!more()) fail("missing ]");
+				if (peek() == ']') break;
+				std::bitset<256> item;
+				bool multiple = false;
+				unsigned char low = pattern[i++];
+				if (low == '\\') multiple = parse_escape(item, low);
+				if (i + 1 < pattern.size() && peek() == '-' && pattern[i + 1] != ']') {
+					i++;
+					unsigned char high = pattern[i++];
+					if (high == '\\') {
+						std::bitset<256> bound;
+						if (parse_escape(bound, high)) fail("invalid range in class");
+					}
+					if (multiple || high < low) fail("invalid range in class");
+					for (int k = low; k <= high; k++) set.set(k);
+				} else if (multiple) {
+					set |= item;
+				} else {
+					set.set(low);
+				}
+			}
+			i++;
+			if (negate) set.flip();
+			return make_set(set);
+		}
+
+		node make_set(const std::bitset<256>& set) {
+			auto n = make(Node::Set);
+			for (std::size_t k = 0; k < re.classes.size(); k++) {
+				if (re.classes[k] == set) {
+					n->set = static_cast<int>(k);
+					return n;
+				}
+			}
+			n->set = static_cast<int>(re.classes.size());
+			re.classes.push_back(set);
+			return n;
+		}
+
+		std::size_t emit(Regex::Instruction instruction) {
+			if (re.program.size() == MAX_PROGRAM) fail("pattern is too large");
+			re.program.push_back(instruction);
+			return re.program.size() - 1;
+		}
+
+		int here() const { return static_cast<int>(re.program.size()); }
+
+		// a split that prefers x, or y when the repetition is lazy
+		void patch_split(std::size_t at, int body, int out, bool greedy) {
+			re.program[at].x = greedy ? body : out;
+			re.program[at].y = greedy ? out : body;
+		}
+
+		void emit(const Node& n) {
+			using I = Regex::Instruction;
+			switch (n.kind) {
+				case Node::Set:
+					emit({I::Byte, n.set});
+					break;
+				case Node::Concat:
+					for (auto& child : n.children) emit(*child);
+					break;
+				case Node::Alternate: {
+					std::vector<std::size_t> jumps;
+					for (std::size_t k = 0; k + 1 < n.children.size(); k++) {
+						auto split = emit({I::Split});
+						re.program[split].x = here();
+						emit(*n.children[k]);
+						jumps.push_back(emit({I::Jump}));
+						re.program[split].y = here();
+					}
+					emit(*n.children.back());
+					for (auto jump : jumps) re.program[jump].x = here();
+					break;
+				}
+				case Node::Group:
+					if (n.group >= 0) emit({I::Save, 2 * n.group});
+					emit(*n.children[0]);
+					if (n.group >= 0) emit({I::Save, 2 * n.group + 1});
+					break;
+				case Node::Repeat: {
+					// like ECMAScript, each iteration forgets the groups of the last one
+					auto body = [&] {
+						if (n.first < n.last) emit({I::Reset, 2 * n.first, 2 * n.last});
+						emit(*n.children[0]);
+					};
+					for (int k = 0; k < n.min; k++) body();
+					if (n.max == -1) {
+						auto split = emit({I::Split});
+						body();
+						emit({I::Jump, static_cast<int>(split)});
+						patch_split(split, static_cast<int>(split) + 1, here(), n.greedy);
+					} else {
+						std::vector<std::size_t> splits;
+						for (int k = n.min; k < n.max; k++) {
+							splits.push_back(emit({I::Split}));
+							body();
+						}
+						for (auto split : splits) patch_split(split, static_cast<int>(split) + 1, here(), n.greedy);
+					}
+					break;
+				}
+				case Node::Begin:
+					emit({I::Begin});
+					break;
+				case Node::End:
+					emit({I::End});
+					break;
+			}
+		}
+
+		Regex& re;
+		std::string_view pattern;
+		std::size_t i = 0;
+	};
+}
+
+using regex::Regex;
+
+// States are sets of NFA positions, each the closure over the empty moves
+// that do not depend on the position in the input. Transitions are filled
+// in as the input first takes them. A floating automaton restarts the
+// pattern at every position, which answers search instead of match.
+struct Regex::Dfa {
+	static constexpr std::size_t MAX_STATES = 4096;
+	static constexpr int UNKNOWN = -1, DEAD = 0;
+	enum : std::uint8_t { ACCEPTING = 1, ACCEPTING_AT_END = 2 };
+
+	explicit Dfa(bool floating) : floating(floating) {}
+
+	bool floating;
+	int start = UNKNOWN;
+	bool empty = false;
+	std::vector<int> next;
+	std::vector<std::vector<int>> sets;
+	std::vector<std::uint8_t> flags;
+	HashMap<std::string, int> index;
+	std::vector<std::size_t> marks;
+	std::size_t generation = 0;
+	std::size_t resets = 0;
+};
+
+// adds the positions reachable from pc without input to out
+void Regex::closure(Dfa& dfa, std::vector<int>& out, int pc, bool begin, bool end) const {
+	std::vector<int> stack{pc};
+	while (!stack.empty()) {
+		pc = stack.back();
+		stack.pop_back();
+		if (dfa.marks[pc] == dfa.generation) continue;
+		dfa.marks[pc] = dfa.generation;
+		auto& instruction = program[pc];
+		switch (instruction.op) {
+			case Instruction::Jump: stack.push_back(instruction.x); break;
+			case Instruction::Split: stack.push_back(instruction.y); stack.push_back(instruction.x); break;
+			case Instruction::Save: case Instruction::Reset: stack.push_back(pc + 1); break;
+			case Instruction::Begin: if (begin) stack.push_back(pc + 1); break;
+			case Instruction::End:
+				if (end) stack.push_back(pc + 1);
+				else out.push_back(pc);
+				break;
+			default: out.push_back(pc);
+		}
+	}
+}
+
+// drops every state, when starting out and when the cache is full
+void Regex::reset(Dfa& dfa) {
+	dfa.next.clear();
+	dfa.sets.clear();
+	dfa.flags.clear();
+	dfa.index = {};
+	dfa.marks.assign(program.size(), 0);
+	dfa.generation = 0;
+	dfa.resets++;
+	add_state(dfa, {});
+	dfa.generation++;
+	std::vector<int> start;
+	closure(dfa, start, 0, true, false);
+	dfa.start = add_state(dfa, std::move(start));
+	// the states assume they are past the start, which only an empty input is not
+	std::vector<int> empty;
+	dfa.generation++;
+	closure(dfa, empty, 0, true, true);
+	dfa.empty = std::find_if(empty.begin(), empty.end(), [this](int pc) { return program[pc].op == Instruction::Match; }) != empty.end();
+}
+
+int Regex::add_state(Dfa& dfa, std::vector<int> set) {
+	std::sort(set.begin(), set.end());
+	std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(int));
+	if (auto found = dfa.index.find(key); found) return *found;
+	if (dfa.sets.size() == Dfa::MAX_STATES) {
+		reset(dfa);
+		return add_state(dfa, std::move(set));
+	}
+	std::uint8_t flags = 0;
+	std::vector<int> atEnd;
+	dfa.generation++;
+	for (int pc : set) {
+		if (program[pc].op == Instruction::Match) flags |= Dfa::ACCEPTING | Dfa::ACCEPTING_AT_END;
+		if (program[pc].op == Instruction::End) closure(dfa, atEnd, pc + 1, false, true);
+	}
+	for (int pc : atEnd) {
+		if (program[pc].op == Instruction::Match) flags |= Dfa::ACCEPTING_AT_END;
+	}
+	int state = static_cast<int>(dfa.sets.size());
+	dfa.sets.push_back(std::move(set));
+	dfa.flags.push_back(flags);
+	dfa.next.resize(dfa.next.size() + 256, Dfa::UNKNOWN);
+	dfa.index[key] = state;
+	return state;
+}
+
+int Regex::step(Dfa& dfa, int state, unsigned char c) {
+	std::vector<int> set;
+	dfa.generation++;
+	for (int pc : dfa.sets[state]) {
+		if (program[pc].op == Instruction::Byte && classes[program[pc].x][c]) closure(dfa, set, pc + 1, false, false);
+	}
+	if (dfa.floating) closure(dfa, set, 0, false, false);
+	auto resets = dfa.resets;
+	int target = add_state(dfa, std::move(set));
+	// a reset renumbers the states, leaving nothing to record the move in
+	if (dfa.resets == resets) dfa.next[static_cast<std::size_t>(state) * 256 + c] = target;
+	return target;
+}
+
+Regex::Regex(std::string_view pattern) : source(pattern), anchored(std::make_unique<Dfa>(false)), floating(std::make_unique<Dfa>(true)) {
+	Compiler(*this, pattern).compile();
+	// the bytes a match can start with, or all of them if it can be empty
+	std::vector<bool> seen(program.size());
+	std::vector<int> stack{0};
+	while (!stack.empty()) {
+		int pc = stack.back();
+		stack.pop_back();
+		if (seen[pc]) continue;
+		seen[pc] = true;
+		auto& instruction = program[pc];
+		switch (instruction.op) {
+			case Instruction::Byte: starts |= classes[instruction.x]; break;
+			case Instruction::Match: starts.set(); break;
+			case Instruction::Split: stack.push_back(instruction.y); stack.push_back(instruction.x); break;
+			case Instruction::Jump: stack.push_back(instruction.x); break;
+			default: stack.push_back(pc + 1);
+		}
+	}
+}
+
+Regex::~Regex() = default;
+
+bool Regex::run(Dfa& dfa, std::string_view s) {
+	if (dfa.start == Dfa::UNKNOWN) reset(dfa);
+	if (s.empty()) return dfa.empty;
+	int state = dfa.start;
+	for (unsigned char c : s) {
+		if (dfa.floating && (dfa.flags[state] & Dfa::ACCEPTING)) return true;
+		int target = dfa.next[static_cast<std::size_t>(state) * 256 + c];
+		state = target == Dfa::UNKNOWN ? step(dfa, state, c) : target;
+		if (state == Dfa::DEAD) return false;
+	}
+	return dfa.flags[state] & Dfa::ACCEPTING_AT_END;
+}
+
+bool Regex::match(std::string_view s) {
+	return run(*anchored, s);
+}
+
+bool Regex::search(std::string_view s) {
+	return run(*floating, s);
+}
+
+bool Regex::match(std::string_view s, std::vector<std::string>& groups) {
+	groups.clear();
+	return match(s) && simulate(s, true, groups);
+}
+
+bool Regex::search(std::string_view s, std::vector<std::string>& groups) {
+	groups.clear();
+	return search(s) && simulate(s, false, groups);
+}
+
+// Pike VM: the thread list is kept in priority order, so the first thread
+// to reach Match is the leftmost-first match and the ones after it can be
+// dropped.
+bool Regex::simulate(std::string_view s, bool anchored, std::vector<std::string>& groups) {
+	constexpr std::size_t none = -1;
+	const std::size_t width = 2 * (captures + 1);
+	current.pcs.clear();
+	current.slab.clear();
+	marks.assign(program.size(), none);
+	caps.assign(width, none);
+	std::vector<std::size_t> matched;
+
+	auto add = [&](auto& self, Threads& list, int pc, std::size_t sp) -> void {
+		if (marks[pc] == sp) return;
+		marks[pc] = sp;
+		auto& instruction = program[pc];
+		switch (instruction.op) {
+			case Instruction::Jump: self(self, list, instruction.x, sp); break;
+			case Instruction::Split: self(self, list, instruction.x, sp); self(self, list, instruction.y, sp); break;
+			case Instruction::Save: {
+				auto saved = caps[instruction.x];
+				caps[instruction.x] = sp;
+				self(self, list, pc + 1, sp);
+				caps[instruction.x] = saved;
+				break;
+			}
+			case Instruction::Reset: {
+				std::vector<std::size_t> saved(caps.begin() + instruction.x, caps.begin() + instruction.y);
+				std::fill(caps.begin() + instruction.x, caps.begin() + instruction.y, none);
+				self(self, list, pc + 1, sp);
+				std::copy(saved.begin(), saved.end(), caps.begin() + instruction.x);
+				break;
+			}
+			case Instruction::Begin: if (sp == 0) self(self, list, pc + 1, sp); break;
+			case Instruction::End: if (sp == s.size()) self(self, list, pc + 1, sp); break;
+			default:
+				list.pcs.push_back(pc);
+				list.slab.insert(list.slab.end(), caps.begin(), caps.end());
+		}
+	};
+
+	for (std::size_t sp = 0;; sp++) {
+		if (matched.empty() && (!anchored || sp == 0)) {
+			// with no thread alive, go straight to a byte a match can start with
+			if (!anchored && current.pcs.empty()) {
+				while (sp < s.size() && !starts[static_cast<unsigned char>(s[sp])]) sp++;
+			}
+			std::fill(caps.begin(), caps.end(), none);
+			add(add, current, 0, sp);
+		}
+		if (current.pcs.empty() && (anchored || !matched.empty())) break;
+		next.pcs.clear();
+		next.slab.clear();
+		for (std::size_t k = 0; k < current.pcs.size(); k++) {
+			auto& instruction = program[current.pcs[k]];
+			auto thread = current.slab.begin() + k * width;
+			if (instruction.op == Instruction::Match) {
+				if (anchored && sp != s.size()) continue;
+				matched.assign(thread, thread + width);
+				break;
+			}
+			if (sp < s.size() && classes[instruction.x][static_cast<unsigned char>(s[sp])]) {
+				std::copy(thread, thread + width, caps.begin());
+				add(add, next, current.pcs[k] + 1, sp + 1);
+			}
+		}
+		std::swap(current, next);
+		if (sp >= s.size()) break;
+	}
+	if (matched.empty()) return false;
+	for (std::size_t g = 0; g <= captures; g++) {
+		auto begin = matched[2 * g], end = matched[2 * g + 1];
+		groups.push_back(begin == none || end == none ? std::string() : std::string(s.substr(begin, end - begin)));
+	}
+	return true;
+}
@@ -0,0 +1,131 @@
+#include "sorting.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+namespace {
+	// NaNs order after every number, so a double array is still a strict
+	// weak ordering for the standard algorithms
+	struct Less {
+		template <typename T>
+		bool operator()(const T& a, const T& b) const {
+			return a < b;
+		}
+
+		bool operator()(double a, double b) const {
+			return a < b || (b != b && a == a);
+		}
+	};
+
+	// Number of elements taken from a when the merge of a and b has produced
+	// k elements, with ties taken from a first.
+	template <typename It>
+	std::size_t co_rank(std::size_t k, It a, std::size_t na, It b, std::size_t nb) {
+		std::size_t lo = k > nb ? k - nb : 0, hi = std::min(k, na);
+		while (lo < hi) {
+			std::size_t i = lo + (hi - lo) / 2, j = k - i;
+			if (!Less()(b[j - 1], a[i])) lo = i + 1;
+			else hi = i;
+		}
+		return lo;
+	}
+
+	template <typename It, typename Out>
+	void parallel_merge(It a, std::size_t na, It b, std::size_t nb, Out out) {
+		std::size_t n = na + nb, chunks = parallel_chunks(n, sorting::SORT_THRESHOLD);
+		// every split is found before any slice starts moving elements out
+		std::vector<std::size_t> splits;
+		for (std::size_t i = 0; i <= chunks; i++) {
+			splits.push_back(co_rank(n * i / chunks, a, na, b, nb));
+		}
+		parallel_for(n, chunks, [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+			std::size_t i = splits[chunk], k = splits[chunk + 1];
+			std::merge(std::make_move_iterator(a + i), std::make_move_iterator(a + k),
+				std::make_move_iterator(b + (begin - i)), std::make_move_iterator(b + (end - k)), out + begin, Less());
+		});
+	}
+
+	// Sorts one run per thread with sort_run, then merges neighbouring runs
+	// until one is left. Merging keeps the left run's elements first, so the
+	// result is stable whenever sort_run is.
+	template <typename T, typename SortRun>
+	void merge_sort(std::vector<T>& v, SortRun sort_run) {
+		std::size_t n = v.size(), chunks = parallel_chunks(n, sorting::SORT_THRESHOLD);
+		if (chunks <= 1) {
+			sort_run(v.begin(), v.end());
+			return;
+		}
+		std::vector<std::size_t> bounds;
+		for (std::size_t i = 0; i <= chunks; i++) {
+			bounds.push_back(n * i / chunks);
+		}
+		parallel_for(n, chunks, [&](std::size_t begin, std::size_t end, std::size_t) {
+			sort_run(v.begin() + begin, v.begin() + end);
+		});
+
+		std::vector<T> buffer(n);
+		auto* from = &v;
+		auto* to = &buffer;
+		while (bounds.size() > 2) {
+			std::vector<std::size_t> merged;
+			std::size_t i = 0;
+			for (; i + 2 < bounds.size(); i += 2) {
+				merged.push_back(bounds[i]);
+				parallel_merge(from->begin() + bounds[i], bounds[i + 1] - bounds[i],
+					from->begin() + bounds[i + 1], bounds[i + 2] - bounds[i + 1], to->begin() + bounds[i]);
+			}
+			if (i + 1 < bounds.size()) {
+				merged.push_back(bounds[i]);
+				std::move(from->begin() + bounds[i], from->begin() + bounds[i + 1], to->begin() + bounds[i]);
+			}
+			merged.push_back(n);
+			bounds = std::move(merged);
+			std::swap(from, to);
+		}
+		if (from != &v) {
+			v = std::move(*from);
+		}
+	}
+}
+
+template <typename T>
+void sorting::sort(std::vector<T>& v) {
+	merge_sort(v, [](auto begin, auto end) { std::sort(begin, end, Less()); });
+}
+
+template <typename T>
+void sorting::stable_sort(std::vector<T>& v) {
+	merge_sort(v, [](auto begin, auto end) { std::stable_sort(begin, end, Less()); });
+}
+
+template <typename T>
+void sorting::partial_sort(std::vector<T>& v, std::size_t k) {
+	if (k >= v.size()) sort(v);
+	else std::partial_sort(v.begin(), v.begin() + k, v.end(), Less());
+}
+
+template <typename T>
+std::size_t sorting::lower_bound(const std::vector<T>& v, const T& value) {
+	return std::lower_bound(v.begin(), v.end(), value, Less()) - v.begin();
+}
+
+template <typename T>
+bool sorting::binary_search(const std::vector<T>& v, const T& value) {
+	return std::binary_search(v.begin(), v.end(), value, Less());
+}
+
+#define INSTANTIATE(T) \
+	template void sorting::sort(std::vector<T>&); \
+	template void sorting::stable_sort(std::vector<T>&); \
+	template void sorting::partial_sort(std::vector<T>&, std::size_t); \
+	template std::size_t sorting::lower_bound(const std::vector<T>&, const T&); \
+	template bool sorting::binary_search(const std::vector<T>&, const T&);
+
+INSTANTIATE(int)
+INSTANTIATE(double)
+INSTANTIATE(char)
+INSTANTIATE(unsigned char)
+INSTANTIATE(std::string)
+#undef INSTANTIATE
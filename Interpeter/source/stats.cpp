@@ -0,0 +1,114 @@
+#include "stats.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <sys/resource.h>
+
+static std::atomic<std::size_t> allocation_count{0};
+static std::atomic<std::size_t> allocation_bytes{0};
+
+static double clock_ms(clockid_t clock) {
+	timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+Stats::Phase::Phase(Stats* stats, const std::string& name) : stats(stats) {
+	if (!stats) return;
+	phase.name = name;
+	rss_start = peak_rss_kb();
+	allocations_start = allocations();
+	bytes_start = allocated_bytes();
+	cpu_start = clock_ms(CLOCK_PROCESS_CPUTIME_ID);
+	wall_start = clock_ms(CLOCK_MONOTONIC);
+}
+
+Stats::Phase::~Phase() {
+	if (!stats) return;
+	phase.wall_ms = clock_ms(CLOCK_MONOTONIC) - wall_start;
+	phase.cpu_ms = clock_ms(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+	phase.allocations = allocations() - allocations_start;
+	phase.allocated_bytes = allocated_bytes() - bytes_start;
+	phase.peak_rss_delta_kb = peak_rss_kb() - rss_start;
+	stats->phases.push_back(phase);
+}
+
+void Stats::count(const std::string& name, std::size_t value) {
+	counters.push_back(std::make_pair(name, value));
+}
+
+void Stats::note(const std::string& kind, std::size_t line, const std::string& text) {
+	notes.push_back(Note{kind, line, text});
+}
+
+static std::string quoted(const std::string& text) {
+	std::string s = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') s += '\\';
+		if (c == '\n') s += "\\n";
+		else s += c;
+	}
+	return s + "\"";
+}
+
+void Stats::report(std::ostream& out, bool json) const {
+	char line[160];
+	if (json) {
+		out << "{\"phases\": [";
+		for (std::size_t i = 0; i < phases.size(); i++) {
+			auto& p = phases[i];
+			std::snprintf(line, sizeof(line), "\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_delta_kb\": %ld, ", p.wall_ms, p.cpu_ms, p.peak_rss_delta_kb);
+			out << (i ? ", " : "") << "{\"name\": \"" << p.name << "\", " << line
+				<< "\"allocations\": " << p.allocations << ", \"allocated_bytes\": " << p.allocated_bytes << "}";
+		}
+		out << "], \"counts\": {";
+		for (std::size_t i = 0; i < counters.size(); i++) {
+			out << (i ? ", " : "") << "\"" << counters[i].first << "\": " << counters[i].second;
+		}
+		out << "}, \"notes\": [";
+		for (std::size_t i = 0; i < notes.size(); i++) {
+			out << (i ? ", " : "") << "{\"kind\": " << quoted(notes[i].kind) << ", \"line\": " << notes[i].line << ", \"text\": " << quoted(notes[i].text) << "}";
+		}
+		out << "], \"peak_rss_kb\": " << peak_rss_kb() << "}" << std::endl;
+		return;
+	}
+
+	std::snprintf(line, sizeof(line), "%-10s %12s %12s %14s %12s %14s\n", "phase", "wall ms", "cpu ms", "peak rss +KB", "allocs", "bytes");
+	out << line;
+	for (auto& p : phases) {
+		std::snprintf(line, sizeof(line), "%-10s %12.3f %12.3f %14ld %12zu %14zu\n", p.name.c_str(), p.wall_ms, p.cpu_ms, p.peak_rss_delta_kb, p.allocations, p.allocated_bytes);
+		out << line;
+	}
+	for (auto& counter : counters) {
+		std::snprintf(line, sizeof(line), "%-10s %12zu\n", counter.first.c_str(), counter.second);
+		out << line;
+	}
+	for (auto& note : notes) {
+		std::snprintf(line, sizeof(line), "%-10s line %zu: ", note.kind.c_str(), note.line);
+		out << line << note.text << "\n";
+	}
+	std::snprintf(line, sizeof(line), "%-10s %12ld KB\n", "peak rss", peak_rss_kb());
+	out << line;
+}
+
+void Stats::counted(std::size_t bytes) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocation_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+std::size_t Stats::allocations() {
+	return allocation_count.load(std::memory_order_relaxed);
+}
+
+std::size_t Stats::allocated_bytes() {
+	return allocation_bytes.load(std::memory_order_relaxed);
+}
+
+long Stats::peak_rss_kb() {
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
@@ -0,0 +1,140 @@
+#include "strings.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// the needle's first and last bytes are known to match at s + i
+	bool matches_at(const char* s, std::size_t i, std::string_view needle) {
+		return needle.size() <= 2 || !std::memcmp(s + i + 1, needle.data() + 1, needle.size() - 2);
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	// Positions are tested a block at a time: a candidate must match the
+	// needle's first byte at its own offset and the last byte at offset
+	// size - 1, which rules out almost every position in ordinary text.
+	std::size_t find_sse2(const char* s, std::size_t n, std::string_view needle, std::size_t& stop) {
+		std::size_t k = needle.size(), i = 0;
+		const __m128i first = _mm_set1_epi8(needle.front()), last = _mm_set1_epi8(needle.back());
+		for (; i + k - 1 + 16 <= n; i += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k - 1));
+			unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+			for (; mask; mask &= mask - 1) {
+				std::size_t j = i + __builtin_ctz(mask);
+				if (matches_at(s, j, needle)) return j;
+			}
+		}
+		stop = i;
+		return strings::npos;
+	}
+
+	__attribute__((target("avx2")))
+	std::size_t find_avx2(const char* s, std::size_t n, std::string_view needle, std::size_t& stop) {
+		std::size_t k = needle.size(), i = 0;
+		const __m256i first = _mm256_set1_epi8(needle.front()), last = _mm256_set1_epi8(needle.back());
+		for (; i + k - 1 + 32 <= n; i += 32) {
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + k - 1));
+			unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+			for (; mask; mask &= mask - 1) {
+				std::size_t j = i + __builtin_ctz(mask);
+				if (matches_at(s, j, needle)) return j;
+			}
+		}
+		stop = i;
+		return strings::npos;
+	}
+
+	bool avx2() {
+		static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+		return supported;
+	}
+#endif
+
+	// Searches s[0, n) a block at a time. Returns the first match, or npos
+	// with stop set to where the blocks ended.
+	std::size_t find_blocks(const char* s, std::size_t n, std::string_view needle, std::size_t& stop) {
+#if defined(__x86_64__) || defined(__i386__)
+		return avx2() ? find_avx2(s, n, needle, stop) : find_sse2(s, n, needle, stop);
+#else
+		stop = 0;
+		return strings::npos;
+#endif
+	}
+}
+
+std::size_t strings::find(std::string_view haystack, std::string_view needle, std::size_t from) {
+	if (from > haystack.size()) return npos;
+	if (needle.empty()) return from;
+	if (needle.size() > haystack.size() - from) return npos;
+	const char* s = haystack.data() + from;
+	std::size_t n = haystack.size() - from, stop = 0;
+	if (needle.size() == 1) {
+		auto p = static_cast<const char*>(std::memchr(s, needle.front(), n));
+		return p ? from + (p - s) : npos;
+	}
+	auto i = find_blocks(s, n, needle, stop);
+	// the tail too short to fill a block
+	if (i == npos) i = std::string_view(s, n).find(needle, stop);
+	return i == npos ? npos : from + i;
+}
+
+std::size_t strings::count(std::string_view haystack, std::string_view needle) {
+	if (needle.empty()) return 0;
+	std::size_t n = 0;
+	for (auto i = find(haystack, needle); i != npos; i = find(haystack, needle, i + needle.size())) n++;
+	return n;
+}
+
+std::string strings::replace(std::string_view s, std::string_view from, std::string_view to) {
+	if (from.empty()) return std::string(s);
+	std::string result;
+	std::size_t last = 0;
+	for (auto i = find(s, from); i != npos; i = find(s, from, last)) {
+		if (result.empty()) result.reserve(s.size());
+		result.append(s.data() + last, i - last);
+		result.append(to);
+		last = i + from.size();
+	}
+	result.append(s.data() + last, s.size() - last);
+	return result;
+}
+
+std::vector<std::string> strings::split(std::string_view s, std::string_view separator) {
+	std::vector<std::string> parts;
+	if (separator.empty()) {
+		parts.emplace_back(s);
+		return parts;
+	}
+	std::size_t last = 0;
+	for (auto i = find(s, separator); i != npos; i = find(s, separator, last)) {
+		parts.emplace_back(s.substr(last, i - last));
+		last = i + separator.size();
+	}
+	parts.emplace_back(s.substr(last));
+	return parts;
+}
+
+bool strings::equal(std::string_view a, std::string_view b) {
+	return a.size() == b.size() && !std::memcmp(a.data(), b.data(), a.size());
+}
+
+bool strings::starts_with(std::string_view s, std::string_view prefix) {
+	return s.size() >= prefix.size() && !std::memcmp(s.data(), prefix.data(), prefix.size());
+}
+
+bool strings::ends_with(std::string_view s, std::string_view suffix) {
+	return s.size() >= suffix.size() && !std::memcmp(s.data() + s.size() - suffix.size(), suffix.data(), suffix.size());
+}
+
+const char* strings::isa() {
+#if defined(__x86_64__) || defined(__i386__)
+	return avx2() ? "avx2" : "sse2";
+#else
+	return "generic";
+#endif
+}
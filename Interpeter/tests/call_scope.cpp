@@ -0,0 +1,16 @@
+int x = 1;
+int get() {
+	return x;
+}
+namespace A {
+	int twice(int n) {
+		return n * 2;
+	}
+}
+int main() {
+	int x = 2;
+	print(get());
+	int local = 21;
+	print(A::twice(local));
+	return 0;
+}
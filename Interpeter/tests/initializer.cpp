@@ -0,0 +1,18 @@
+int main() {
+	int x = 5;
+	int y = x;
+	double d = 2.5;
+	double e = d;
+	char c = 'q';
+	char k = c;
+	bool b = true;
+	bool t = b;
+	string s = "text";
+	string u = s;
+	print(y);
+	print(e);
+	print(k);
+	print(t);
+	print(u);
+	return 0;
+}
@@ -0,0 +1,11 @@
+int main() {
+	int a = 1;
+	int b = 0;
+	print(a > 0 && b > 0);
+	print(a > 0 || b > 0);
+	print(a < 0 || b < 0);
+	if (a == 1 && b == 0) {
+		print(1);
+	}
+	return 0;
+}
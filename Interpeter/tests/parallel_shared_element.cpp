@@ -0,0 +1,8 @@
+int main() {
+	int a[4];
+	parallel for (int i = 0; i < 400000; i++) {
+		a[0] = a[0] + 1;
+	}
+	print(a[0]);
+	return 0;
+}
@@ -0,0 +1,7 @@
+int main() {
+	int a[1];
+	a[0] = 7;
+	a[0] = pop(a);
+	print(len(a));
+	return 0;
+}
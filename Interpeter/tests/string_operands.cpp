@@ -0,0 +1,10 @@
+int main() {
+	string s = "ab";
+	string t = "cd";
+	string u = s + t;
+	print(u);
+	s += t;
+	print(s);
+	print(t);
+	return 0;
+}